@@ -1,6 +1,7 @@
 #include "StdInc.h"
 #include "../../lib/AI_Base.h"
 #include "BattleAI.h"
+#include "BattleSimulation.h"
 #include "../../lib/BattleState.h"
 #include "../../CCallback.h"
 #include "../../lib/CCreatureHandler.h"
@@ -147,7 +148,7 @@ BattleAction CBattleAI::activeStack( const CStack * stack )
 
 		if(targets.possibleAttacks.size())
 		{
-			auto hlp = targets.bestAction();
+			auto hlp = targets.bestSimulatedAction(BattleSimulation(cb.get()));
 			if(hlp.attack.shooting)
 				return BattleAction::makeShotAttack(stack, hlp.enemy);
 			else
@@ -723,6 +724,34 @@ AttackPossibility PotentialTargets::bestAction() const
 	return *vstd::maxElementByFun(possibleAttacks, [](const AttackPossibility &ap) { return ap.attackValue(); } );
 }
 
+AttackPossibility PotentialTargets::bestSimulatedAction(const BattleSimulation &simulation) const
+{
+	//simulation covers all attacks and counterattacks, retaliations left and real path length for charge
+	const AttackPossibility *best = nullptr;
+	si64 bestValue = 0;
+	for(auto &ap : possibleAttacks)
+	{
+		const CStack *attacker = ap.attack.attacker;
+		BattleSimulation afterAttack = simulation;
+		const auto action = ap.attack.shooting
+			? BattleAction::makeShotAttack(attacker, ap.enemy)
+			: BattleAction::makeMeleeAttack(attacker, ap.enemy, ap.tile);
+		if(!afterAttack.applyAction(action))
+			continue;
+
+		const si64 value = afterAttack.healthBalance(attacker->attackerOwned) + ap.tacticImpact;
+		if(!best || value > bestValue)
+		{
+			best = &ap;
+			bestValue = value;
+		}
+	}
+
+	if(!best)
+		return bestAction();
+	return *best;
+}
+
 int PotentialTargets::bestActionValue() const
 {
 	if(possibleAttacks.empty())
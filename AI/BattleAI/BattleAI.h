@@ -5,6 +5,7 @@
 #include "../../lib/CBattleCallback.h"
 
 class CSpell;
+class BattleSimulation;
 
 
 class StackWithBonuses : public IBonusBearer
@@ -104,6 +105,7 @@ struct PotentialTargets
 	PotentialTargets(const CStack *attacker, const HypotheticChangesToBattleState &state = HypotheticChangesToBattleState());
 
 	AttackPossibility bestAction() const;
+	AttackPossibility bestSimulatedAction(const BattleSimulation &simulation) const; //attack that gives best health balance when applied to copy of simulation
 	int bestActionValue() const;
 };
 
@@ -0,0 +1,298 @@
+#include "StdInc.h"
+#include "BattleSimulation.h"
+
+#include "../../lib/BattleState.h"
+#include "../../lib/BattleAction.h"
+
+/*
+ * BattleSimulation.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+SimulatedStack::SimulatedStack(const CStack *Stack)
+	: stack(Stack), ID(Stack->ID), attackerOwned(Stack->attackerOwned), doubleWide(Stack->doubleWide()),
+	position(Stack->position), count(Stack->count), firstHPleft(Stack->firstHPleft), maxHealth(0),
+	counterAttacks(Stack->counterAttacks), shots(Stack->shots),
+	moved(Stack->moved()), waited(Stack->waited()), defending(vstd::contains(Stack->state, EBattleStackState::DEFENDING))
+{
+	//defensive stance is given by server as these two bonuses, simulation adds them depending on defending flag
+	auto isDefensiveStance = [](const Bonus *b)
+	{
+		return b->duration == Bonus::STACK_GETS_TURN && b->source == Bonus::OTHER
+			&& b->type == Bonus::PRIMARY_SKILL && b->subtype == PrimarySkill::DEFENSE;
+	};
+
+	auto flat = make_shared<FlatBonuses>();
+	auto allBonuses = static_cast<const IBonusBearer *>(Stack)->getAllBonuses(); //all bonuses, including melee/ranged only
+	flat->bonuses.reserve(allBonuses->size() + 2);
+	for(const Bonus *b : *allBonuses)
+		if(!isDefensiveStance(b))
+			flat->bonuses.push_back(*b);
+	const size_t baseBonuses = flat->bonuses.size();
+
+	flat->bonuses.push_back(Bonus(Bonus::STACK_GETS_TURN, Bonus::PRIMARY_SKILL, Bonus::OTHER, 20, -1, PrimarySkill::DEFENSE, Bonus::PERCENT_TO_ALL));
+	flat->bonuses.push_back(Bonus(Bonus::STACK_GETS_TURN, Bonus::PRIMARY_SKILL, Bonus::OTHER, Stack->valOfBonuses(Bonus::DEFENSIVE_STANCE),
+		-1, PrimarySkill::DEFENSE, Bonus::ADDITIVE_VALUE));
+
+	for(size_t i = 0; i < flat->bonuses.size(); i++)
+	{
+		if(i < baseBonuses)
+			flat->list.push_back(&flat->bonuses[i]);
+		flat->defendingList.push_back(&flat->bonuses[i]);
+	}
+	flatBonuses = flat;
+
+	maxHealth = MaxHealth();
+}
+
+const TBonusListPtr SimulatedStack::getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root /*= nullptr*/, const std::string &cachingStr /*= ""*/) const
+{
+	TBonusListPtr ret = make_shared<BonusList>();
+	(defending ? flatBonuses->defendingList : flatBonuses->list).getBonuses(*ret, selector, limit);
+	return ret;
+}
+
+bool SimulatedStack::alive() const
+{
+	return count > 0;
+}
+
+bool SimulatedStack::ableToRetaliate() const
+{
+	return alive()
+		&& (counterAttacks > 0 || hasBonusOfType(Bonus::UNLIMITED_RETALIATIONS))
+		&& !hasBonusOfType(Bonus::SIEGE_WEAPON)
+		&& !hasBonusOfType(Bonus::HYPNOTIZED)
+		&& !hasBonusOfType(Bonus::NO_RETALIATION);
+}
+
+BattleHex SimulatedStack::occupiedHex() const
+{
+	if(!doubleWide)
+		return BattleHex::INVALID;
+	return attackerOwned ? position - 1 : position + 1;
+}
+
+bool SimulatedStack::coversPos(BattleHex hex) const
+{
+	return position == hex || (doubleWide && occupiedHex() == hex);
+}
+
+ui32 SimulatedStack::totalHealth() const
+{
+	if(!count)
+		return 0;
+	return (count - 1) * maxHealth + firstHPleft;
+}
+
+void SimulatedStack::takeDamage(ui32 damage)
+{
+	const ui32 health = totalHealth();
+	if(damage >= health)
+	{
+		count = 0;
+		firstHPleft = 0;
+		return;
+	}
+
+	const ui32 healthLeft = health - damage;
+	count = (healthLeft + maxHealth - 1) / maxHealth;
+	firstHPleft = healthLeft - (count - 1) * maxHealth;
+}
+
+BattleSimulation::BattleSimulation(const CBattleInfoCallback *Cb)
+	: cb(Cb)
+{
+	for(const CStack *s : cb->battleGetAllStacks(true))
+		if(s->alive())
+			stacks.push_back(SimulatedStack(s));
+}
+
+SimulatedStack * BattleSimulation::getStack(ui32 ID)
+{
+	for(auto &s : stacks)
+		if(s.ID == ID)
+			return &s;
+	return nullptr;
+}
+
+const SimulatedStack * BattleSimulation::getStack(ui32 ID) const
+{
+	return const_cast<BattleSimulation *>(this)->getStack(ID);
+}
+
+const SimulatedStack * BattleSimulation::getStackByPos(BattleHex hex) const
+{
+	for(auto &s : stacks)
+		if(s.alive() && s.coversPos(hex))
+			return &s;
+	return nullptr;
+}
+
+TDmgRange BattleSimulation::calculateDmgRange(const SimulatedStack &attacker, const SimulatedStack &defender, bool shooting, int chargedFields /*= 0*/) const
+{
+	BattleAttackInfo bai(attacker.stack, defender.stack, shooting);
+	bai.attackerBonuses = &attacker;
+	bai.defenderBonuses = &defender;
+	bai.attackerPosition = attacker.position;
+	bai.defenderPosition = defender.position;
+	bai.attackerCount = attacker.count;
+	bai.defenderCount = defender.count;
+	bai.chargedFields = chargedFields;
+	return cb->calculateDmgRange(bai);
+}
+
+ReachabilityInfo BattleSimulation::getReachability(const SimulatedStack &stack) const
+{
+	AccessibilityInfo accessibility = cb->getAccesibility();
+
+	//move stacks from their real positions to simulated ones
+	for(const CStack *s : cb->battleAliveStacks())
+		for(BattleHex hex : s->getHexes())
+			if(hex.isAvailable() && accessibility[hex] == EAccessibility::ALIVE_STACK)
+				accessibility[hex] = EAccessibility::ACCESSIBLE;
+
+	for(auto &s : stacks)
+	{
+		if(!s.alive() || &s == &stack)
+			continue;
+		const BattleHex hexes[] = {s.position, s.occupiedHex()};
+		for(BattleHex hex : hexes)
+			if(hex.isAvailable())
+				accessibility[hex] = EAccessibility::ALIVE_STACK;
+	}
+
+	ReachabilityInfo::Parameters params(stack.stack);
+	params.startPosition = stack.position;
+	params.knownAccessible.clear();
+	return cb->getReachability(accessibility, params);
+}
+
+bool BattleSimulation::applyAction(const BattleAction &action)
+{
+	SimulatedStack *stack = getStack(action.stackNumber);
+	if(!stack || !stack->alive())
+		return false;
+
+	//stack gets turn, so its defensive stance ends
+	stack->defending = false;
+
+	//returns length of path to dest, or -1 if stack can't get there in this turn
+	auto pathLength = [&](BattleHex dest) -> int
+	{
+		if(dest == stack->position)
+			return 0;
+		const int distance = getReachability(*stack).distances[dest];
+		return distance <= static_cast<int>(stack->Speed()) ? distance : -1;
+	};
+
+	switch(action.actionType)
+	{
+	case Battle::WALK:
+		{
+			if(!action.destinationTile.isValid() || pathLength(action.destinationTile) < 0)
+				return false;
+			applyMove(*stack, action.destinationTile);
+		}
+		break;
+	case Battle::WALK_AND_ATTACK:
+		{
+			auto defender = const_cast<SimulatedStack *>(getStackByPos(action.additionalInfo));
+			if(!defender)
+				return false;
+
+			int chargedFields = 0;
+			if(action.destinationTile.isValid())
+			{
+				chargedFields = pathLength(action.destinationTile);
+				if(chargedFields < 0)
+					return false;
+				applyMove(*stack, action.destinationTile);
+			}
+			applyAttack(*stack, *defender, false, chargedFields);
+		}
+		break;
+	case Battle::SHOOT:
+		{
+			auto defender = const_cast<SimulatedStack *>(getStackByPos(action.destinationTile));
+			if(!defender)
+				return false;
+			applyAttack(*stack, *defender, true);
+		}
+		break;
+	case Battle::DEFEND:
+		stack->defending = true;
+		break;
+	case Battle::WAIT:
+		stack->waited = true;
+		return true;
+	default:
+		return false;
+	}
+
+	stack->moved = true;
+	return true;
+}
+
+void BattleSimulation::applyMove(SimulatedStack &stack, BattleHex dest)
+{
+	stack.position = dest;
+}
+
+void BattleSimulation::applyAttack(SimulatedStack &attacker, SimulatedStack &defender, bool shooting, int chargedFields /*= 0*/)
+{
+	auto limitMatches = shooting
+		? Selector::effectRange(Bonus::ONLY_DISTANCE_FIGHT)
+		: Selector::effectRange(Bonus::ONLY_MELEE_FIGHT);
+	const int totalAttacks = 1 + attacker.getBonuses(Selector::type(Bonus::ADDITIONAL_ATTACK), Selector::effectRange(Bonus::NO_LIMIT).Or(limitMatches))->totalValue();
+	const bool retaliationBlocked = shooting || attacker.hasBonusOfType(Bonus::BLOCKS_RETALIATION);
+
+	for(int i = 0; i < totalAttacks && attacker.alive() && defender.alive(); i++)
+	{
+		if(shooting)
+		{
+			if(attacker.shots <= 0)
+				break;
+			attacker.shots--;
+		}
+
+		auto dmg = calculateDmgRange(attacker, defender, shooting, chargedFields);
+		defender.takeDamage((dmg.first + dmg.second) / 2);
+
+		if(!retaliationBlocked && defender.ableToRetaliate())
+		{
+			auto retaliation = calculateDmgRange(defender, attacker, false);
+			attacker.takeDamage((retaliation.first + retaliation.second) / 2);
+			if(defender.counterAttacks > 0)
+				defender.counterAttacks--;
+		}
+	}
+}
+
+void BattleSimulation::nextRound()
+{
+	for(auto &s : stacks)
+	{
+		s.counterAttacks = 1 + s.valOfBonuses(Bonus::ADDITIONAL_RETALIATION);
+		s.moved = s.waited = false;
+	}
+}
+
+ui64 BattleSimulation::totalHealth(bool attackerSide) const
+{
+	ui64 ret = 0;
+	for(auto &s : stacks)
+		if(s.attackerOwned == attackerSide)
+			ret += s.totalHealth();
+	return ret;
+}
+
+si64 BattleSimulation::healthBalance(bool attackerSide) const
+{
+	return static_cast<si64>(totalHealth(attackerSide)) - static_cast<si64>(totalHealth(!attackerSide));
+}
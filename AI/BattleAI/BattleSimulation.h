@@ -0,0 +1,90 @@
+#pragma once
+
+#include "../../lib/BattleHex.h"
+#include "../../lib/HeroBonus.h"
+#include "../../lib/CBattleCallback.h"
+
+/*
+ * BattleSimulation.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+class CStack;
+struct BattleAction;
+
+/// State of stack in simulated battle. Bonuses of real stack are flattened once on creation and shared
+/// between copies, so copying is cheap and simulation never touches bonus system of real battle.
+class SimulatedStack : public IBonusBearer
+{
+public:
+	const CStack *stack; //real stack, used only for immutable data (creature type, owner)
+	ui32 ID;
+	bool attackerOwned;
+	bool doubleWide;
+
+	BattleHex position;
+	TQuantity count;
+	ui32 firstHPleft; //HP of first creature in stack
+	ui32 maxHealth; //cached MaxHealth()
+	ui8 counterAttacks; //retaliations left in this round
+	si16 shots;
+
+	bool moved, waited;
+	bool defending; //defensive stance bonuses apply until stack gets its next turn
+
+	SimulatedStack(const CStack *Stack);
+
+	const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const std::string &cachingStr = "") const override;
+
+	bool alive() const;
+	bool ableToRetaliate() const;
+	BattleHex occupiedHex() const; //second hex of double wide stack, invalid otherwise
+	bool coversPos(BattleHex hex) const;
+
+	ui32 totalHealth() const;
+	void takeDamage(ui32 damage);
+
+private:
+	struct FlatBonuses
+	{
+		std::vector<Bonus> bonuses; //bonuses of real stack without defensive stance, followed by defensive stance bonuses
+		BonusList list; //points into bonuses
+		BonusList defendingList; //list with defensive stance bonuses
+	};
+	shared_ptr<const FlatBonuses> flatBonuses;
+};
+
+/// Copyable snapshot of battle for AI lookahead. Stores only state changed by stack actions, that is stacks.
+/// Terrain, obstacles, walls, heroes and siege penalties are read from the callback.
+/// Damage is calculated by CBattleInfoCallback::calculateDmgRange, with simulated stacks as bonus bearers.
+class BattleSimulation
+{
+public:
+	std::vector<SimulatedStack> stacks;
+
+	BattleSimulation(const CBattleInfoCallback *Cb); //takes snapshot of current battle
+
+	SimulatedStack * getStack(ui32 ID);
+	const SimulatedStack * getStack(ui32 ID) const;
+	const SimulatedStack * getStackByPos(BattleHex hex) const; //only alive stacks
+
+	TDmgRange calculateDmgRange(const SimulatedStack &attacker, const SimulatedStack &defender, bool shooting, int chargedFields = 0) const;
+	ReachabilityInfo getReachability(const SimulatedStack &stack) const; //obstacles and walls of real battle, stacks on simulated positions
+
+	//damage is always averaged
+	bool applyAction(const BattleAction &action); //returns false if action is not supported (spells, retreat...) or stack can't reach destination
+	void applyMove(SimulatedStack &stack, BattleHex dest);
+	void applyAttack(SimulatedStack &attacker, SimulatedStack &defender, bool shooting, int chargedFields = 0);
+	void nextRound(); //restores retaliations and clears movement flags
+
+	ui64 totalHealth(bool attackerSide) const; //summary health of all alive stacks of given side
+	si64 healthBalance(bool attackerSide) const; //health of given side minus health of its enemies
+
+private:
+	const CBattleInfoCallback *cb;
+};
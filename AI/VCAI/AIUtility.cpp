@@ -208,7 +208,7 @@ bool canBeEmbarkmentPoint(const TerrainTile *t)
 {
 	//tile must be free of with unoccupied boat
 	return !t->blocked
-        || (t->visitableObjects.size() == 1 && t->topVisitableId() == Obj::BOAT);
+        || (t->visitableObjects().size() == 1 && t->topVisitableId() == Obj::BOAT);
 }
 
 int3 whereToExplore(HeroPtr h)
@@ -413,7 +413,7 @@ TGoalVec ClearWayTo::getAllPossibleSubgoals()
 
 		if (isBlockedBorderGate(tileToHit))
 		{	//FIXME: this way we'll not visit gate and activate quest :?
-			ret.push_back  (sptr (Goals::FindObj (Obj::KEYMASTER, cb->getTile(tileToHit)->visitableObjects.back()->subID)));
+			ret.push_back  (sptr (Goals::FindObj (Obj::KEYMASTER, cb->getTile(tileToHit)->visitableObjects().back()->subID)));
 		}
 
 		auto topObj = backOrNull(cb->getVisitableObjs(tileToHit));
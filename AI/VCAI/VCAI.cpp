@@ -2584,8 +2584,8 @@ void SectorMap::exploreNewSector(crint3 pos, int num)
 							s.embarkmentPoints.push_back(neighPos);
 						}
 					});
-					if(t->visitable && vstd::contains(ai->knownSubterraneanGates, t->visitableObjects.front()))
-						toVisit.push(ai->knownSubterraneanGates[t->visitableObjects.front()]->visitablePos());
+					if(t->visitable && vstd::contains(ai->knownSubterraneanGates, t->visitableObjects().front()))
+						toVisit.push(ai->knownSubterraneanGates[t->visitableObjects().front()]->visitablePos());
 				}
 			}
 		}
@@ -2789,7 +2789,7 @@ int3 SectorMap::firstTileToGet(HeroPtr h, crint3 dst)
 				auto firstEP = boost::find_if(src->embarkmentPoints, [=](crint3 pos) -> bool
 				{
 					const TerrainTile *t = cb->getTile(pos);
-                    return t && t->visitableObjects.size() == 1 && t->topVisitableId() == Obj::BOAT
+                    return t && t->visitableObjects().size() == 1 && t->topVisitableId() == Obj::BOAT
 						&& retreiveTile(pos) == sectorToReach->id;
 				});
 
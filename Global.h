@@ -65,6 +65,7 @@ static_assert(sizeof(bool) == 1, "Bool needs to be 1 byte in size.");
 
 #include <algorithm>
 #include <array>
+#include <bitset>
 #include <cassert>
 #include <climits>
 #include <cmath>
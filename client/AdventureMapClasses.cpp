@@ -355,7 +355,7 @@ const SDL_Color & CMinimapInstance::getTileColor(const int3 & pos)
 		return fogOfWar;
 
 	// if object at tile is owned - it will be colored as its owner
-	for(const CGObjectInstance *obj : tile->blockingObjects)
+	for(const CGObjectInstance *obj : tile->blockingObjects())
 	{
 		//heroes will be blitted later
 		if (obj->ID == Obj::HERO)
@@ -377,16 +377,23 @@ const SDL_Color & CMinimapInstance::getTileColor(const int3 & pos)
 }
 void CMinimapInstance::tileToPixels (const int3 &tile, int &x, int &y, int toX, int toY)
 {
-	int3 mapSizes = LOCPLINT->cb->getMapSize();
+	int column = tile.x;
+	int row = tile.y;
+	vstd::abetween(column, 0, mapSizes.x);
+	vstd::abetween(row, 0, mapSizes.y);
 
-	double stepX = double(pos.w) / mapSizes.x;
-	double stepY = double(pos.h) / mapSizes.y;
+	x = toX + columnPixels[column];
+	y = toY + rowPixels[row];
+}
 
-	x = toX + stepX * tile.x;
-	y = toY + stepY * tile.y;
+ui32 CMinimapInstance::toPixel(const SDL_Color & color)
+{
+	ui32 pixel;
+	ColorPutter<4, 0>::PutColor(reinterpret_cast<Uint8 *>(&pixel), color);
+	return pixel;
 }
 
-void CMinimapInstance::blitTileWithColor(const SDL_Color &color, const int3 &tile, SDL_Surface *to, int toX, int toY)
+void CMinimapInstance::fillTile(ui32 color, const int3 &tile, SDL_Surface *to, int toX, int toY)
 {
 	//coordinates of rectangle on minimap representing this tile
 	// begin - first to blit, end - first NOT to blit
@@ -396,48 +403,42 @@ void CMinimapInstance::blitTileWithColor(const SDL_Color &color, const int3 &til
 
 	for (int y=yBegin; y<yEnd; y++)
 	{
-		Uint8 *ptr = (Uint8*)to->pixels + y * to->pitch + xBegin * minimap->format->BytesPerPixel;
-
-		for (int x=xBegin; x<xEnd; x++)
-			ColorPutter<4, 1>::PutColor(ptr, color);
+		ui32 *ptr = reinterpret_cast<ui32 *>((Uint8*)to->pixels + y * to->pitch) + xBegin;
+		std::fill(ptr, ptr + (xEnd - xBegin), color);
 	}
 }
 
+void CMinimapInstance::blitTileWithColor(const SDL_Color &color, const int3 &tile, SDL_Surface *to, int toX, int toY)
+{
+	fillTile(toPixel(color), tile, to, toX, toY);
+}
+
 void CMinimapInstance::refreshTile(const int3 &tile)
 {
-	blitTileWithColor(getTileColor(int3(tile.x, tile.y, level)), tile, minimap, 0, 0);
+	if (tile.z != level)
+		return;
+
+	ui32 & current = tileColors[tile.y * mapSizes.x + tile.x];
+	ui32 color = toPixel(getTileColor(tile));
+	if (current == color)
+		return;
+
+	current = color;
+	fillTile(color, tile, minimap, 0, 0);
 }
 
 void CMinimapInstance::drawScaled(int level)
 {
-	int3 mapSizes = LOCPLINT->cb->getMapSize();
-
-	//size of one map tile on our minimap
-	double stepX = double(pos.w) / mapSizes.x;
-	double stepY = double(pos.h) / mapSizes.y;
+	tileColors.resize(mapSizes.x * mapSizes.y);
 
-	double currY = 0;
-	for (int y=0; y<mapSizes.y; y++, currY += stepY)
+	for (int y=0; y<mapSizes.y; y++)
 	{
-		double currX = 0;
-		for (int x=0; x<mapSizes.x; x++, currX += stepX)
+		for (int x=0; x<mapSizes.x; x++)
 		{
-			const SDL_Color &color = getTileColor(int3(x,y,level));
-
-			//coordinates of rectangle on minimap representing this tile
-			// begin - first to blit, end - first NOT to blit
-			int xBegin = currX;
-			int yBegin = currY;
-			int xEnd = currX + stepX;
-			int yEnd = currY + stepY;
-
-			for (int y=yBegin; y<yEnd; y++)
-			{
-				Uint8 *ptr = (Uint8*)minimap->pixels + y * minimap->pitch + xBegin * minimap->format->BytesPerPixel;
-
-				for (int x=xBegin; x<xEnd; x++)
-					ColorPutter<4, 1>::PutColor(ptr, color);
-			}
+			const int3 tile(x, y, level);
+			ui32 color = toPixel(getTileColor(tile));
+			tileColors[y * mapSizes.x + x] = color;
+			fillTile(color, tile, minimap, 0, 0);
 		}
 	}
 }
@@ -445,10 +446,21 @@ void CMinimapInstance::drawScaled(int level)
 CMinimapInstance::CMinimapInstance(CMinimap *Parent, int Level):
     parent(Parent),
     minimap(CSDL_Ext::createSurfaceWithBpp<4>(parent->pos.w, parent->pos.h)),
-    level(Level)
+    level(Level),
+    mapSizes(LOCPLINT->cb->getMapSize())
 {
 	pos.w = parent->pos.w;
 	pos.h = parent->pos.h;
+
+	//size of one map tile on our minimap
+	double stepX = double(pos.w) / mapSizes.x;
+	double stepY = double(pos.h) / mapSizes.y;
+
+	for (int x=0; x<=mapSizes.x; x++)
+		columnPixels.push_back(stepX * x);
+	for (int y=0; y<=mapSizes.y; y++)
+		rowPixels.push_back(stepY * y);
+
 	drawScaled(level);
 }
 
@@ -517,6 +529,7 @@ CMinimap::CMinimap(const Rect &position):
     CIntObject(LCLICK | RCLICK | HOVER | MOVE, position.topLeft()),
     aiShield(nullptr),
     minimap(nullptr),
+    player(PlayerColor::CANNOT_DETERMINE),
     level(0),
     colors(loadColors("config/terrains.json"))
 {
@@ -596,21 +609,52 @@ void CMinimap::showAll(SDL_Surface * to)
 	}
 }
 
+void CMinimap::showLevel()
+{
+	if (minimap)
+		minimap->recActions &= ~(UPDATE | SHOWALL);
+
+	if (levelMinimaps.size() <= level)
+		levelMinimaps.resize(level + 1, nullptr);
+
+	if (!levelMinimaps[level])
+	{
+		OBJ_CONSTRUCTION_CAPTURING_ALL;
+		levelMinimaps[level] = new CMinimapInstance(this, level);
+	}
+	minimap = levelMinimaps[level];
+	minimap->recActions |= UPDATE | SHOWALL;
+}
+
 void CMinimap::update()
 {
 	if (aiShield) //AI turn is going on. There is no need to update minimap
 		return;
 
-	OBJ_CONSTRUCTION_CAPTURING_ALL;
-	vstd::clear_pointer(minimap);
-	minimap = new CMinimapInstance(this, level);
+	for (auto & levelMinimap : levelMinimaps)
+		vstd::clear_pointer(levelMinimap);
+	levelMinimaps.clear();
+	minimap = nullptr;
+
+	player = LOCPLINT->playerID;
+	showLevel();
 	redraw();
 }
 
 void CMinimap::setLevel(int newLevel)
 {
 	level = newLevel;
-	update();
+	if (aiShield) //will be shown once AI turn is over
+		return;
+
+	//in hotseat minimaps were drawn for previous player
+	if (player != LOCPLINT->playerID)
+		update();
+	else
+	{
+		showLevel();
+		redraw();
+	}
 }
 
 void CMinimap::setAIRadar(bool on)
@@ -618,14 +662,17 @@ void CMinimap::setAIRadar(bool on)
 	if (on)
 	{
 		OBJ_CONSTRUCTION_CAPTURING_ALL;
-		vstd::clear_pointer(minimap);
+		//keep minimaps - they are still updated by updateTile and will be shown again after AI turn
+		if (minimap)
+			minimap->recActions &= ~(UPDATE | SHOWALL);
+		minimap = nullptr;
 		if (!aiShield)
 			aiShield = new CPicture("AIShield");
 	}
 	else
 	{
 		vstd::clear_pointer(aiShield);
-		update();
+		setLevel(level);
 	}
 	// this my happen during AI turn when this interface is inactive
 	// force redraw in order to properly update interface
@@ -634,14 +681,21 @@ void CMinimap::setAIRadar(bool on)
 
 void CMinimap::hideTile(const int3 &pos)
 {
-	if (minimap)
-		minimap->refreshTile(pos);
+	updateTile(pos);
 }
 
 void CMinimap::showTile(const int3 &pos)
 {
-	if (minimap)
-		minimap->refreshTile(pos);
+	updateTile(pos);
+}
+
+void CMinimap::updateTile(const int3 &pos)
+{
+	//blocked tiles of objects at map border may be outside of it
+	if (!LOCPLINT->cb->isInTheMap(pos))
+		return;
+	if (pos.z < levelMinimaps.size() && levelMinimaps[pos.z])
+		levelMinimaps[pos.z]->refreshTile(pos);
 }
 
 CInfoBar::CVisibleInfo::CVisibleInfo(Point position):
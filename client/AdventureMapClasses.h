@@ -181,14 +181,24 @@ class CMinimapInstance : public CIntObject
 	CMinimap *parent;
 	SDL_Surface * minimap;
 	int level;
+	int3 mapSizes;
+
+	//current color of each tile, as 32 bpp pixel. Only tiles that change color are drawn again
+	std::vector<ui32> tileColors;
+
+	//nearest-neighbour scaling: first pixel of each tile column/row, with extra entry for end of last one
+	//on huge maps (>144) some tiles are empty ranges and are not visible on minimap
+	std::vector<int> columnPixels;
+	std::vector<int> rowPixels;
 
 	//get color of selected tile on minimap
 	const SDL_Color & getTileColor(const int3 & pos);
 
+	static ui32 toPixel(const SDL_Color & color);
+	void fillTile(ui32 color, const int3 & tile, SDL_Surface *to, int toX, int toY);
 	void blitTileWithColor(const SDL_Color & color, const int3 & pos, SDL_Surface *to, int x, int y);
 
-	//draw minimap already scaled.
-	//result is not antialiased. Will result in "missing" pixels on huge maps (>144)
+	//draw whole minimap of level, on creation
 	void drawScaled(int level);
 public:
 	CMinimapInstance(CMinimap * parent, int level);
@@ -197,6 +207,7 @@ public:
 	void showAll(SDL_Surface *to);
 	void tileToPixels (const int3 &tile, int &x, int &y,int toX = 0, int toY = 0);
 
+	//redraws tile if its color has changed, tiles on other levels are ignored
 	void refreshTile(const int3 &pos);
 };
 
@@ -206,9 +217,13 @@ class CMinimap : public CIntObject
 protected:
 
 	CPicture *aiShield; //the graphic displayed during AI turn
-	CMinimapInstance * minimap;
+	CMinimapInstance * minimap; //minimap of current level
+	std::vector<CMinimapInstance *> levelMinimaps; //created when level is shown first time, kept up to date by updateTile
+	PlayerColor player; //for whom levelMinimaps were created
 	int level;
 
+	void showLevel(); //shows minimap of current level, creates it if needed
+
 	//to initialize colors
 	std::map<int, std::pair<SDL_Color, SDL_Color> > loadColors(std::string from);
 
@@ -225,8 +240,8 @@ public:
 
 	CMinimap(const Rect & position);
 
-	//should be called to invalidate whole map - different player or level
 	int3 translateMousePosition();
+	//should be called to invalidate whole map - different player
 	void update();
 	void setLevel(int level);
 	void setAIRadar(bool on);
@@ -235,6 +250,7 @@ public:
 
 	void hideTile(const int3 &pos); //puts FoW
 	void showTile(const int3 &pos); //removes FoW
+	void updateTile(const int3 &pos); //recolors tile after its objects or their owners changed
 };
 
 /// Info box which shows next week/day information, hold the current date
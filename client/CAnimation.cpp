@@ -8,6 +8,7 @@
 #include "CBitmapHandler.h"
 #include "Graphics.h"
 #include "CAnimation.h"
+#include "CImageCache.h"
 #include "gui/SDL_Extensions.h"
 #include "gui/SDL_Pixels.h"
 
@@ -45,7 +46,7 @@ public:
 
 class CompImageLoader
 {
-	CompImage * image;
+	CompImageData * image;
 	ui8 *position;
 	ui8 *entry;
 	ui32 currentLine;
@@ -63,61 +64,10 @@ public:
 	//init image with these sizes and palette
 	inline void init(Point SpriteSize, Point Margins, Point FullSize, SDL_Color *pal);
 
-	CompImageLoader(CompImage * Img);
+	CompImageLoader(CompImageData * Img);
 	~CompImageLoader();
 };
 
-// Extremely simple file cache. TODO: smarter, more general solution
-class CFileCache
-{
-	static const int cacheSize = 50; //Max number of cached files
-	struct FileData
-	{
-		ResourceID name;
-		size_t size;
-		ui8 * data;
-
-		ui8 * getCopy()
-		{
-			auto   ret = new ui8[size];
-			std::copy(data, data + size, ret);
-			return ret;
-		}
-		FileData():
-		    size(0),
-		    data(nullptr)
-		{}
-		~FileData()
-		{
-			delete [] data;
-		}
-	};
-
-	std::list<FileData> cache;
-public:
-	ui8 * getCachedFile(ResourceID && rid)
-	{
-		for(auto & file : cache)
-		{
-			if (file.name == rid)
-				return file.getCopy();
-		}
-		// Still here? Cache miss
-		if (cache.size() > cacheSize)
-			cache.pop_front();
-		cache.push_back(FileData());
-
-		auto data =  CResourceHandler::get()->load(rid)->readAll();
-		cache.back().name = ResourceID(rid);
-		cache.back().size = data.second;
-		cache.back().data = data.first.release();
-
-		return cache.back().getCopy();
-	}
-};
-
-static CFileCache animationCache;
-
 /*************************************************************************
  *  DefFile, class used for def loading                                  *
  *************************************************************************/
@@ -392,7 +342,7 @@ SDLImageLoader::~SDLImageLoader()
 
 ////////////////////////////////////////////////////////////////////////////////
  
-CompImageLoader::CompImageLoader(CompImage * Img):
+CompImageLoader::CompImageLoader(CompImageData * Img):
 	image(Img),
 	position(nullptr),
 	entry(nullptr),
@@ -559,7 +509,8 @@ CompImageLoader::~CompImageLoader()
 	if (!image->surf)
 		return;
 
-	ui8* newPtr = (ui8*)realloc((void*)image->surf, position - image->surf);
+	image->size = position - image->surf;
+	ui8* newPtr = (ui8*)realloc((void*)image->surf, image->size);
 	if (newPtr)
 		image->surf = newPtr;
 }
@@ -585,11 +536,18 @@ void IImage::increaseRef()
 	refCount++;
 }
 
-SDLImage::SDLImage(CDefFile *data, size_t frame, size_t group, bool compressed):
+SDLImage::SDLImage(CDefFile *data, size_t frame, size_t group, const std::string & cacheKey):
 	surf(nullptr)
 {
-	SDLImageLoader loader(this);
-	data->loadFrame(frame, group, loader);
+	surf = imageCache.get(cacheKey, &margins, &fullSize);
+	if (surf)
+		return;
+
+	{
+		SDLImageLoader loader(this);
+		data->loadFrame(frame, group, loader);
+	}
+	imageCache.add(cacheKey, surf, margins, fullSize);
 }
 
 SDLImage::SDLImage(SDL_Surface * from, bool extraRef):
@@ -619,6 +577,7 @@ SDLImage::SDLImage(std::string filename, bool compressed):
 	}
 	if (compressed)
 	{
+		CSDL_Ext::unshare(surf);
 		SDL_Surface *temp = surf;
 		// add RLE flag
 		if (surf->format->palette)
@@ -654,6 +613,7 @@ void SDLImage::draw(SDL_Surface *where, int posX, int posY, Rect *src, ui8 rotat
 
 void SDLImage::playerColored(PlayerColor player)
 {
+	//surface may be shared through image cache - it will be replaced with recolored copy
 	graphics->blueToPlayersAdv(surf, player);
 }
 
@@ -672,17 +632,55 @@ SDLImage::~SDLImage()
 	SDL_FreeSurface(surf);
 }
 
-CompImage::CompImage(const CDefFile *data, size_t frame, size_t group):
+CompImageData::CompImageData():
 	surf(nullptr),
 	line(nullptr),
+	palette(nullptr),
+	size(0)
+{
+}
+
+CompImageData::~CompImageData()
+{
+	free(surf);
+	delete [] line;
+	delete [] palette;
+}
+
+size_t CompImageData::bytes() const
+{
+	size_t ret = size;
+	if (line)
+		ret += (sprite.h + 1) * sizeof(ui32);
+	if (palette)
+		ret += 256 * sizeof(SDL_Color);
+	return ret;
+}
+
+CompImage::CompImage(const CDefFile *file, size_t frame, size_t group, const std::string & cacheKey):
 	palette(nullptr)
-	
 {
-	CompImageLoader loader(this);
-	data->loadFrame(frame, group, loader);
+	data = imageCache.getCompressed(cacheKey);
+	if (!data)
+	{
+		auto loaded = std::make_shared<CompImageData>();
+		{
+			CompImageLoader loader(loaded.get());
+			file->loadFrame(frame, group, loader);
+		}
+		imageCache.addCompressed(cacheKey, loaded);
+		data = loaded;
+	}
+
+	if (data->palette)
+	{
+		palette = new SDL_Color[256];
+		memcpy((void*)palette, (void*)data->palette, 256*sizeof(SDL_Color));
+	}
 }
 
-CompImage::CompImage(SDL_Surface * surf)
+CompImage::CompImage(SDL_Surface * surf):
+	palette(nullptr)
 {
 	//TODO
 	assert(0);
@@ -693,8 +691,11 @@ void CompImage::draw(SDL_Surface *where, int posX, int posY, Rect *src, ui8 alph
 	int rotation = 0; //TODO
 	//rotation & 2 = horizontal rotation
 	//rotation & 4 = vertical rotation
-	if (!surf)
+	if (!data->surf)
 		return;
+	const Rect & sprite = data->sprite;
+	ui8 * const surf = data->surf;
+	const ui32 * const line = data->line;
 	Rect sourceRect(sprite);
 	//TODO: rotation and scaling
 	if (src)
@@ -878,18 +879,16 @@ void CompImage::playerColored(PlayerColor player)
 
 int CompImage::width() const
 {
-	return fullSize.x;
+	return data->fullSize.x;
 }
 
 int CompImage::height() const
 {
-	return fullSize.y;
+	return data->fullSize.y;
 }
 
 CompImage::~CompImage()
 {
-	free(surf);
-	delete [] line;
 	delete [] palette;
 }
 
@@ -943,9 +942,9 @@ bool CAnimation::loadFrame(CDefFile * file, size_t frame, size_t group)
 			if (vstd::contains(frameList, group) && frameList.at(group) > frame) // frame is present
 			{
 				if (compressed)
-					images[group][frame] = new CompImage(file, frame, group);
+					images[group][frame] = new CompImage(file, frame, group, "RLE:" + CImageCache::frameKey(name, group, frame));
 				else
-					images[group][frame] = new SDLImage(file, frame, group);
+					images[group][frame] = new SDLImage(file, frame, group, CImageCache::frameKey(name, group, frame));
 				return true;
 			}
 		}
@@ -1187,6 +1186,7 @@ void CAnimation::getAnimInfo()
 		if (!anim->images.empty())
             logGlobal->errorStream()<<", "<<anim->images.begin()->second.size()<<" image loaded in group "<< anim->images.begin()->first;
 	}
+	imageCache.printStats();
 }
 
 CAnimImage::CAnimImage(std::string name, size_t Frame, size_t Group, int x, int y, ui8 Flags):
@@ -89,8 +89,8 @@ public:
 	Point fullSize;
 
 public:
-	//Load image from def file
-	SDLImage(CDefFile *data, size_t frame, size_t group=0, bool compressed=false);
+	//Load image from def file, decoded surface is shared with other images through image cache
+	SDLImage(CDefFile *data, size_t frame, size_t group, const std::string & cacheKey);
 	//Load from bitmap file
 	SDLImage(std::string filename, bool compressed=false);
 	//Create using existing surface, extraRef will increase refcount on SDL_Surface
@@ -105,6 +105,30 @@ public:
 	friend class SDLImageLoader;
 };
 
+/*
+ * Compressed data of CompImage, shared with other images through image cache and never modified after loading
+ */
+struct CompImageData
+{
+	//x,y - margins, w,h - sprite size
+	Rect sprite;
+	//total size including borders
+	Point fullSize;
+
+	//RLE-d data
+	ui8 * surf;
+	//array of offsets for each line
+	ui32 * line;
+	//original palette of image
+	SDL_Color *palette;
+	//size of RLE-d data
+	size_t size;
+
+	CompImageData();
+	~CompImageData();
+	size_t bytes() const; //total memory used
+};
+
 /*
  *  RLE-compressed image data for 8-bit images with alpha-channel, currently far from finished
  *  primary purpose is not high compression ratio but fast drawing.
@@ -119,16 +143,8 @@ public:
  */
 class CompImage : public IImage
 {
-	//x,y - margins, w,h - sprite size
-	Rect sprite;
-	//total size including borders
-	Point fullSize;
-
-	//RLE-d data
-	ui8 * surf;
-	//array of offsets for each line
-	ui32 * line;
-	//palette
+	std::shared_ptr<const CompImageData> data;
+	//own copy of palette, changed by playerColored
 	SDL_Color *palette;
 
 	//Used internally to blit one block of data
@@ -137,8 +153,8 @@ class CompImage : public IImage
 	void BlitBlockWithBpp(ui8 bpp, ui8 type, ui8 size, ui8 *&data, ui8 *&dest, ui8 alpha, bool rotated) const;
 
 public:
-	//Load image from def file
-	CompImage(const CDefFile *data, size_t frame, size_t group=0);
+	//Load image from def file, compressed data is shared with other images through image cache
+	CompImage(const CDefFile *file, size_t frame, size_t group, const std::string & cacheKey);
 	//TODO: load image from SDL_Surface
 	CompImage(SDL_Surface * surf);
 	~CompImage();
@@ -147,8 +163,6 @@ public:
 	void playerColored(PlayerColor player);
 	int width() const;
 	int height() const;
-
-	friend class CompImageLoader;
 };
 
 
@@ -0,0 +1,186 @@
+#include "StdInc.h"
+#include "CAssetPrefetcher.h"
+
+#include "CBitmapHandler.h"
+#include "CDefHandler.h"
+#include "CGameInfo.h"
+#include "CImageCache.h"
+#include "CMusicHandler.h"
+#include "Graphics.h"
+#include "../lib/BattleState.h"
+#include "../lib/CCreatureHandler.h"
+#include "../lib/CObjectHandler.h"
+#include "../lib/CObstacleInstance.h"
+#include "../lib/CTownHandler.h"
+#include "../lib/filesystem/ResourceID.h"
+
+/*
+ * CAssetPrefetcher.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+CAssetPrefetcher::CAssetPrefetcher():
+	terminate(false),
+	worker(boost::bind(&CAssetPrefetcher::run, this))
+{
+}
+
+CAssetPrefetcher::~CAssetPrefetcher()
+{
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		terminate = true;
+		tasks.clear();
+	}
+	cond.notify_all();
+	worker.join();
+}
+
+void CAssetPrefetcher::run()
+{
+	while(true)
+	{
+		std::function<void()> task;
+		{
+			boost::unique_lock<boost::mutex> lock(mx);
+			while(tasks.empty() && !terminate)
+				cond.wait(lock);
+			if(terminate)
+				return;
+			task = tasks.front();
+			tasks.pop_front();
+		}
+
+		try
+		{
+			task();
+		}
+		catch(std::exception & e)
+		{
+			//screen will report missing asset on its own
+			logGlobal->warnStream() << "Failed to prefetch asset: " << e.what();
+		}
+	}
+}
+
+void CAssetPrefetcher::enqueue(std::function<void()> task)
+{
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		tasks.push_back(task);
+	}
+	cond.notify_one();
+}
+
+void CAssetPrefetcher::prefetchBitmap(const std::string & name, bool setKey)
+{
+	enqueue([=]
+	{
+		BitmapHandler::prefetchBitmap(name, setKey);
+	});
+}
+
+void CAssetPrefetcher::prefetchDef(const std::string & name)
+{
+	enqueue([=]
+	{
+		CDefHandler::prefetch(name);
+	});
+}
+
+void CAssetPrefetcher::prefetchAnimationFile(const std::string & name)
+{
+	enqueue([=]
+	{
+		animationCache.prefetch(ResourceID(std::string("SPRITES/") + name, EResType::ANIMATION));
+	});
+}
+
+void CAssetPrefetcher::prefetchSound(const std::string & name)
+{
+	if(name.empty())
+		return;
+
+	enqueue([=]
+	{
+		CCS->soundh->preloadSound(name);
+	});
+}
+
+void CAssetPrefetcher::prefetchBattle(const BattleInfo * info)
+{
+	//CBattleInterface loads creatures first, so start from the other end to meet it in the middle
+	for(auto & obstacle : info->obstacles)
+	{
+		if(obstacle->obstacleType == CObstacleInstance::USUAL)
+			prefetchDef(obstacle->getInfo().defName);
+		else if(obstacle->obstacleType == CObstacleInstance::ABSOLUTE_OBSTACLE)
+			prefetchBitmap(obstacle->getInfo().defName);
+	}
+
+	//background is picked randomly by interface - prefetch all candidates, there are only few of them
+	const int bfieldType = info->battlefieldType;
+	if(!info->town && bfieldType >= 0 && bfieldType < graphics->battleBacks.size())
+	{
+		for(auto & name : graphics->battleBacks[bfieldType])
+			prefetchBitmap(name, false);
+	}
+
+	std::set<const CCreature *> creatures;
+	for(const CStack * stack : info->stacks)
+	{
+		if(stack->position < 0 && info->town) //turret
+			creatures.insert(CGI->creh->creatures[info->town->town->clientInfo.siegeShooter]);
+		else
+			creatures.insert(stack->getCreature());
+	}
+	for(const CCreature * creature : creatures)
+	{
+		prefetchAnimationFile(creature->animDefName);
+		if(!creature->animation.projectileImageName.empty())
+			prefetchDef(creature->animation.projectileImageName);
+	}
+
+	//sounds are needed only once animations start
+	for(const CCreature * creature : creatures)
+	{
+		prefetchSound(creature->sounds.attack);
+		prefetchSound(creature->sounds.defend);
+		prefetchSound(creature->sounds.killed);
+		prefetchSound(creature->sounds.move);
+		prefetchSound(creature->sounds.shoot);
+		prefetchSound(creature->sounds.wince);
+		prefetchSound(creature->sounds.startMoving);
+		prefetchSound(creature->sounds.endMoving);
+	}
+}
+
+void CAssetPrefetcher::prefetchTown(const CGTownInstance * town)
+{
+	prefetchBitmap(town->town->clientInfo.townBackground);
+
+	for(const CStructure * structure : town->town->clientInfo.structures)
+	{
+		if(structure->building && !town->hasBuilt(structure->building->bid))
+			continue;
+
+		prefetchAnimationFile(structure->defName);
+		if(!structure->borderName.empty())
+			prefetchBitmap(structure->borderName);
+		if(!structure->areaName.empty())
+			prefetchBitmap(structure->areaName);
+	}
+}
+
+void CAssetPrefetcher::prefetchAdventureSounds()
+{
+	for(auto sound : CCS->soundh->horseSounds)
+		enqueue([=]{ CCS->soundh->preloadSound(sound); });
+	for(auto sound : CCS->soundh->pickupSounds)
+		enqueue([=]{ CCS->soundh->preloadSound(sound); });
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+struct BattleInfo;
+class CGTownInstance;
+
+/*
+ * CAssetPrefetcher.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+/// Loads assets of screens that are about to be opened on background thread, into image and file caches.
+/// Only a hint - screens still load everything themselves and just find prefetched assets in caches.
+/// Worker only decodes new images, they are passed to image cache and never shared before GUI takes them from there.
+class CAssetPrefetcher
+{
+	std::deque<std::function<void()> > tasks;
+	bool terminate;
+	boost::mutex mx;
+	boost::condition_variable cond;
+	boost::thread worker; //must be initialized last
+
+	void run();
+	void enqueue(std::function<void()> task);
+
+	void prefetchBitmap(const std::string & name, bool setKey = true);
+	void prefetchDef(const std::string & name); //decoded frames, as used by CDefHandler
+	void prefetchAnimationFile(const std::string & name); //raw data, as used by CAnimation and CCreatureAnimation
+	void prefetchSound(const std::string & name); //decoded, into sound bank of CSoundHandler
+
+public:
+	CAssetPrefetcher();
+	~CAssetPrefetcher();
+
+	//names of assets are collected on calling thread, loading is done by worker
+	void prefetchBattle(const BattleInfo * info);
+	void prefetchTown(const CGTownInstance * town);
+	void prefetchAdventureSounds(); //hero movement and pickup sounds
+};
@@ -6,6 +6,7 @@
 #include "SDL_image.h"
 #include "CBitmapHandler.h"
 #include "CDefHandler.h"
+#include "CImageCache.h"
 #include "gui/SDL_Extensions.h"
 #include "../lib/vcmi_endian.h"
 
@@ -175,13 +176,43 @@ SDL_Surface * BitmapHandler::loadBitmapFromDir(std::string path, std::string fna
 	return ret;
 }
 
+static std::string bitmapCacheKey(const std::string & fname, bool setKey)
+{
+	return "BITMAP:" + boost::to_upper_copy(fname) + (setKey ? ":KEY" : "");
+}
+
+static SDL_Surface * decodeBitmap(const std::string & fname, bool setKey)
+{
+	SDL_Surface *bitmap = nullptr;
+	if (!(bitmap = BitmapHandler::loadBitmapFromDir("DATA/", fname, setKey)) &&
+		!(bitmap = BitmapHandler::loadBitmapFromDir("SPRITES/", fname, setKey)))
+	{
+		logGlobal->errorStream()<<"Error: Failed to find file "<<fname;
+	}
+	return bitmap;
+}
+
 SDL_Surface * BitmapHandler::loadBitmap(std::string fname, bool setKey)
 {
-	SDL_Surface *bitmap;
+	const std::string cacheKey = bitmapCacheKey(fname, setKey);
 
-	if (!(bitmap = loadBitmapFromDir("DATA/", fname, setKey)) &&
-		!(bitmap = loadBitmapFromDir("SPRITES/", fname, setKey)))
-        logGlobal->errorStream()<<"Error: Failed to find file "<<fname;
+	SDL_Surface *bitmap = imageCache.get(cacheKey);
 
+	if (!bitmap)
+	{
+		if (!(bitmap = decodeBitmap(fname, setKey)))
+			return nullptr;
+		imageCache.add(cacheKey, bitmap);
+	}
 	return bitmap;
 }
+
+void BitmapHandler::prefetchBitmap(std::string fname, bool setKey)
+{
+	const std::string cacheKey = bitmapCacheKey(fname, setKey);
+	if (imageCache.contains(cacheKey))
+		return;
+
+	if (SDL_Surface * bitmap = decodeBitmap(fname, setKey))
+		imageCache.addDecoded(cacheKey, bitmap);
+}
@@ -17,6 +17,8 @@ namespace BitmapHandler
 	SDL_Surface * loadH3PCX(ui8 * data, size_t size);
 	//Load file from specific LOD
 	SDL_Surface * loadBitmapFromDir(std::string path, std::string fname, bool setKey=true);
-	//Load file from any LODs
+	//Load file from any LODs. Returned surface is shared through image cache - use CSDL_Ext::unshare before modifying it
 	SDL_Surface * loadBitmap(std::string fname, bool setKey=true);
+	//Decode file into image cache if it's not there yet, may be called from any thread
+	void prefetchBitmap(std::string fname, bool setKey=true);
 }
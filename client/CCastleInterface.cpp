@@ -187,6 +187,7 @@ void CBuildingRect::show(SDL_Surface * to)
 			else
 				newColor = oldColor;
 
+			CSDL_Ext::unshare(border);
 			SDL_SetColors(border, &newColor, colorID, 1);
 			blitAtLoc(border,0,0,to);
 			SDL_SetColors(border, &oldColor, colorID, 1);
@@ -5,6 +5,7 @@
 #include "../lib/filesystem/Filesystem.h"
 #include "../lib/VCMI_Lib.h"
 #include "CBitmapHandler.h"
+#include "CImageCache.h"
 
 /*
  * CDefHandler.cpp, part of VCMI engine
@@ -50,9 +51,8 @@ CDefEssential::~CDefEssential()
 		SDL_FreeSurface(elem.bitmap);
 }
 
-void CDefHandler::openFromMemory(ui8 *table, const std::string & name)
+void CDefHandler::readEntries(ui8 *table, const std::string & name, SDL_Color * palette)
 {
-	SDL_Color palette[256];
 	SDefEntry &de = * reinterpret_cast<SDefEntry *>(table);
 	ui8 *p;
 
@@ -111,11 +111,31 @@ void CDefHandler::openFromMemory(ui8 *table, const std::string & name)
 	{
 		elem.name = elem.name.substr(0, elem.name.find('.')+4);
 	}
+}
+
+std::string CDefHandler::frameCacheKey(size_t frame) const
+{
+	//palette differs from one used by CAnimation, so key must differ too
+	return "DEF:" + CImageCache::frameKey(defName, SEntries[frame].group, frame);
+}
+
+void CDefHandler::openFromMemory(ui8 *table, const std::string & name)
+{
+	SDL_Color palette[256];
+	readEntries(table, name, palette);
+
 	//RWEntries = new ui32[height];
 	for(ui32 i=0; i < SEntries.size(); ++i)
 	{
 		Cimage nimg;
-		nimg.bitmap = getSprite(i, table, palette);
+		//frames are shared through image cache, owners unshare them before recoloring
+		const std::string cacheKey = frameCacheKey(i);
+		nimg.bitmap = imageCache.get(cacheKey);
+		if (!nimg.bitmap)
+		{
+			nimg.bitmap = getSprite(i, table, palette);
+			imageCache.add(cacheKey, nimg.bitmap);
+		}
 		nimg.imName = SEntries[i].name;
 		nimg.groupNumber = SEntries[i].group;
 		ourImages.push_back(nimg);
@@ -371,6 +391,26 @@ CDefHandler * CDefHandler::giveDef(const std::string & defName)
 	nh->openFromMemory(data.get(), defName);
 	return nh;
 }
+void CDefHandler::prefetch(const std::string & defName)
+{
+	ResourceID resID(std::string("SPRITES/") + defName, EResType::ANIMATION);
+
+	auto data = CResourceHandler::get()->load(resID)->readAll().first;
+	if(!data)
+		throw std::runtime_error("bad def name!");
+
+	CDefHandler def;
+	SDL_Color palette[256];
+	def.readEntries(data.get(), defName, palette);
+
+	for(ui32 i=0; i < def.SEntries.size(); ++i)
+	{
+		const std::string cacheKey = def.frameCacheKey(i);
+		if (!imageCache.contains(cacheKey))
+			imageCache.addDecoded(cacheKey, def.getSprite(i, data.get(), palette));
+	}
+}
+
 CDefEssential * CDefHandler::giveDefEss(const std::string & defName)
 {
 	CDefEssential * ret;
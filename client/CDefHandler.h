@@ -86,6 +86,9 @@ private:
 	} ;
 	std::vector<SEntry> SEntries ;
 
+	void readEntries(ui8 * table, const std::string & name, SDL_Color * palette); //palette must have 256 colors
+	std::string frameCacheKey(size_t frame) const;
+
 public:
 	int width, height; //width and height
 	std::string defName;
@@ -101,4 +104,6 @@ public:
 
 	static CDefHandler * giveDef(const std::string & defName);
 	static CDefEssential * giveDefEss(const std::string & defName);
+	//decodes frames missing in image cache, may be called from any thread
+	static void prefetch(const std::string & defName);
 };
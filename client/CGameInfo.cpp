@@ -16,6 +16,16 @@
 const CGameInfo * CGI; //game info for general use
 CClientState * CCS;
 
+CClientState::CClientState():
+	soundh(nullptr),
+	musich(nullptr),
+	consoleh(nullptr),
+	curh(nullptr),
+	videoh(nullptr),
+	prefetcher(nullptr)
+{
+}
+
 CGameInfo::CGameInfo()
 {
 	mh = nullptr;
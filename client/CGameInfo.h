@@ -30,6 +30,7 @@ class CConsoleHandler;
 class CCursorHandler;
 class CGameState;
 class IMainVideoPlayer;
+class CAssetPrefetcher;
 
 class CMap;
 
@@ -43,6 +44,9 @@ public:
 	CConsoleHandler * consoleh;
 	CCursorHandler * curh;
 	IMainVideoPlayer * videoh;
+	CAssetPrefetcher * prefetcher; //only with GUI
+
+	CClientState();
 };
 extern CClientState * CCS;
 
@@ -0,0 +1,252 @@
+#include "StdInc.h"
+#include "CImageCache.h"
+
+#include "CAnimation.h"
+#include "../lib/CConfigHandler.h"
+#include "../lib/filesystem/Filesystem.h"
+
+/*
+ * CImageCache.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+CImageCache imageCache;
+CFileCache animationCache;
+
+CImageCache::CImageCache():
+	totalBytes(0),
+	hits(0),
+	misses(0),
+	evictions(0)
+{
+}
+
+CImageCache::~CImageCache()
+{
+	clear();
+}
+
+std::string CImageCache::frameKey(const std::string & animation, size_t group, size_t frame)
+{
+	return boost::to_upper_copy(animation) + ':' + boost::lexical_cast<std::string>(group) + ':' + boost::lexical_cast<std::string>(frame);
+}
+
+CImageCache::Entry * CImageCache::find(const std::string & key)
+{
+	auto it = entries.find(key);
+	if(it == entries.end())
+	{
+		misses++;
+		return nullptr;
+	}
+	hits++;
+
+	Entry & entry = it->second;
+	lru.splice(lru.begin(), lru, entry.lruPos);
+	return &entry;
+}
+
+CImageCache::Entry * CImageCache::insert(const std::string & key, size_t bytes)
+{
+	const size_t budget = getBudget();
+	if(bytes > budget)
+		return nullptr; //would evict everything else
+
+	if(vstd::contains(entries, key))
+		return nullptr; //loaded by another thread in the meantime
+
+	evict(budget - bytes);
+
+	lru.push_front(key);
+
+	Entry & entry = entries[key];
+	entry.surf = nullptr;
+	entry.bytes = bytes;
+	entry.lruPos = lru.begin();
+	totalBytes += bytes;
+	return &entry;
+}
+
+void CImageCache::storeDecoded()
+{
+	for(auto & elem : decoded)
+	{
+		SDL_Surface * surf = elem.second;
+		Entry * entry = insert(elem.first, size_t(surf->pitch) * surf->h);
+		if(!entry)
+		{
+			SDL_FreeSurface(surf);
+			continue;
+		}
+
+		entry->surf = surf; //reference of decoding thread is taken over
+		entry->margins = Point(0, 0);
+		entry->fullSize = Point(surf->w, surf->h);
+	}
+	decoded.clear();
+}
+
+SDL_Surface * CImageCache::get(const std::string & key, Point * margins, Point * fullSize)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	storeDecoded();
+
+	Entry * entry = find(key);
+	if(!entry || !entry->surf)
+		return nullptr;
+
+	if(margins)
+		*margins = entry->margins;
+	if(fullSize)
+		*fullSize = entry->fullSize;
+	entry->surf->refcount++;
+	return entry->surf;
+}
+
+void CImageCache::add(const std::string & key, SDL_Surface * surf, Point margins, Point fullSize)
+{
+	if(!surf)
+		return;
+
+	boost::unique_lock<boost::mutex> lock(mx);
+	storeDecoded();
+	Entry * entry = insert(key, size_t(surf->pitch) * surf->h);
+	if(!entry)
+		return;
+
+	surf->refcount++;
+	entry->surf = surf;
+	entry->margins = margins;
+	entry->fullSize = fullSize.x < 0 ? Point(surf->w, surf->h) : fullSize;
+}
+
+std::shared_ptr<const CompImageData> CImageCache::getCompressed(const std::string & key)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+
+	Entry * entry = find(key);
+	if(!entry)
+		return std::shared_ptr<const CompImageData>();
+	return entry->compressed;
+}
+
+void CImageCache::addCompressed(const std::string & key, std::shared_ptr<const CompImageData> data)
+{
+	if(!data)
+		return;
+
+	boost::unique_lock<boost::mutex> lock(mx);
+	Entry * entry = insert(key, data->bytes());
+	if(entry)
+		entry->compressed = data;
+}
+
+bool CImageCache::contains(const std::string & key) const
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	return vstd::contains(entries, key) || vstd::contains(decoded, key);
+}
+
+void CImageCache::addDecoded(const std::string & key, SDL_Surface * surf)
+{
+	if(!surf)
+		return;
+
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(vstd::contains(decoded, key))
+	{
+		SDL_FreeSurface(surf); //never shared, so it can be freed here
+		return;
+	}
+	decoded[key] = surf;
+}
+
+void CImageCache::evict(size_t budget)
+{
+	while(totalBytes > budget && !lru.empty())
+	{
+		auto it = entries.find(lru.back());
+		totalBytes -= it->second.bytes;
+		if(it->second.surf)
+			SDL_FreeSurface(it->second.surf); //image users still hold their references
+		entries.erase(it);
+		lru.pop_back();
+		evictions++;
+	}
+}
+
+size_t CImageCache::getBudget() const
+{
+	return size_t(settings["video"]["imageCacheSize"].Float()) * 1024 * 1024;
+}
+
+void CImageCache::clear()
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	for(auto & elem : decoded)
+		SDL_FreeSurface(elem.second);
+	decoded.clear();
+	evict(0);
+}
+
+void CImageCache::printStats() const
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	logGlobal->infoStream() << "Image cache: " << entries.size() << " images, " << totalBytes / 1024 << " KB of "
+		<< getBudget() / 1024 << " KB; " << hits << " hits, " << misses << " misses, " << evictions << " evictions";
+}
+
+CFileCache::FileData & CFileCache::getFile(boost::unique_lock<boost::mutex> & lock, const ResourceID & rid)
+{
+	for(auto it = cache.begin(); it != cache.end(); ++it)
+	{
+		if (it->name == rid)
+		{
+			cache.splice(cache.end(), cache, it);
+			return cache.back();
+		}
+	}
+	// Still here? Cache miss. Don't block other threads while reading file
+	lock.unlock();
+	auto data = CResourceHandler::get()->load(rid)->readAll();
+	lock.lock();
+
+	for(auto & file : cache)
+	{
+		if (file.name == rid) //loaded by another thread in the meantime
+			return file;
+	}
+
+	if (cache.size() > cacheSize)
+		cache.pop_front();
+	cache.push_back(FileData());
+
+	cache.back().name = ResourceID(rid);
+	cache.back().size = data.second;
+	cache.back().data = data.first.release();
+	return cache.back();
+}
+
+ui8 * CFileCache::getCachedFile(ResourceID && rid)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	return getFile(lock, rid).getCopy();
+}
+
+std::pair<std::unique_ptr<ui8[]>, size_t> CFileCache::readAll(const ResourceID & rid)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	FileData & file = getFile(lock, rid);
+	return std::make_pair(std::unique_ptr<ui8[]>(file.getCopy()), file.size);
+}
+
+void CFileCache::prefetch(const ResourceID & rid)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	getFile(lock, rid);
+}
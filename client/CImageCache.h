@@ -0,0 +1,117 @@
+#pragma once
+
+#include "gui/Geometries.h"
+#include "../lib/filesystem/ResourceID.h"
+
+struct SDL_Surface;
+struct CompImageData;
+
+/*
+ * CImageCache.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+/// Shared cache of decoded images, keyed by resource name (and frame for animations).
+/// Surfaces are shared using SDL refcount - cache holds one reference, every user one more.
+/// Compressed frames of CAnimation are shared using shared_ptr.
+/// SDL refcount is not thread-safe, so shared surfaces are used only by threads holding interface lock;
+/// other threads (asset prefetcher) pass newly decoded surfaces through addDecoded.
+/// Least recently used entries are dropped once total size exceeds video.imageCacheSize (in MB);
+/// dropped surface stays alive until its last user frees it.
+class CImageCache
+{
+	struct Entry
+	{
+		SDL_Surface * surf;
+		std::shared_ptr<const CompImageData> compressed; //set instead of surf for compressed frames
+		Point margins; //empty borders cut from image
+		Point fullSize; //size of image with borders
+		size_t bytes;
+		std::list<std::string>::iterator lruPos;
+	};
+
+	std::map<std::string, Entry> entries;
+	std::list<std::string> lru; //most recently used first
+	size_t totalBytes;
+
+	std::map<std::string, SDL_Surface *> decoded; //added by other threads, moved to entries by storeDecoded
+
+	ui64 hits, misses, evictions;
+
+	mutable boost::mutex mx;
+
+	void evict(size_t budget);
+	size_t getBudget() const; //in bytes
+	Entry * find(const std::string & key); //nullptr if there is no such entry, counts hit or miss
+	Entry * insert(const std::string & key, size_t bytes); //nullptr if entry exists or is too big
+	void storeDecoded();
+
+public:
+	CImageCache();
+	~CImageCache();
+
+	static std::string frameKey(const std::string & animation, size_t group, size_t frame);
+
+	//returns surface with increased refcount (caller must free it) or nullptr if there is no such entry
+	SDL_Surface * get(const std::string & key, Point * margins = nullptr, Point * fullSize = nullptr);
+	//stores surface under given key, refcount is increased so caller keeps its reference
+	void add(const std::string & key, SDL_Surface * surf, Point margins = Point(0, 0), Point fullSize = Point(-1, -1));
+
+	//returns compressed frame or empty pointer if there is no such entry
+	std::shared_ptr<const CompImageData> getCompressed(const std::string & key);
+	void addCompressed(const std::string & key, std::shared_ptr<const CompImageData> data);
+
+	//may be called from any thread
+	bool contains(const std::string & key) const;
+	//stores surface decoded by other thread, cache takes its reference; surface must not be used by caller anymore
+	void addDecoded(const std::string & key, SDL_Surface * surf);
+
+	void clear();
+	void printStats() const;
+};
+
+/// Cache of raw (not decoded) animation files. Recently used files are kept, every user gets own copy of data.
+class CFileCache
+{
+	static const int cacheSize = 50; //Max number of cached files
+	struct FileData
+	{
+		ResourceID name;
+		size_t size;
+		ui8 * data;
+
+		ui8 * getCopy()
+		{
+			auto   ret = new ui8[size];
+			std::copy(data, data + size, ret);
+			return ret;
+		}
+		FileData():
+		    size(0),
+		    data(nullptr)
+		{}
+		~FileData()
+		{
+			delete [] data;
+		}
+	};
+
+	std::list<FileData> cache; //least recently used first
+	boost::mutex mx;
+
+	//finds or loads file, lock must hold mx and is released while file is being read
+	FileData & getFile(boost::unique_lock<boost::mutex> & lock, const ResourceID & rid);
+public:
+	ui8 * getCachedFile(ResourceID && rid);
+	std::pair<std::unique_ptr<ui8[]>, size_t> readAll(const ResourceID & rid);
+	//loads file into cache without copying it
+	void prefetch(const ResourceID & rid);
+};
+
+extern CImageCache imageCache;
+extern CFileCache animationCache;
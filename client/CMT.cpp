@@ -23,6 +23,7 @@
 #include "CMusicHandler.h"
 #include "CVideoHandler.h"
 #include "CDefHandler.h"
+#include "CAssetPrefetcher.h"
 #include "../lib/CGeneralTextHandler.h"
 #include "Graphics.h"
 #include "Client.h"
@@ -39,6 +40,7 @@
 #include "../lib/CScriptingModule.h"
 #include "../lib/GameConstants.h"
 #include "gui/CGuiHandler.h"
+#include "gui/PixelKernels.h"
 #include "../lib/logging/CBasicLogConfigurator.h"
 
 #ifdef _WIN32
@@ -88,9 +90,24 @@ void dispose();
 void playIntro();
 static void listenForEvents();
 //void requestChangingResolution();
-void startGame(StartInfo * options, CConnection *serv = nullptr);
+void startGame(StartInfo * options, CConnection *serv = nullptr, CServerHandler *localServer = nullptr);
 void endGame();
 
+/// Duel to be run by --battles option
+struct DuelTask
+{
+	std::string file;
+	ui32 seed; //0 - server will choose
+};
+
+static boost::mutex duelMx;
+static boost::condition_variable duelCond;
+static bool runningDuelBatch = false;
+static boost::optional<BattleResult> duelResult; //result of current duel
+static bool duelFinished = false; //set when results of current duel were applied by server
+static std::vector<DuelTask> readDuelList(const std::string &fname);
+static void runDuels(const std::vector<DuelTask> &duels, const std::string &resultsFile, const std::string &jsonResultsFile);
+
 #ifndef _WIN32
 #ifndef _GNU_SOURCE
 #define _GNU_SOURCE
@@ -153,6 +170,7 @@ void init()
 	{
 		CCS->curh = new CCursorHandler;
 		graphics = new Graphics(); // should be before curh->init()
+		CCS->prefetcher = new CAssetPrefetcher;
 
 		CCS->curh->initCursor();
 		CCS->curh->show();
@@ -224,6 +242,9 @@ int main(int argc, char** argv)
 		("help,h", "display help and exit")
 		("version,v", "display version information and exit")
 		("battle,b", po::value<std::string>(), "runs game in duel mode (battle-only")
+		("battles", po::value<std::string>(), "runs all duels listed in given file (battle file and optional random seed per line) one after another, implies --noGUI")
+		("battlesResults", po::value<std::string>()->default_value("battleResults.csv"), "file to which results of duels started with --battles are appended")
+		("battlesJson", po::value<std::string>()->default_value("battleResults.json"), "file to which results of duels started with --battles are written as JSON, overwritten by each run")
 		("start", po::value<std::string>(), "starts game from saved StartInfo file")
 		("onlyAI", "runs without human player, all players will be default AI")
 		("noGUI", "runs without GUI, implies --onlyAI")
@@ -231,6 +252,7 @@ int main(int argc, char** argv)
 		("oneGoodAI", "puts one default AI and the rest will be EmptyAI")
 		("autoSkip", "automatically skip turns in GUI")
 		("disable-video", "disable video player")
+		("benchmarkVideo", po::value<std::string>(), "decodes given video as fast as possible without displaying it, logs achieved fps and exits")
 		("nointro,i", "skips intro movies");
 
 	if(argc > 1)
@@ -256,6 +278,8 @@ int main(int argc, char** argv)
 		prog_version();
 		return 0;
 	}
+	if(vm.count("battles"))
+		vm.insert(std::pair<std::string, po::variable_value>("noGUI", po::variable_value()));
 	if(vm.count("noGUI"))
 	{
 		gNoGUI = true;
@@ -314,6 +338,14 @@ int main(int argc, char** argv)
     logGlobal->infoStream() <<"Loading settings: "<<pomtime.getDiff();
     logGlobal->infoStream() << NAME;
 
+#if !DISABLE_VIDEO
+	if(vm.count("benchmarkVideo"))
+	{
+		CVideoPlayer::benchmark(vm["benchmarkVideo"].as<std::string>());
+		exit(EXIT_SUCCESS);
+	}
+#endif
+
 	srand ( time(nullptr) );
 	
 
@@ -374,7 +406,12 @@ int main(int argc, char** argv)
 	loading.join();
     logGlobal->infoStream()<<"Initialization of VCMI (together): "<<total.getDiff();
 
-	if(!vm.count("battle"))
+	if(vm.count("battles"))
+	{
+		runDuels(readDuelList(vm["battles"].as<std::string>()), vm["battlesResults"].as<std::string>(), vm["battlesJson"].as<std::string>());
+		handleQuit();
+	}
+	else if(!vm.count("battle"))
 	{
 		Settings session = settings.write["session"];
 		session["autoSkip"].Bool()  = vm.count("autoSkip");
@@ -537,10 +574,7 @@ void processCommand(const std::string &message)
 
 		std::string outPath = VCMIDirs::get().userCachePath() + "/extracted/";
 
-		auto list = CResourceHandler::get()->getFilteredFiles([](const ResourceID & ident)
-		{
-			return ident.getType() == EResType::TEXT && boost::algorithm::starts_with(ident.getName(), "DATA/");
-		});
+		auto list = CResourceHandler::get()->getFilesWithPrefix("DATA/", EResType::TEXT);
 
 		for (auto & filename : list)
 		{
@@ -653,6 +687,10 @@ void processCommand(const std::string &message)
 		if(mxname == "pim" && LOCPLINT)
 			LOCPLINT->pim->unlock();
 	}
+	else if(cn == "benchmark")
+	{
+		PixelKernels::benchmark();
+	}
 	else if(cn == "def2bmp")
 	{
 		std::string URI;
@@ -736,6 +774,10 @@ void dispose()
 	if (console)
 		delete console;
 
+	//worker uses resource handler and caches, stop it before they are destroyed
+	delete CCS->prefetcher;
+	CCS->prefetcher = nullptr;
+
 	// cleanup, mostly to remove false leaks from analyzer
 	CResourceHandler::clear();
 	CCS->musich->release();
@@ -911,10 +953,11 @@ static void listenForEvents()
 			boost::unique_lock<boost::mutex> lock(eventsM); 
 			events.push(ev);
 		}
+		GH.notifyActivity();
 	}
 }
 
-void startGame(StartInfo * options, CConnection *serv/* = nullptr*/)
+void startGame(StartInfo * options, CConnection *serv/* = nullptr*/, CServerHandler *localServer/* = nullptr*/)
 {
 	if(vm.count("onlyAI"))
 	{
@@ -938,7 +981,7 @@ void startGame(StartInfo * options, CConnection *serv/* = nullptr*/)
 	case StartInfo::NEW_GAME:
 	case StartInfo::CAMPAIGN:
 	case StartInfo::DUEL:
-		client->newGame(serv, options);
+		client->newGame(serv, options, localServer);
 		break;
 	case StartInfo::LOAD_GAME:
 		std::string fname = options->mapname;
@@ -956,6 +999,127 @@ void endGame()
 	vstd::clear_pointer(client);
 }
 
+std::vector<DuelTask> readDuelList(const std::string &fname)
+{
+	std::ifstream in(fname);
+	if(!in)
+		throw std::runtime_error("Cannot open list of duels " + fname);
+
+	std::vector<DuelTask> ret;
+	std::string line;
+	while(std::getline(in, line))
+	{
+		boost::algorithm::trim(line);
+		if(line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream lineStream(line);
+		DuelTask task;
+		task.seed = 0;
+		lineStream >> task.file >> task.seed;
+		ret.push_back(task);
+	}
+	logGlobal->infoStream() << "Loaded " << ret.size() << " duels from " << fname;
+	return ret;
+}
+
+void runDuels(const std::vector<DuelTask> &duels, const std::string &resultsFile, const std::string &jsonResultsFile)
+{
+	const bool writeHeader = !boost::filesystem::exists(resultsFile);
+	std::ofstream out(resultsFile, std::ios::app);
+	if(!out)
+		throw std::runtime_error("Cannot open results file " + resultsFile);
+	if(writeHeader)
+		out << "battle,seed,winner,result,attackerCasualties,defenderCasualties,durationMs\n";
+	JsonNode jsonResults(JsonNode::DATA_VECTOR);
+
+	//one server process runs all duels, each duel connects to it again
+	CServerHandler server;
+	server.keepRunning = true;
+
+	runningDuelBatch = true;
+	for(auto & task : duels)
+	{
+		logGlobal->infoStream() << "Starting duel " << task.file << " with seed " << task.seed;
+		{
+			boost::unique_lock<boost::mutex> lock(duelMx);
+			duelResult.reset();
+			duelFinished = false;
+		}
+
+		const auto startTime = boost::posix_time::microsec_clock::universal_time(); //wall time, CStopWatch measures CPU time
+		auto si = new StartInfo();
+		si->mode = StartInfo::DUEL;
+		si->mapname = task.file;
+		si->seedToBeUsed = task.seed;
+		si->playerInfos[PlayerColor(0)].color = PlayerColor(0);
+		si->playerInfos[PlayerColor(1)].color = PlayerColor(1);
+		startGame(si, nullptr, &server);
+
+		BattleResult result;
+		result.winner = 2;
+		result.result = BattleResult::NORMAL;
+		{
+			boost::unique_lock<boost::mutex> lock(duelMx);
+			while(!duelFinished)
+				duelCond.wait(lock);
+			if(duelResult)
+				result = *duelResult;
+		}
+		const si64 duration = (boost::posix_time::microsec_clock::universal_time() - startTime).total_milliseconds();
+		endGame();
+
+		auto countCasualties = [](const std::map<ui32,si32> &casualties) -> si32
+		{
+			si32 ret = 0;
+			for(auto & elem : casualties)
+				ret += elem.second;
+			return ret;
+		};
+
+		out << boost::format("%s,%d,%d,%d,%d,%d,%d\n") % task.file % task.seed % (int)result.winner % (int)result.result
+			% countCasualties(result.casualties[0]) % countCasualties(result.casualties[1]) % duration;
+		out.flush();
+
+		JsonNode entry;
+		entry["battle"].String() = task.file;
+		entry["seed"].Float() = task.seed;
+		entry["winner"].Float() = result.winner;
+		entry["result"].Float() = result.result;
+		entry["attackerCasualties"].Float() = countCasualties(result.casualties[0]);
+		entry["defenderCasualties"].Float() = countCasualties(result.casualties[1]);
+		entry["durationMs"].Float() = duration;
+		jsonResults.Vector().push_back(entry);
+
+		//rewritten after each duel so results of finished duels are kept if batch is interrupted
+		std::ofstream jsonOut(jsonResultsFile, std::ofstream::trunc);
+		if(!jsonOut)
+			throw std::runtime_error("Cannot open results file " + jsonResultsFile);
+		jsonOut << jsonResults;
+	}
+	runningDuelBatch = false;
+	server.stopServer();
+}
+
+void setDuelResult(const BattleResult &result)
+{
+	boost::unique_lock<boost::mutex> lock(duelMx);
+	duelResult = result;
+}
+
+void handleDuelEnd()
+{
+	if(!runningDuelBatch)
+	{
+		handleQuit();
+		return;
+	}
+
+	boost::unique_lock<boost::mutex> lock(duelMx);
+	duelFinished = true;
+	duelCond.notify_one();
+}
+
 void handleQuit()
 {
 	auto quitApplication = []()
@@ -965,10 +1129,13 @@ void handleQuit()
 		if(mainGUIThread)
 		{
 			GH.terminate = true;
+			GH.notifyActivity(); //wake up GUI thread if it's idle
 			if(mainGUIThread->get_id() != boost::this_thread::get_id()) mainGUIThread->join();
 			delete mainGUIThread;
 			mainGUIThread = nullptr;
 		}
+		delete CCS->prefetcher;
+		CCS->prefetcher = nullptr;
 		delete console;
 		console = nullptr;
 		boost::this_thread::sleep(boost::posix_time::milliseconds(750));
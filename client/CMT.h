@@ -1,9 +1,13 @@
 #pragma once
 
+struct BattleResult;
+
 extern SDL_Surface *screen;      // main screen surface
 extern SDL_Surface *screen2;     // and hlp surface (used to store not-active interfaces layer)
 extern SDL_Surface *screenBuf; // points to screen (if only advmapint is present) or screen2 (else) - should be used when updating controls which are not regularly redrawed
 
 extern bool gNoGUI; //if true there is no client window and game is silently played between AIs
 
-void handleQuit();
\ No newline at end of file
+void handleQuit();
+void setDuelResult(const BattleResult &result); //stores result of duel for --battles report
+void handleDuelEnd(); //called when duel is finished, quits or starts next duel from --battles list
\ No newline at end of file
@@ -92,6 +92,7 @@ void CMessage::init()
 			delete bluePieces;
 		}
 		background = BitmapHandler::loadBitmap("DIBOXBCK.BMP");
+		CSDL_Ext::unshare(background);
 		SDL_SetColorKey(background,SDL_SRCCOLORKEY,SDL_MapRGB(background->format,0,255,255));
 	}
 	ok = CDefHandler::giveDef("IOKAY.DEF");
@@ -82,7 +82,8 @@ void CSoundHandler::onVolumeChange(const JsonNode &volumeNode)
 }
 
 CSoundHandler::CSoundHandler():
-	listener(settings.listen["general"]["sound"])
+	listener(settings.listen["general"]["sound"]),
+	cachedBytes(0)
 {
 	listener(boost::bind(&CSoundHandler::onVolumeChange, this, _1));
 
@@ -118,63 +119,184 @@ void CSoundHandler::release()
 	{
 		Mix_HaltChannel(-1);
 
-		std::map<soundBase::soundID, Mix_Chunk *>::iterator it;
-		for (it=soundChunks.begin(); it != soundChunks.end(); it++)
-		{
-			if (it->second)
-				Mix_FreeChunk(it->second);
-		}
+		freeFinishedChunks();
+		for (auto & sound : soundChunks)
+			Mix_FreeChunk(sound.second.chunk);
+		for (auto & chunk : uncachedChunks)
+			Mix_FreeChunk(chunk);
+
+		soundChunks.clear();
+		soundsLRU.clear();
+		uncachedChunks.clear();
+		pinnedChunks.clear();
+		cachedBytes = 0;
 	}
 
 	CAudioBase::release();
 }
 
-// Allocate an SDL chunk and cache it.
-Mix_Chunk *CSoundHandler::GetSoundChunk(soundBase::soundID soundID)
+Mix_Chunk *CSoundHandler::loadChunk(const std::string & sound)
 {
-	// Find its name
-	auto fname = sounds[soundID];
-	if (fname.empty())
-		return nullptr;
-
-	// Load and insert
 	try
 	{
-		auto data = CResourceHandler::get()->load(ResourceID(std::string("SOUNDS/") + fname, EResType::SOUND))->readAll();
+		auto data = CResourceHandler::get()->load(ResourceID(std::string("SOUNDS/") + sound, EResType::SOUND))->readAll();
 
-		SDL_RWops *ops = SDL_RWFromMem(data.first.release(), data.second);
-		Mix_Chunk *chunk;
-		chunk = Mix_LoadWAV_RW(ops, 1);	// will free ops
-		soundChunks.insert(std::pair<soundBase::soundID, Mix_Chunk *>(soundID, chunk));
-		return chunk;
+		SDL_RWops *ops = SDL_RWFromMem(data.first.get(), data.second);
+		return Mix_LoadWAV_RW(ops, 1);	// will free ops, decoded sound has its own copy of data
 	}
 	catch(std::exception &e)
 	{
-        logGlobal->warnStream() << "Cannot get sound " << soundID << " chunk: " << e.what();
+        logGlobal->warnStream() << "Cannot get sound " << sound << " chunk: " << e.what();
 		return nullptr;
 	}
 }
 
-Mix_Chunk *CSoundHandler::GetSoundChunk(std::string &sound)
+size_t CSoundHandler::getCacheBudget() const
+{
+	return size_t(settings["general"]["soundCacheSize"].Float()) * 1024 * 1024;
+}
+
+bool CSoundHandler::isCacheable(const Mix_Chunk * chunk) const
+{
+	// SDL_mixer can't stream chunks - long sounds like campaign voices are decoded on every play
+	// instead of pushing all other sounds out of cache
+	return chunk->alen <= getCacheBudget() / 4;
+}
+
+Mix_Chunk *CSoundHandler::addChunk(const std::string & key, Mix_Chunk * chunk, bool pin)
+{
+	std::vector<Mix_Chunk *> toFree;
+	{
+		boost::unique_lock<boost::mutex> lock(soundMutex);
+
+		auto it = soundChunks.find(key);
+		if (it != soundChunks.end())
+		{
+			// loaded by another thread in the meantime
+			toFree.push_back(chunk);
+			chunk = it->second.chunk;
+		}
+		else if (!isCacheable(chunk))
+		{
+			uncachedChunks.insert(chunk);
+		}
+		else
+		{
+			evict(getCacheBudget() - chunk->alen, toFree);
+
+			soundsLRU.push_front(key);
+			CachedSound & sound = soundChunks[key];
+			sound.chunk = chunk;
+			sound.lruPos = soundsLRU.begin();
+			cachedBytes += chunk->alen;
+		}
+
+		if (pin)
+			pinnedChunks[chunk]++;
+	}
+
+	for (auto & evicted : toFree)
+		Mix_FreeChunk(evicted);
+	return chunk;
+}
+
+void CSoundHandler::evict(size_t limit, std::vector<Mix_Chunk *> & evicted)
+{
+	auto it = soundsLRU.end();
+	while (cachedBytes > limit && it != soundsLRU.begin())
+	{
+		--it;
+		Mix_Chunk * chunk = soundChunks[*it].chunk;
+
+		bool playing = vstd::contains(pinnedChunks, chunk);
+		for (auto & channel : playingChunks)
+			playing |= channel.second == chunk;
+		if (playing)
+			continue;
+
+		cachedBytes -= chunk->alen;
+		evicted.push_back(chunk);
+		soundChunks.erase(*it);
+		it = soundsLRU.erase(it);
+	}
+}
+
+void CSoundHandler::unpinChunk(Mix_Chunk * chunk)
+{
+	auto it = pinnedChunks.find(chunk);
+	if (it != pinnedChunks.end() && --it->second == 0)
+		pinnedChunks.erase(it);
+}
+
+void CSoundHandler::freeFinishedChunks()
+{
+	std::vector<Mix_Chunk *> finished;
+	{
+		boost::unique_lock<boost::mutex> lock(soundMutex);
+		finished.swap(finishedChunks);
+	}
+
+	for (auto & chunk : finished)
+		Mix_FreeChunk(chunk);
+}
+
+Mix_Chunk *CSoundHandler::GetSoundChunk(soundBase::soundID soundID)
+{
+	return GetSoundChunk(sounds[soundID]);
+}
+
+// Returns decoded sound from sound bank, loads it if needed
+Mix_Chunk *CSoundHandler::GetSoundChunk(const std::string &sound)
 {
 	if (sound.empty())
 		return nullptr;
 
-	// Load and insert
-	try
+	freeFinishedChunks();
+
+	std::string key = boost::to_upper_copy(sound);
 	{
-		auto data = CResourceHandler::get()->load(ResourceID(std::string("SOUNDS/") + sound, EResType::SOUND))->readAll();
+		boost::unique_lock<boost::mutex> lock(soundMutex);
 
-		SDL_RWops *ops = SDL_RWFromMem(data.first.release(), data.second);
-		Mix_Chunk *chunk;
-		chunk = Mix_LoadWAV_RW(ops, 1);	// will free ops
-		return chunk;
+		auto it = soundChunks.find(key);
+		if (it != soundChunks.end())
+		{
+			soundsLRU.splice(soundsLRU.begin(), soundsLRU, it->second.lruPos);
+			pinnedChunks[it->second.chunk]++;
+			return it->second.chunk;
+		}
 	}
-	catch(std::exception &e)
+
+	Mix_Chunk * chunk = loadChunk(sound);
+	if (chunk)
+		chunk = addChunk(key, chunk, true);
+	return chunk;
+}
+
+void CSoundHandler::preloadSound(const std::string & sound)
+{
+	if (!initialized || sound.empty())
+		return;
+
+	std::string key = boost::to_upper_copy(sound);
 	{
-        logGlobal->warnStream() << "Cannot get sound " << sound << " chunk: " << e.what();
-		return nullptr;
+		boost::unique_lock<boost::mutex> lock(soundMutex);
+		if (vstd::contains(soundChunks, key))
+			return;
 	}
+
+	Mix_Chunk * chunk = loadChunk(sound);
+	if (!chunk)
+		return;
+
+	if (isCacheable(chunk))
+		addChunk(key, chunk, false);
+	else
+		Mix_FreeChunk(chunk); // will be loaded again when played
+}
+
+void CSoundHandler::preloadSound(soundBase::soundID soundID)
+{
+	preloadSound(sounds[soundID]);
 }
 
 void CSoundHandler::initSpellsSounds(const std::vector< ConstTransitivePtr<CSpell> > &spells)
@@ -199,6 +321,32 @@ void CSoundHandler::initSpellsSounds(const std::vector< ConstTransitivePtr<CSpel
 	}
 }
 
+int CSoundHandler::playChunk(Mix_Chunk * chunk, int repeats)
+{
+	int channel = Mix_PlayChannel(-1, chunk, repeats);
+	if (channel == -1)
+	{
+		boost::unique_lock<boost::mutex> lock(soundMutex);
+		unpinChunk(chunk);
+		if (uncachedChunks.erase(chunk))
+			finishedChunks.push_back(chunk);
+		return channel;
+	}
+
+	callbacks[channel];//insert empty callback
+	{
+		boost::unique_lock<boost::mutex> lock(soundMutex);
+		playingChunks[channel] = chunk;
+		unpinChunk(chunk);
+	}
+
+	// very short sound may be over before it was registered
+	if (!Mix_Playing(channel))
+		chunkFinished(channel);
+
+	return channel;
+}
+
 // Plays a sound, and return its channel so we can fade it out later
 int CSoundHandler::playSound(soundBase::soundID soundID, int repeats)
 {
@@ -211,11 +359,9 @@ int CSoundHandler::playSound(soundBase::soundID soundID, int repeats)
 
 	if (chunk)
 	{
-		channel = Mix_PlayChannel(-1, chunk, repeats);
+		channel = playChunk(chunk, repeats);
 		if (channel == -1)
             logGlobal->errorStream() << "Unable to play sound file " << soundID << " , error " << Mix_GetError();
-		else
-			callbacks[channel];//insert empty callback
 	}
 	else
 	{
@@ -235,11 +381,9 @@ int CSoundHandler::playSound(std::string sound, int repeats)
 
 	if (chunk)
 	{
-		channel = Mix_PlayChannel(-1, chunk, repeats);
+		channel = playChunk(chunk, repeats);
 		if (channel == -1)
             logGlobal->errorStream() << "Unable to play sound file " << sound << " , error " << Mix_GetError();
-		else
-			callbacks[channel];//insert empty callback
 	}
 	else
 	{
@@ -282,8 +426,24 @@ void CSoundHandler::setCallback(int channel, std::function<void()> function)
 		iter->second = function;
 }
 
+void CSoundHandler::chunkFinished(int channel)
+{
+	boost::unique_lock<boost::mutex> lock(soundMutex);
+
+	auto it = playingChunks.find(channel);
+	if (it == playingChunks.end())
+		return;
+
+	// can't be freed here - SDL_mixer calls this with audio locked
+	if (uncachedChunks.erase(it->second))
+		finishedChunks.push_back(it->second);
+	playingChunks.erase(it);
+}
+
 void CSoundHandler::soundFinishedCallback(int channel)
 {
+	chunkFinished(channel);
+
 	std::map<int, std::function<void()> >::iterator iter;
 	iter = callbacks.find(channel);
 
@@ -42,10 +42,37 @@ private:
 	SettingsListener listener;
 	void onVolumeChange(const JsonNode &volumeNode);
 
-	std::map<soundBase::soundID, Mix_Chunk *> soundChunks;
-
+	struct CachedSound
+	{
+		Mix_Chunk * chunk;
+		std::list<std::string>::iterator lruPos;
+	};
+
+	// Sound bank. Accessed by asset prefetcher and by SDL_mixer callback, protected by soundMutex.
+	// No Mix_* function may be called with locked mutex - SDL_mixer calls our callback with audio locked
+	boost::mutex soundMutex;
+	std::map<std::string, CachedSound> soundChunks; // key is uppercase file name
+	std::list<std::string> soundsLRU; // most recently used first
+	size_t cachedBytes;
+	std::map<int, Mix_Chunk *> playingChunks; // chunk on each active channel, these are never evicted
+	std::map<Mix_Chunk *, int> pinnedChunks; // returned by GetSoundChunk but not playing yet, with number of pins; never evicted
+	std::set<Mix_Chunk *> uncachedChunks; // sounds too big for cache, freed after playing
+	std::vector<Mix_Chunk *> finishedChunks; // uncached sounds that finished playing, waiting to be freed
+
+	Mix_Chunk *loadChunk(const std::string & sound); // decodes sound, may be called from any thread
+	Mix_Chunk *addChunk(const std::string & key, Mix_Chunk * chunk, bool pin); // returns chunk that should be used
+	void unpinChunk(Mix_Chunk * chunk); // soundMutex must be locked
+	void evict(size_t limit, std::vector<Mix_Chunk *> & evicted);
+	size_t getCacheBudget() const;
+	bool isCacheable(const Mix_Chunk * chunk) const;
+	void freeFinishedChunks();
+
+	// returned chunk is pinned, so it can't be evicted by other threads until playChunk unpins it
 	Mix_Chunk *GetSoundChunk(soundBase::soundID soundID);
-	Mix_Chunk *GetSoundChunk(std::string &sound);
+	Mix_Chunk *GetSoundChunk(const std::string &sound);
+
+	int playChunk(Mix_Chunk * chunk, int repeats);
+	void chunkFinished(int channel);
 
 	//have entry for every currently active channel
 	//std::function will be nullptr if callback was not set
@@ -60,6 +87,10 @@ public:
 	void initSpellsSounds(const std::vector< ConstTransitivePtr<CSpell> > &spells);
 	void setVolume(ui32 percent);
 
+	/// decodes sound into sound bank without playing it, to avoid delay on first play. Thread-safe
+	void preloadSound(const std::string & sound);
+	void preloadSound(soundBase::soundID soundID);
+
 	// Sounds
 	int playSound(soundBase::soundID soundID, int repeats=0);
 	int playSound(std::string sound, int repeats=0);
@@ -39,6 +39,7 @@
 #include "../lib/GameConstants.h"
 #include "gui/CGuiHandler.h"
 #include "../lib/UnlockGuard.h"
+#include "CAssetPrefetcher.h"
 
 #ifdef min
 #undef min
@@ -125,6 +126,9 @@ CPlayerInterface::CPlayerInterface(PlayerColor Player)
 	firstCall = 1; //if loading will be overwritten in serialize
 	autosaveCount = 0;
 	isAutoFightOn = false;
+	totalRedrawPending = false;
+	minimapRedrawPending = false;
+	townListUpdatePending = false;
 }
 
 CPlayerInterface::~CPlayerInterface()
@@ -165,6 +169,9 @@ void CPlayerInterface::yourTurn()
 			if(howManyPeople == 1)
 				adventureInt->setPlayer(playerID);
 
+			if(CCS->prefetcher)
+				CCS->prefetcher->prefetchAdventureSounds();
+
 			autosaveCount = getLastIndex("Autosave_");
 
 			if(firstCall > 0) //new game, not loaded
@@ -284,7 +291,7 @@ void CPlayerInterface::heroMoved(const TryMoveHero & details)
 
 				}
 			}
-			adventureInt->heroList.update(hero);
+			requestHeroListUpdate(hero);
 			return;	//teleport - no fancy moving animation
 					//TODO: smooth disappear / appear effect
 		}
@@ -306,7 +313,7 @@ void CPlayerInterface::heroMoved(const TryMoveHero & details)
 		hero->isStanding = true;
 		stillMoveHero.setn(STOP_MOVE);
 		GH.totalRedraw();
-		adventureInt->heroList.update(hero);
+		requestHeroListUpdate(hero);
 		return;
 	}
 
@@ -332,8 +339,8 @@ void CPlayerInterface::heroMoved(const TryMoveHero & details)
 	hero->isStanding = true;
 
 	//move finished
-	adventureInt->minimap.redraw();
-	adventureInt->heroList.update(hero);
+	requestMinimapRedraw();
+	requestHeroListUpdate(hero);
 
 	//check if user cancelled movement
 	{
@@ -398,7 +405,7 @@ void CPlayerInterface::heroKilled(const CGHeroInstance* hero)
 	if(vstd::contains(paths, hero))
 		paths.erase(hero);
 
-	adventureInt->heroList.update(hero);
+	requestHeroListUpdate(hero);
 	if (makingTurn && newSelection)
 		adventureInt->select(newSelection, true);
 	else if(adventureInt->selection == hero)
@@ -409,7 +416,7 @@ void CPlayerInterface::heroCreated(const CGHeroInstance * hero)
 {
 	EVENT_HANDLER_CALLED_BY_CLIENT;
 	wanderingHeroes.push_back(hero);
-	adventureInt->heroList.update(hero);
+	requestHeroListUpdate(hero);
 }
 void CPlayerInterface::openTownWindow(const CGTownInstance * town)
 {
@@ -449,7 +456,7 @@ void CPlayerInterface::heroSecondarySkillChanged(const CGHeroInstance * hero, in
 	CUniversityWindow* cuw = dynamic_cast<CUniversityWindow*>(GH.topInt());
 	if(cuw) //university window is open
 	{
-		GH.totalRedraw();
+		requestTotalRedraw();
 	}
 }
 
@@ -458,13 +465,13 @@ void CPlayerInterface::heroManaPointsChanged(const CGHeroInstance * hero)
 	EVENT_HANDLER_CALLED_BY_CLIENT;
 	updateInfo(hero);
 	if(makingTurn && hero->tempOwner == playerID)
-		adventureInt->heroList.update(hero);
+		requestHeroListUpdate(hero);
 }
 void CPlayerInterface::heroMovePointsChanged(const CGHeroInstance * hero)
 {
 	EVENT_HANDLER_CALLED_BY_CLIENT;
 	if(makingTurn && hero->tempOwner == playerID)
-		adventureInt->heroList.update(hero);
+		requestHeroListUpdate(hero);
 }
 void CPlayerInterface::receivedResource(int type, int val)
 {
@@ -472,7 +479,7 @@ void CPlayerInterface::receivedResource(int type, int val)
 	if(CMarketplaceWindow *mw = dynamic_cast<CMarketplaceWindow *>(GH.topInt()))
 		mw->resourceChanged(type, val);
 
-	GH.totalRedraw();
+	requestTotalRedraw();
 }
 
 void CPlayerInterface::heroGotLevel(const CGHeroInstance *hero, PrimarySkill::PrimarySkill pskill, std::vector<SecondarySkill>& skills, QueryID queryID)
@@ -513,7 +520,7 @@ void CPlayerInterface::heroInGarrisonChange(const CGTownInstance *town)
 		if (town->visitingHero->tempOwner == playerID) // our hero
 			wanderingHeroes.push_back(town->visitingHero);
 	}
-	adventureInt->heroList.update();
+	requestHeroListUpdate(nullptr);
 	adventureInt->updateNextHero(nullptr);
 
 	if(CCastleInterface *c = castleInt)
@@ -533,7 +540,7 @@ void CPlayerInterface::heroInGarrisonChange(const CGTownInstance *town)
 			ki->updateGarrisons();
 		}
 	}
-	GH.totalRedraw();
+	requestTotalRedraw();
 }
 void CPlayerInterface::heroVisitsTown(const CGHeroInstance* hero, const CGTownInstance * town)
 {
@@ -563,7 +570,7 @@ void CPlayerInterface::garrisonsChanged(std::vector<const CGObjectInstance *> ob
 		}
 	}
 
-	GH.totalRedraw();
+	requestTotalRedraw();
 }
 
 void CPlayerInterface::garrisonChanged( const CGObjectInstance * obj)
@@ -597,7 +604,7 @@ void CPlayerInterface::buildChanged(const CGTownInstance *town, BuildingID build
 		castleInt->removeBuilding(buildingID);
 		break;
 	}
-	adventureInt->townList.update(town);
+	requestTownListUpdate();
 	castleInt->townlist->update(town);
 }
 
@@ -1118,7 +1125,7 @@ void CPlayerInterface::tileRevealed(const std::unordered_set<int3, ShashInt3> &p
 	for(auto & po : pos)
 		adventureInt->minimap.showTile(po);
 	if(!pos.empty())
-		GH.totalRedraw();
+		requestTotalRedraw();
 }
 
 void CPlayerInterface::tileHidden(const std::unordered_set<int3, ShashInt3> &pos)
@@ -1127,7 +1134,7 @@ void CPlayerInterface::tileHidden(const std::unordered_set<int3, ShashInt3> &pos
 	for(auto & po : pos)
 		adventureInt->minimap.hideTile(po);
 	if(!pos.empty())
-		GH.totalRedraw();
+		requestTotalRedraw();
 }
 
 void CPlayerInterface::openHeroWindow(const CGHeroInstance *hero)
@@ -1278,6 +1285,15 @@ bool CPlayerInterface::moveHero( const CGHeroInstance *h, CGPath path )
 	if(showingDialog->get() || !dialogs.empty())
 		return false;
 
+	//entering own town will open town screen - start loading it while hero walks
+	if(CCS->prefetcher && !path.nodes.empty())
+	{
+		for(const CGObjectInstance * obj : cb->getVisitableObjs(path.endPos(), false))
+		{
+			if(obj->ID == Obj::TOWN && obj->tempOwner == playerID)
+				CCS->prefetcher->prefetchTown(static_cast<const CGTownInstance *>(obj));
+		}
+	}
 
 	if (adventureInt && adventureInt->isHeroSleeping(h))
 	{
@@ -1459,12 +1475,7 @@ void CPlayerInterface::objectPropertyChanged(const SetObjectProperty * sop)
 	if(sop->what == ObjProperty::OWNER)
 	{
 		const CGObjectInstance * obj = cb->getObj(sop->id);
-		std::set<int3> pos = obj->getBlockedPos();
-		for(auto & po : pos)
-		{
-			if(cb->isVisible(po))
-				adventureInt->minimap.showTile(po);
-		}
+		requestMinimapTilesUpdate(obj);
 
 		if(obj->ID == Obj::TOWN)
 		{
@@ -1472,7 +1483,7 @@ void CPlayerInterface::objectPropertyChanged(const SetObjectProperty * sop)
 				towns.push_back(static_cast<const CGTownInstance *>(obj));
 			else
 				towns -= obj;
-			adventureInt->townList.update();
+			requestTownListUpdate();
 		}
 
 		assert(cb->getTownsInfo().size() == towns.size());
@@ -1533,6 +1544,83 @@ void CPlayerInterface::showRecruitmentDialog(const CGDwelling *dwelling, const C
 	GH.pushInt(cr);
 }
 
+void CPlayerInterface::requestTotalRedraw()
+{
+	if(GH.amIGuiThread())
+		GH.totalRedraw();
+	else
+		totalRedrawPending = true;
+}
+
+void CPlayerInterface::requestMinimapRedraw()
+{
+	if(GH.amIGuiThread())
+		adventureInt->minimap.redraw();
+	else
+		minimapRedrawPending = true;
+}
+
+void CPlayerInterface::requestHeroListUpdate(const CGHeroInstance * hero)
+{
+	if(GH.amIGuiThread())
+		adventureInt->heroList.update(hero);
+	else
+		heroListUpdates.insert(hero);
+}
+
+void CPlayerInterface::requestTownListUpdate()
+{
+	if(GH.amIGuiThread())
+		adventureInt->townList.update();
+	else
+		townListUpdatePending = true;
+}
+
+void CPlayerInterface::requestMinimapTilesUpdate(const CGObjectInstance * obj)
+{
+	for(auto & tile : obj->getBlockedPos())
+		minimapTileUpdates.insert(tile);
+}
+
+void CPlayerInterface::packBatchFinished()
+{
+	EVENT_HANDLER_CALLED_BY_CLIENT;
+	//minimap only redraws tiles whose color has changed
+	for(auto & tile : minimapTileUpdates)
+		adventureInt->minimap.updateTile(tile);
+	if(!minimapTileUpdates.empty())
+		requestMinimapRedraw();
+	minimapTileUpdates.clear();
+
+	//whole list is rebuilt anyway, single heroes don't need separate update
+	if(vstd::contains(heroListUpdates, nullptr))
+		adventureInt->heroList.update();
+	else
+	{
+		for(auto hero : heroListUpdates)
+			adventureInt->heroList.update(hero);
+	}
+	heroListUpdates.clear();
+
+	if(townListUpdatePending)
+	{
+		townListUpdatePending = false;
+		adventureInt->townList.update();
+	}
+
+	if(totalRedrawPending)
+	{
+		totalRedrawPending = false;
+		minimapRedrawPending = false;
+		GH.totalRedraw();
+	}
+	else if(minimapRedrawPending)
+	{
+		minimapRedrawPending = false;
+		adventureInt->minimap.redraw();
+	}
+}
+
 void CPlayerInterface::waitWhileDialog(bool unlockPim /*= true*/)
 {
 	if(GH.amIGuiThread())
@@ -1568,6 +1656,7 @@ void CPlayerInterface::newObject( const CGObjectInstance * obj )
 		CCS->soundh->playSound(soundBase::newBuilding);
 		LOCPLINT->castleInt->addBuilding(BuildingID::SHIP);
 	}
+	requestMinimapTilesUpdate(obj);
 }
 
 void CPlayerInterface::centerView (int3 pos, int focusTime)
@@ -1591,6 +1680,7 @@ void CPlayerInterface::objectRemoved( const CGObjectInstance *obj )
 		const CGHeroInstance *h = static_cast<const CGHeroInstance*>(obj);
 		heroKilled(h);
 	}
+	requestMinimapTilesUpdate(obj);
 }
 
 bool CPlayerInterface::ctrlPressed() const
@@ -1642,7 +1732,7 @@ void CPlayerInterface::update()
 
 	// draw the mouse cursor and update the screen
 	CCS->curh->drawWithScreenRestore();
-	CSDL_Ext::update(screen);
+	GH.updateScreen();
 	CCS->curh->drawRestored();
 }
 
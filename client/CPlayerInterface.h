@@ -116,6 +116,13 @@ public:
 	shared_ptr<CBattleGameInterface> autofightingAI; //AI that makes decisions
 	bool isAutoFightOn; //Flag, switch it to stop quick combat. Don't touch if there is no battle interface.
 
+	//updates requested by event handlers, done once current batch of packs is applied
+	bool totalRedrawPending;
+	bool minimapRedrawPending;
+	bool townListUpdatePending;
+	std::set<const CGHeroInstance *> heroListUpdates; //nullptr - whole list
+	std::set<int3> minimapTileUpdates; //tiles of objects that were added, removed or changed owner
+
 
 	struct SpellbookLastSetting
 	{
@@ -187,6 +194,7 @@ public:
 	void objectRemoved(const CGObjectInstance *obj) override;
 	void gameOver(PlayerColor player, const EVictoryLossCheckResult & victoryLossCheckResult) override;
 	void playerStartsTurn(PlayerColor player) override; //called before yourTurn on active itnerface
+	void packBatchFinished() override;
 	void showComp(const Component &comp, std::string message) override; //display component in the advmapint infobox
 	void saveGame(COSer<CSaveFile> &h, const int version) override; //saving
 	void loadGame(CISer<CLoadFile> &h, const int version) override; //loading
@@ -219,6 +227,12 @@ public:
 	void garrisonsChanged(std::vector<const CGObjectInstance *> objs);
 	void garrisonChanged(const CGObjectInstance * obj);
 	void heroKilled(const CGHeroInstance* hero);
+	//these update at the end of pack batch if called by client, immediately otherwise
+	void requestTotalRedraw();
+	void requestMinimapRedraw();
+	void requestHeroListUpdate(const CGHeroInstance * hero);
+	void requestTownListUpdate();
+	void requestMinimapTilesUpdate(const CGObjectInstance * obj); //always at the end of batch, removed object is still on map when handler is called
 	void waitWhileDialog(bool unlockPim = true);
 	void waitForAllDialogs(bool unlockPim = true);
 	bool shiftPressed() const; //determines if shift key is pressed (left or right or both)
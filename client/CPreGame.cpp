@@ -73,6 +73,67 @@ static PlayerColor playerColor; //if more than one player - applies to the first
  */
 static std::string saveGameName;
 
+/// Cached header of one map, stored on disk between runs
+/// Entry is valid only if size and modification date of map file did not changed
+/// Header is stored before map overrides are applied, so changes in overrides are picked up on next run
+struct MapHeaderCacheEntry
+{
+	ui64 size;
+	si64 date;
+	CMapHeader header;
+
+	MapHeaderCacheEntry(): size(0), date(0) {}
+
+	template <typename Handler> void serialize(Handler &h, const int version)
+	{
+		h & size & date & header;
+	}
+};
+
+/// key = full path to map file
+typedef std::map<std::string, MapHeaderCacheEntry> TMapHeaderCache;
+
+static const std::string MAP_HEADER_CACHE_MAGIC = "VCMIMHR";
+
+static std::string mapHeaderCachePath()
+{
+	return VCMIDirs::get().userCachePath() + "/mapHeaders.cache";
+}
+
+static TMapHeaderCache loadMapHeaderCache()
+{
+	TMapHeaderCache cache;
+	if (!fs::exists(mapHeaderCachePath()))
+		return cache;
+
+	try
+	{
+		CLoadFile lf(mapHeaderCachePath());
+		lf.checkMagicBytes(MAP_HEADER_CACHE_MAGIC);
+		lf >> cache;
+	}
+	catch(const std::exception & e)
+	{
+		logGlobal->warnStream() << "Failed to load map header cache: " << e.what();
+		cache.clear();
+	}
+	return cache;
+}
+
+static void saveMapHeaderCache(const TMapHeaderCache & cache)
+{
+	try
+	{
+		CSaveFile sf(mapHeaderCachePath());
+		sf.putMagicBytes(MAP_HEADER_CACHE_MAGIC);
+		sf << cache;
+	}
+	catch(const std::exception & e)
+	{
+		logGlobal->warnStream() << "Failed to save map header cache: " << e.what();
+	}
+}
+
 struct EvilHlpStruct
 {
 	CConnection *serv;
@@ -516,13 +577,14 @@ void CGPreGame::update()
 		//return;
 
 	GH.topInt()->show(screen);
+	GH.invalidate(GH.topInt());
 
 	if (settings["general"]["showfps"].Bool())
 		GH.drawFPSCounter();
 
 	// draw the mouse cursor and update the screen
 	CCS->curh->drawWithScreenRestore();
-	CSDL_Ext::update(screen);
+	GH.updateScreen();
 	CCS->curh->drawRestored();
 }
 
@@ -1083,34 +1145,95 @@ std::unordered_set<ResourceID> SelectionTab::getFiles(std::string dirURI, int re
 {
 	boost::to_upper(dirURI);
 
-	std::unordered_set<ResourceID> ret = CResourceHandler::get()->getFilteredFiles([&](const ResourceID & ident)
-	{
-		return ident.getType() == resType
-			&& boost::algorithm::starts_with(ident.getName(), dirURI);
-	});
-
-	return ret;
+	return CResourceHandler::get()->getFilesWithPrefix(dirURI, EResType::Type(resType));
 }
 
 void SelectionTab::parseMaps(const std::unordered_set<ResourceID> &files)
 {
+	CStopWatch timer;
 	allItems.clear();
-	for(auto & file : files)
+
+	const std::vector<ResourceID> fileList(files.begin(), files.end());
+	const si64 maxVersion = CGI->modh->settings.data["textData"]["mapVersion"].Float();
+
+	std::vector<CMapInfo> parsed(fileList.size());
+	std::vector<ui8> accepted(fileList.size(), false);
+
+	const TMapHeaderCache oldCache = loadMapHeaderCache();
+	TMapHeaderCache newCache;
+
+	boost::mutex mx; // protects nextFile and newCache
+	size_t nextFile = 0;
+
+	auto parseFiles = [&]()
 	{
-		try
+		setThreadName("SelectionTab::parseMaps");
+		while(true)
 		{
-			CMapInfo mapInfo;
-			mapInfo.mapInit(file.getName());
+			size_t index;
+			{
+				boost::unique_lock<boost::mutex> lock(mx);
+				if (nextFile == fileList.size())
+					return;
+				index = nextFile++;
+			}
 
-			// ignore unsupported map versions (e.g. WoG maps without WoG
-			if (mapInfo.mapHeader->version <= CGI->modh->settings.data["textData"]["mapVersion"].Float())
-				allItems.push_back(std::move(mapInfo));
-		}
-		catch(std::exception & e)
-		{
-            logGlobal->errorStream() << "Map " << file.getName() << " is invalid. Message: " << e.what();
+			const ResourceID & file = fileList[index];
+			CMapInfo & mapInfo = parsed[index];
+			try
+			{
+				// only maps that are files on disk can be cached, e.g. maps from zip archives can't
+				auto path = CResourceHandler::get()->getResourceName(file);
+				MapHeaderCacheEntry entry;
+				if (path)
+				{
+					entry.size = fs::file_size(*path);
+					entry.date = fs::last_write_time(*path);
+				}
+
+				std::unique_ptr<CMapHeader> header;
+				auto cached = path ? oldCache.find(*path) : oldCache.end();
+				if (cached != oldCache.end() && cached->second.size == entry.size && cached->second.date == entry.date)
+					header = make_unique<CMapHeader>(cached->second.header);
+				else
+					header = CMapService::loadRawMapHeader(file.getName());
+
+				if (path)
+				{
+					entry.header = *header;
+					boost::unique_lock<boost::mutex> lock(mx);
+					newCache[*path] = std::move(entry);
+				}
+
+				CMapService::patchMapHeader(header, file.getName());
+				mapInfo.fileURI = file.getName();
+				mapInfo.mapHeader = std::move(header);
+				mapInfo.countPlayers();
+
+				// ignore unsupported map versions (e.g. WoG maps without WoG
+				accepted[index] = mapInfo.mapHeader->version <= maxVersion;
+			}
+			catch(std::exception & e)
+			{
+				logGlobal->errorStream() << "Map " << file.getName() << " is invalid. Message: " << e.what();
+			}
 		}
+	};
+
+	size_t threadsCount = std::max<size_t>(1, std::min<size_t>(boost::thread::hardware_concurrency(), fileList.size()));
+	boost::thread_group workers;
+	for (size_t i=0; i<threadsCount; i++)
+		workers.create_thread(parseFiles);
+	workers.join_all();
+
+	for (size_t i=0; i<parsed.size(); i++)
+	{
+		if (accepted[i])
+			allItems.push_back(std::move(parsed[i]));
 	}
+
+	saveMapHeaderCache(newCache);
+	logGlobal->debugStream() << "Parsed " << fileList.size() << " map headers in " << timer.getDiff() << " ms";
 }
 
 void SelectionTab::parseGames(const std::unordered_set<ResourceID> &files, bool multi)
@@ -3128,6 +3251,7 @@ void CBonusSelection::init()
 	loadPositionsOfGraphics();
 
 	background = BitmapHandler::loadBitmap(bgNames[ourCampaign->camp->header.mapVersion]);
+	CSDL_Ext::unshare(background); //panel and texts are drawn on it
 	pos.h = background->h;
 	pos.w = background->w;
 	center();
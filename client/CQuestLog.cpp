@@ -73,6 +73,8 @@ CMinimap (position),
 void CQuestMinimap::addQuestMarks (const QuestInfo * q)
 {
 	OBJ_CONSTRUCTION_CAPTURING_ALL;
+	for (auto icon : icons)
+		delete icon;
 	icons.clear();
 
 	int3 tile;
@@ -148,6 +150,7 @@ void CQuestLog::init()
 	}
 
 	recreateQuestList (0);
+	minimap->update();
 }
 
 void CQuestLog::showAll(SDL_Surface * to)
@@ -162,7 +165,6 @@ void CQuestLog::showAll(SDL_Surface * to)
 		CSDL_Ext::drawBorder(to, Rect::around(labels[questIndex]->pos), int3(Colors::METALLIC_GOLD.r, Colors::METALLIC_GOLD.g, Colors::METALLIC_GOLD.b));
 	}
 	description->show(to);
-	minimap->update();
 	minimap->show(to);
 }
 
@@ -187,6 +189,7 @@ void CQuestLog::selectQuest (int which)
 	questIndex = which;
 	currentQuest = &quests[which];
 	minimap->currentQuest = currentQuest;
+	minimap->addQuestMarks(currentQuest);
 
 	MetaString text;
 	std::vector<Component> components; //TODO: display them
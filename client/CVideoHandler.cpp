@@ -6,6 +6,7 @@
 #include "gui/SDL_Extensions.h"
 #include "CPlayerInterface.h"
 #include "../lib/filesystem/Filesystem.h"
+#include "../lib/CStopWatch.h"
 
 extern CGuiHandler GH; //global gui handler
 
@@ -567,6 +568,11 @@ bool CVideoPlayer::playVideo(int x, int y, SDL_Surface *dst, bool stopOnKey)
 	return true;
 }
 
+void CVideoPlayer::benchmark(std::string name)
+{
+	logGlobal->warnStream() << "Video benchmark is not supported by this video player";
+}
+
 #else
 
 #ifdef _MSC_VER
@@ -597,6 +603,8 @@ static si64 lodSeek(void * opaque, si64 pos, int whence)
 	return video->data->seek(pos);
 }
 
+const double CVideoPlayer::maxDelay = 0.5;
+
 CVideoPlayer::CVideoPlayer()
 {
 	format = nullptr;
@@ -606,6 +614,9 @@ CVideoPlayer::CVideoPlayer()
 	overlay = nullptr;
 	dest = nullptr;
 	context = nullptr;
+	terminate = false;
+	decoderFinished = false;
+	playbackStarted = false;
 
 	// Register codecs. TODO: May be overkill. Should call a
 	// combination of av_register_input_format() /
@@ -618,16 +629,14 @@ bool CVideoPlayer::open(std::string fname)
 	return open(fname, true, false);
 }
 
-// loop = to loop through the video
-// useOverlay = directly write to the screen.
-bool CVideoPlayer::open(std::string fname, bool loop, bool useOverlay)
+bool CVideoPlayer::openDecoder(std::string fname, bool loop)
 {
 	close();
 
 	this->fname = fname;
-	refreshWait = 3;
-	refreshCount = -1;
 	doLoop = loop;
+	lastPts = 0;
+	loopOffset = 0;
 
 	ResourceID resource(std::string("Video/") + fname, EResType::VIDEO);
 
@@ -703,6 +712,23 @@ bool CVideoPlayer::open(std::string fname, bool loop, bool useOverlay)
 	// Allocate video frame
 	frame = avcodec_alloc_frame();
 
+	// H3 videos have constant frame rate, only used if packets have no timestamps
+	AVRational frameRate = format->streams[stream]->avg_frame_rate;
+	frameDuration = (frameRate.num > 0 && frameRate.den > 0) ? 1 / av_q2d(frameRate) : 1.0 / 15;
+
+	pos.w = codecContext->width;
+	pos.h = codecContext->height;
+
+	return true;
+}
+
+// loop = to loop through the video
+// useOverlay = directly write to the screen.
+bool CVideoPlayer::open(std::string fname, bool loop, bool useOverlay)
+{
+	if (!openDecoder(fname, loop))
+		return false;
+
 	// Allocate a place to put our YUV image on that screen
 	if (useOverlay)
 	{
@@ -762,22 +788,19 @@ bool CVideoPlayer::open(std::string fname, bool loop, bool useOverlay)
 	if (sws == nullptr)
 		return false;
 
-	pos.w = codecContext->width;
-	pos.h = codecContext->height;
+	// overlays can be accessed only from main thread, they are still decoded synchronously
+	if (dest)
+		startDecoder();
 
 	return true;
 }
 
-// Read the next frame. Return false on error/end of file.
-bool CVideoPlayer::nextFrame()
+bool CVideoPlayer::decodeFrame(double & pts)
 {
 	AVPacket packet;
 	int frameFinished = 0;
 	bool gotError = false;
 
-	if (sws == nullptr)
-		return false;
-
 	while(!frameFinished)
 	{
 		int ret = av_read_frame(format, &packet);
@@ -789,6 +812,7 @@ bool CVideoPlayer::nextFrame()
 				// Rewind
 				if (av_seek_frame(format, stream, 0, 0) < 0)
 					break;
+				loopOffset = lastPts + frameDuration;
 				gotError = true;
 			}
 			else
@@ -808,40 +832,195 @@ bool CVideoPlayer::nextFrame()
 				// Did we get a video frame?
 				if (frameFinished)
 				{
-					AVPicture pict;
+					si64 timestamp = packet.pts != AV_NOPTS_VALUE ? packet.pts : packet.dts;
+					if (timestamp != AV_NOPTS_VALUE)
+						lastPts = loopOffset + timestamp * av_q2d(format->streams[stream]->time_base);
+					else
+						lastPts += frameDuration;
+					pts = lastPts;
+				}
+			}
 
-					if (overlay) {
-						SDL_LockYUVOverlay(overlay);
+			av_free_packet(&packet);
+		}
+	}
 
-						pict.data[0] = overlay->pixels[0];
-						pict.data[1] = overlay->pixels[2];
-						pict.data[2] = overlay->pixels[1];
+	return frameFinished != 0;
+}
 
-						pict.linesize[0] = overlay->pitches[0];
-						pict.linesize[1] = overlay->pitches[2];
-						pict.linesize[2] = overlay->pitches[1];
+void CVideoPlayer::convertFrame(SDL_Surface * surf)
+{
+	AVPicture pict;
 
-						sws_scale(sws, frame->data, frame->linesize,
-								  0, codecContext->height, pict.data, pict.linesize);
+	pict.data[0] = (ui8 *)surf->pixels;
+	pict.linesize[0] = surf->pitch;
 
-						SDL_UnlockYUVOverlay(overlay);
-					}
-					else
-					{
-						pict.data[0] = (ui8 *)dest->pixels;
-						pict.linesize[0] = dest->pitch;
+	sws_scale(sws, frame->data, frame->linesize,
+			  0, codecContext->height, pict.data, pict.linesize);
+}
 
-						sws_scale(sws, frame->data, frame->linesize,
-								  0, codecContext->height, pict.data, pict.linesize);
-					}
-				}
-			}
+void CVideoPlayer::startDecoder()
+{
+	for (size_t i=0; i<queuedFrames; i++)
+		freeSurfaces.push_back(CSDL_Ext::newSurface(codecContext->width, codecContext->height));
 
-			av_free_packet(&packet);
+	terminate = false;
+	decoderFinished = false;
+	playbackStarted = false;
+	decoder = boost::thread(&CVideoPlayer::decodingLoop, this);
+}
+
+void CVideoPlayer::stopDecoder()
+{
+	if (decoder.joinable())
+	{
+		{
+			boost::unique_lock<boost::mutex> lock(mx);
+			terminate = true;
 		}
+		cond.notify_all();
+		decoder.join();
 	}
 
-	return frameFinished != 0;
+	for (auto & decoded : decodedFrames)
+		SDL_FreeSurface(decoded.surf);
+	for (auto & surf : freeSurfaces)
+		SDL_FreeSurface(surf);
+
+	decodedFrames.clear();
+	freeSurfaces.clear();
+}
+
+void CVideoPlayer::decodingLoop()
+{
+	while (true)
+	{
+		SDL_Surface * surf;
+		{
+			boost::unique_lock<boost::mutex> lock(mx);
+			while (freeSurfaces.empty() && !terminate)
+				cond.wait(lock);
+
+			if (terminate)
+				return;
+
+			surf = freeSurfaces.back();
+			freeSurfaces.pop_back();
+		}
+
+		DecodedFrame decoded;
+		decoded.surf = surf;
+
+		const bool gotFrame = decodeFrame(decoded.pts);
+		if (gotFrame)
+			convertFrame(surf);
+
+		{
+			boost::unique_lock<boost::mutex> lock(mx);
+			if (gotFrame)
+			{
+				decodedFrames.push_back(decoded);
+			}
+			else
+			{
+				freeSurfaces.push_back(surf);
+				decoderFinished = true;
+			}
+		}
+		cond.notify_all();
+
+		if (!gotFrame)
+			return;
+	}
+}
+
+void CVideoPlayer::presentFrame()
+{
+	freeSurfaces.push_back(dest);
+	dest = decodedFrames.front().surf;
+	decodedFrames.pop_front();
+	cond.notify_all();
+}
+
+bool CVideoPlayer::presentDueFrame()
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+
+	// wait for first frame, otherwise empty surface would be shown
+	while (!playbackStarted && decodedFrames.empty() && !decoderFinished)
+		cond.wait(lock);
+
+	if (decodedFrames.empty())
+		return false;
+
+	const ui32 now = SDL_GetTicks();
+	const double framePts = decodedFrames.front().pts;
+
+	// first frame, or GUI was too busy to show frames in time - continue from current frame
+	if (!playbackStarted || (now - startTicks) / 1000.0 - framePts > maxDelay)
+	{
+		startTicks = now - ui32(framePts * 1000);
+		playbackStarted = true;
+	}
+
+	const double time = (now - startTicks) / 1000.0;
+
+	bool presented = false;
+	while (!decodedFrames.empty() && decodedFrames.front().pts <= time)
+	{
+		presentFrame();
+		presented = true;
+	}
+	return presented;
+}
+
+// Read the next frame. Return false on error/end of file.
+bool CVideoPlayer::nextFrame()
+{
+	if (sws == nullptr)
+		return false;
+
+	if (decoder.joinable())
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		while (decodedFrames.empty() && !decoderFinished)
+			cond.wait(lock);
+
+		if (decodedFrames.empty())
+			return false;
+
+		presentFrame();
+		return true;
+	}
+
+	double pts;
+	if (!decodeFrame(pts))
+		return false;
+
+	if (overlay)
+	{
+		AVPicture pict;
+
+		SDL_LockYUVOverlay(overlay);
+
+		pict.data[0] = overlay->pixels[0];
+		pict.data[1] = overlay->pixels[2];
+		pict.data[2] = overlay->pixels[1];
+
+		pict.linesize[0] = overlay->pitches[0];
+		pict.linesize[1] = overlay->pitches[2];
+		pict.linesize[2] = overlay->pitches[1];
+
+		sws_scale(sws, frame->data, frame->linesize,
+				  0, codecContext->height, pict.data, pict.linesize);
+
+		SDL_UnlockYUVOverlay(overlay);
+	}
+	else
+	{
+		convertFrame(dest);
+	}
+	return true;
 }
 
 void CVideoPlayer::show( int x, int y, SDL_Surface *dst, bool update )
@@ -867,32 +1046,36 @@ void CVideoPlayer::update( int x, int y, SDL_Surface *dst, bool forceRedraw, boo
 	if (sws == nullptr)
 		return;
 
-	if (refreshCount <= 0)
+	bool finished = false;
+	const bool presented = presentDueFrame();
+	if (!presented)
 	{
-		refreshCount = refreshWait;
-		if (nextFrame())
-			show(x,y,dst,update);
-		else
-		{
-			open(fname);
-			nextFrame();
+		boost::unique_lock<boost::mutex> lock(mx);
+		finished = decoderFinished && decodedFrames.empty();
+	}
 
-			// The y position is wrong at the first frame.
-			// Note: either the windows player or the linux player is
-			// broken. Compensate here until the bug is found.
-			show(x, y--, dst, update);
-		}
+	if (presented)
+		show(x,y,dst,update);
+	else if (finished)
+	{
+		open(fname);
+		nextFrame();
+
+		// The y position is wrong at the first frame.
+		// Note: either the windows player or the linux player is
+		// broken. Compensate here until the bug is found.
+		show(x, y--, dst, update);
 	}
 	else
 	{
 		redraw(x, y, dst, update);
 	}
-
-	refreshCount --;
 }
 
 void CVideoPlayer::close()
 {
+	stopDecoder();
+
 	fname = "";
 	if (sws)
 	{
@@ -942,6 +1125,43 @@ void CVideoPlayer::close()
 	}
 }
 
+void CVideoPlayer::benchmark(std::string name)
+{
+	CVideoPlayer player;
+	if (!player.openDecoder(name, false))
+	{
+		logGlobal->errorStream() << "Video benchmark: failed to open " << name;
+		return;
+	}
+
+	const int width = player.codecContext->width;
+	const int height = player.codecContext->height;
+
+	// format does not matter much, use the most common screen format
+	player.sws = sws_getContext(width, height, player.codecContext->pix_fmt, width, height,
+								PIX_FMT_RGB32, SWS_BICUBIC, nullptr, nullptr, nullptr);
+	if (player.sws == nullptr)
+		return;
+
+	AVPicture pict;
+	avpicture_alloc(&pict, PIX_FMT_RGB32, width, height);
+
+	CStopWatch timer;
+	int frames = 0;
+	double pts = 0;
+	while (player.decodeFrame(pts))
+	{
+		sws_scale(player.sws, player.frame->data, player.frame->linesize, 0, height, pict.data, pict.linesize);
+		frames++;
+	}
+	const si64 time = std::max<si64>(timer.getDiff(), 1);
+
+	avpicture_free(&pict);
+
+	logGlobal->infoStream() << "Video benchmark: " << name << ", " << width << "x" << height << ", " << frames << " frames ("
+		<< pts << " s of video) decoded in " << time << " ms, " << frames * 1000 / time << " fps";
+}
+
 // Plays a video. Only works for overlays.
 bool CVideoPlayer::playVideo(int x, int y, SDL_Surface *dst, bool stopOnKey)
 {
@@ -211,6 +211,8 @@ public:
 
 	bool openAndPlayVideo(std::string name, int x, int y, SDL_Surface *dst, bool stopOnKey = false); //opens video, calls playVideo, closes video; returns playVideo result (if whole video has been played)
 	bool playVideo(int x, int y, SDL_Surface *dst, bool stopOnKey = false); //plays whole opened video; returns: true when whole video has been shown, false when it has been interrupted
+
+	static void benchmark(std::string name); //not supported by this player
 };
 
 #else
@@ -232,6 +234,13 @@ extern "C" {
 
 class CVideoPlayer : public IMainVideoPlayer
 {
+	/// frame converted to format of dest surface
+	struct DecodedFrame
+	{
+		SDL_Surface * surf;
+		double pts; // presentation time, in seconds since start of playback
+	};
+
 	int stream;					// stream index in video
 	AVFormatContext *format;
 	AVCodecContext *codecContext; // codec context for stream
@@ -247,12 +256,39 @@ class CVideoPlayer : public IMainVideoPlayer
 	SDL_Rect destRect;			// valid when dest is used
 	SDL_Rect pos;				// destination on screen
 
-	int refreshWait; // Wait several refresh before updating the image
-	int refreshCount;
 	bool doLoop;				// loop through video
 
+	double lastPts;				// presentation time of last decoded frame
+	double loopOffset;			// duration of all previous loops of video
+	double frameDuration;		// used for frames without timestamps
+
+	// Decoding thread, used when video is drawn to surface.
+	// While it runs, only this thread may access ffmpeg contexts
+	boost::thread decoder;
+	boost::mutex mx;
+	boost::condition_variable cond;
+	std::deque<DecodedFrame> decodedFrames;		// frames ready to be shown, oldest first
+	std::vector<SDL_Surface *> freeSurfaces;	// surfaces for decoder, their number limits number of queued frames
+	bool terminate;
+	bool decoderFinished;		// end of video or error was reached, no more frames will be queued
+	bool playbackStarted;
+	ui32 startTicks;			// value of SDL_GetTicks() at presentation time 0
+
+	static const size_t queuedFrames = 4;
+	static const double maxDelay; // if playback is delayed more than this, it continues from current frame instead of skipping frames
+
 	bool playVideo(int x, int y, SDL_Surface *dst, bool stopOnKey);
 	bool open(std::string fname, bool loop, bool useOverlay = false);
+	bool openDecoder(std::string fname, bool loop); // opens video file and codec
+
+	bool decodeFrame(double & pts); // decodes next frame into "frame", returns false on end of file or error
+	void convertFrame(SDL_Surface * surf); // converts "frame" into surface with format of dest
+
+	void startDecoder();
+	void stopDecoder();
+	void decodingLoop();
+	void presentFrame(); // replaces dest with oldest decoded frame, mx must be locked
+	bool presentDueFrame(); // presents latest frame which presentation time has passed, false if there is none
 
 public:
 	CVideoPlayer();
@@ -270,6 +306,9 @@ public:
 	// Opens video, calls playVideo, closes video; returns playVideo result (if whole video has been played)
 	bool openAndPlayVideo(std::string name, int x, int y, SDL_Surface *dst, bool stopOnKey = false);
 
+	// Decodes whole video as fast as possible without displaying it and logs achieved fps. Does not need screen
+	static void benchmark(std::string name);
+
 	//TODO:
 	bool wait(){return false;};
 	int curFrame() const {return -1;};
@@ -30,6 +30,7 @@
 #include "Client.h"
 #include "CPreGame.h"
 #include "battle/CBattleInterface.h"
+#include "CAssetPrefetcher.h"
 #include "../lib/CThreadHelper.h"
 #include "../lib/CScriptingModule.h"
 #include "../lib/RegisterTypes.h"
@@ -81,10 +82,16 @@ public:
 
 static CApplier<CBaseForCLApply> *applier = nullptr;
 
+//GUI is redrawn after each batch - limit its size and duration so it stays responsive during long AI turns
+static const size_t MAX_PACKS_IN_BATCH = 64;
+static const ui32 MAX_BATCH_TIME = 20; //ms, packs left after that time are applied in next batch
+
 void CClient::init()
 {
 	hotSeat = false;
 	connectionHandler = nullptr;
+	packApplier = nullptr;
+	receiverFinished = false;
 	pathInfo = nullptr;
 	applier = new CApplier<CBaseForCLApply>;
 	registerTypes2(*applier);
@@ -135,6 +142,21 @@ void CClient::waitForMoveAndSend(PlayerColor color)
 void CClient::run()
 {
 	setThreadName("CClient::run");
+	{
+		boost::unique_lock<boost::mutex> lock(packsMx);
+		receiverFinished = false;
+	}
+	packApplier = new boost::thread(&CClient::applyPacks, this);
+
+	auto finishReceiving = [this]
+	{
+		{
+			boost::unique_lock<boost::mutex> lock(packsMx);
+			receiverFinished = true;
+		}
+		packsCond.notify_all();
+	};
+
 	try
 	{
 		while(!terminate)
@@ -147,7 +169,11 @@ void CClient::run()
 				break;
 			}
 
-			handlePack(pack);
+			{
+				boost::unique_lock<boost::mutex> lock(packsMx);
+				receivedPacks.push_back(pack);
+			}
+			packsCond.notify_one();
 		}
 	} 
 	//catch only asio exceptions
@@ -155,12 +181,68 @@ void CClient::run()
 	{	
         logNetwork->errorStream() << "Lost connection to server, ending listening thread!";
         logNetwork->errorStream() << e.what();
+		finishReceiving();
 		if(!terminate) //rethrow (-> boom!) only if closing connection was unexpected
 		{
             logNetwork->errorStream() << "Something wrong, lost connection while game is still ongoing...";
 			throw;
 		}
+		return;
+	}
+	finishReceiving();
+}
+
+void CClient::applyPacks()
+{
+	setThreadName("CClient::applyPacks");
+	std::vector<CPack *> batch;
+	while(true)
+	{
+		{
+			boost::unique_lock<boost::mutex> lock(packsMx);
+			while(receivedPacks.empty() && !receiverFinished && !terminate)
+				packsCond.wait(lock);
+
+			if(terminate || receivedPacks.empty())
+				break;
+
+			while(!receivedPacks.empty() && batch.size() < MAX_PACKS_IN_BATCH)
+			{
+				batch.push_back(receivedPacks.front());
+				receivedPacks.pop_front();
+			}
+		}
+
+		{
+			boost::unique_lock<boost::recursive_mutex> guiLock(*LOCPLINT->pim);
+			const ui32 batchStart = SDL_GetTicks();
+			size_t applied = 0;
+			//at least one pack is applied, so slow packs can't stall the queue
+			for(; applied < batch.size() && (!applied || SDL_GetTicks() - batchStart < MAX_BATCH_TIME); applied++)
+			{
+				if(terminate) //one of packs ended the game
+					delete batch[applied];
+				else
+					handlePack(batch[applied]);
+			}
+
+			if(applied < batch.size())
+			{
+				boost::unique_lock<boost::mutex> lock(packsMx);
+				receivedPacks.insert(receivedPacks.begin(), batch.begin() + applied, batch.end());
+			}
+			batch.clear();
+
+			for(auto & i : playerint)
+				i.second->packBatchFinished();
+		}
+		GH.notifyActivity(); //packs may start animations or change displayed data
 	}
+
+	boost::unique_lock<boost::mutex> lock(packsMx);
+	for(auto pack : receivedPacks)
+		delete pack;
+	receivedPacks.clear();
 }
 
 void CClient::save(const std::string & fname)
@@ -299,11 +381,15 @@ void CClient::loadGame( const std::string & fname )
 // 	}
 }
 
-void CClient::newGame( CConnection *con, StartInfo *si )
+void CClient::newGame( CConnection *con, StartInfo *si, CServerHandler *localServer /*= nullptr*/ )
 {
 	enum {SINGLE, HOST, GUEST} networkMode = SINGLE;
 
-	if (con == nullptr) 
+	if (con == nullptr && localServer)
+	{
+		serv = localServer->connectToServer();
+	}
+	else if (con == nullptr) 
 	{
 		CServerHandler sh;
 		serv = sh.connectToServer();
@@ -508,7 +594,6 @@ void CClient::handlePack( CPack * pack )
 	CBaseForCLApply *apply = applier->apps[typeList.getTypeID(pack)]; //find the applier
 	if(apply)
 	{
-		boost::unique_lock<boost::recursive_mutex> guiLock(*LOCPLINT->pim);
 		apply->applyOnClBefore(this,pack);
         logNetwork->traceStream() << "\tMade first apply on cl";
 		gs->apply(pack);
@@ -523,14 +608,6 @@ void CClient::handlePack( CPack * pack )
 	delete pack;
 }
 
-void CClient::updatePaths()
-{
-	//TODO? lazy evaluation? paths now can get recalculated multiple times upon various game events
-	const CGHeroInstance *h = getSelectedHero();
-	if (h)//if we have selected hero...
-		calculatePaths(h);
-}
-
 void CClient::finishCampaign( shared_ptr<CCampaignState> camp )
 {
 }
@@ -557,6 +634,8 @@ void CClient::stopConnection()
 	{
 		if(connectionHandler->get_id() != boost::this_thread::get_id())
 			connectionHandler->join();
+		else
+			connectionHandler->detach(); //thread can't join itself, it ends after returning from here
 
         logNetwork->infoStream() << "Connection handler thread joined";
 
@@ -564,6 +643,20 @@ void CClient::stopConnection()
 		connectionHandler = nullptr;
 	}
 
+	if(packApplier)//end pack applier, packs may end the game on its thread
+	{
+		packsCond.notify_all();
+		if(packApplier->get_id() != boost::this_thread::get_id())
+			packApplier->join();
+		else
+			packApplier->detach(); //stopped by pack it applies, like UpdateCampaignState
+
+		logNetwork->infoStream() << "Pack applier thread joined";
+
+		delete packApplier;
+		packApplier = nullptr;
+	}
+
 	if (serv) //and delete connection
 	{
 		serv->close();
@@ -603,6 +696,8 @@ void CClient::battleStarted(const BattleInfo * info)
 
 	if(!gNoGUI && (!!att || !!def || gs->scenarioOps->mode == StartInfo::DUEL))
 	{
+		CCS->prefetcher->prefetchBattle(info); //loads in parallel with interface constructor
+
 		boost::unique_lock<boost::recursive_mutex> un(*LOCPLINT->pim);
 		auto bi = new CBattleInterface(leftSide.armyObject, rightSide.armyObject, leftSide.hero, rightSide.hero,
 			Rect((screen->w - 800)/2, 
@@ -818,17 +913,30 @@ CConnection * CServerHandler::connectToServer()
 	return ret;
 }
 
+void CServerHandler::stopServer()
+{
+	if(!serverThread)
+		return;
+
+	CConnection *c = connectToServer();
+	*c << ui8(0); //quit
+	c->close();
+	delete c;
+	serverThread->join();
+}
+
 CServerHandler::CServerHandler(bool runServer /*= false*/)
 {
 	serverThread = nullptr;
 	shared = nullptr;
 	port = boost::lexical_cast<std::string>(settings["server"]["port"].Float());
 	verbose = true;
+	keepRunning = false;
 
-	boost::interprocess::shared_memory_object::remove("vcmi_memory"); //if the application has previously crashed, the memory may not have been removed. to avoid problems - try to destroy it
+	boost::interprocess::shared_memory_object::remove(SharedMem::getName(port).c_str()); //if the application has previously crashed, the memory may not have been removed. to avoid problems - try to destroy it
 	try
 	{
-		shared = new SharedMem();
+		shared = new SharedMem(SharedMem::getName(port));
     } HANDLE_EXCEPTIONC(logNetwork->errorStream() << "Cannot open interprocess memory: ";)
 }
 
@@ -842,7 +950,7 @@ void CServerHandler::callServer()
 {
 	setThreadName("CServerHandler::callServer");
 	std::string logName = VCMIDirs::get().userCachePath() + "/server_log.txt";
-	std::string comm = VCMIDirs::get().serverPath() + " --port=" + port + " > " + logName;
+	std::string comm = VCMIDirs::get().serverPath() + " --port=" + port + (keepRunning ? " --keepRunning" : "") + " > " + logName;
 	int result = std::system(comm.c_str());
 	if (result == 0)
         logNetwork->infoStream() << "Server closed correctly";
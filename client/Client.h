@@ -40,12 +40,14 @@ public:
 	boost::thread *serverThread; //thread that called system to run server
 	SharedMem *shared; //interprocess memory (for waiting for server)
 	bool verbose; //whether to print log msgs
+	bool keepRunning; //server started by this handler serves several games, until it gets quit request
 	std::string port; //port number in text form
 
 	//functions setting up local server
 	void startServer(); //creates a thread with callServer
 	void waitForServer(); //waits till server is ready
 	CConnection * connectToServer(); //connects to server
+	void stopServer(); //asks server started with keepRunning to quit and waits for it
 
 	//////////////////////////////////////////////////////////////////////////
 	static CConnection * justConnectToServer(const std::string &host = "", const std::string &port = ""); //connects to given host without taking any other actions (like setting up server)
@@ -139,7 +141,7 @@ public:
 	~CClient(void);
 
 	void init();
-	void newGame(CConnection *con, StartInfo *si); //con - connection to server
+	void newGame(CConnection *con, StartInfo *si, CServerHandler *localServer = nullptr); //con - connection to server; localServer - already set up server to connect to if there is no connection
 
 	void loadNeutralBattleAI();
 	void installNewPlayerInterface(shared_ptr<CGameInterface> gameInterface, boost::optional<PlayerColor> color);
@@ -150,16 +152,22 @@ public:
 	void stopConnection();
 	void save(const std::string & fname);
 	void loadGame(const std::string & fname);
-	void run();
+	void run(); //receives packs from server and queues them for packApplier
+	void applyPacks(); //applies received packs in batches, each under single lock of GUI mutex
 	void campaignMapFinished( shared_ptr<CCampaignState> camp );
 	void finishCampaign( shared_ptr<CCampaignState> camp );
 	void proposeNextMission(shared_ptr<CCampaignState> camp);
 	void invalidatePaths(const CGHeroInstance *h = nullptr); //invalidates paths for hero h or for any hero if h is nullptr => they'll got recalculated when the next query comes
 	void calculatePaths(const CGHeroInstance *h);
-	void updatePaths(); //calls calculatePaths for same hero for which we previously calculated paths
 
 	bool terminate;	// tell to terminate
 	boost::thread *connectionHandler; //thread running run() method
+	boost::thread *packApplier; //thread running applyPacks() method
+
+	std::deque<CPack *> receivedPacks; //deserialized packs, waiting to be applied
+	bool receiverFinished; //run() will not queue any more packs
+	boost::mutex packsMx; //protects the variables above
+	boost::condition_variable packsCond;
 
 	//////////////////////////////////////////////////////////////////////////
 	virtual PlayerColor getLocalPlayer() const override;
@@ -224,7 +232,7 @@ public:
 
 	int sendRequest(const CPack *request, PlayerColor player); //returns ID given to that request
 
-	void handlePack( CPack * pack ); //applies the given pack and deletes it
+	void handlePack( CPack * pack ); //applies the given pack and deletes it, GUI mutex must be locked
 	void battleStarted(const BattleInfo * info);
 	void commenceTacticPhaseForInt(shared_ptr<CBattleGameInterface> battleInt); //will be called as separate thread
 
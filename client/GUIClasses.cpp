@@ -1800,6 +1800,7 @@ void CMinorResDataBar::showAll(SDL_Surface * to)
 CMinorResDataBar::CMinorResDataBar()
 {
 	bg = BitmapHandler::loadBitmap("KRESBAR.bmp");
+	CSDL_Ext::unshare(bg);
 	SDL_SetColorKey(bg,SDL_SRCCOLORKEY,SDL_MapRGB(bg->format,0,255,255));
 	graphics->blueToPlayersAdv(bg,LOCPLINT->playerID);
 	pos.x = 7;
@@ -247,6 +247,7 @@ void Graphics::loadHeroFlagsDetail(std::pair<std::vector<CDefEssential *> Graphi
 		}
 		for(auto & curImg : curImgs)
 		{
+			CSDL_Ext::unshare(curImg.bitmap);
 			SDL_SetColorKey(curImg.bitmap, SDL_SRCCOLORKEY,
 				SDL_MapRGB(curImg.bitmap->format, 0, 255, 255)
 				);
@@ -280,7 +281,7 @@ void Graphics::loadHeroFlags()
     logGlobal->infoStream() << "Loading and transforming heroes' flags: "<<th.getDiff();
 }
 
-void Graphics::blueToPlayersAdv(SDL_Surface * sur, PlayerColor player)
+void Graphics::blueToPlayersAdv(SDL_Surface * & sur, PlayerColor player)
 {
 	if(sur->format->palette)
 	{
@@ -298,6 +299,7 @@ void Graphics::blueToPlayersAdv(SDL_Surface * sur, PlayerColor player)
             logGlobal->errorStream() << "Wrong player id in blueToPlayersAdv (" << player << ")!";
 			return;
 		}
+		CSDL_Ext::unshare(sur);
 		SDL_SetColors(sur, palette, 224, 32);
 	}
 	else
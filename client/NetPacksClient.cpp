@@ -436,7 +436,7 @@ void SetAvailableCreatures::applyCl( CClient *cl )
 
 	PlayerColor p;
 	if(dw->ID == Obj::WAR_MACHINE_FACTORY) //War Machines Factory is not flaggable, it's "owned" by visitor
-		p = cl->getTile(dw->visitablePos())->visitableObjects.back()->tempOwner;
+		p = cl->getTile(dw->visitablePos())->visitableObjects().back()->tempOwner;
 	else
 		p = dw->tempOwner;
 
@@ -651,6 +651,8 @@ void BattleResult::applyFirstCl( CClient *cl )
 {
 	BATTLE_INTERFACE_CALL_IF_PRESENT_FOR_BOTH_SIDES(battleEnd,this);
 	cl->battleFinished();
+	if(GS(cl)->initialOpts->mode == StartInfo::DUEL)
+		setDuelResult(*this);
 }
 
 void BattleStackMoved::applyFirstCl( CClient *cl )
@@ -714,7 +716,7 @@ void BattleResultsApplied::applyCl( CClient *cl )
 	INTERFACE_CALL_IF_PRESENT(PlayerColor::UNFLAGGABLE, battleResultsApplied);
 	if(GS(cl)->initialOpts->mode == StartInfo::DUEL)
 	{
-		handleQuit();
+		handleDuelEnd();
 	}
 }
 
@@ -877,7 +879,7 @@ void OpenWindow::applyCl(CClient *cl)
 			const CGObjectInstance *obj = cl->getObj(ObjectInstanceID(id1));
 			const CGHeroInstance *hero = cl->getHero(ObjectInstanceID(id2));
 			const IMarket *market = IMarket::castFrom(obj);
-			INTERFACE_CALL_IF_PRESENT(cl->getTile(obj->visitablePos())->visitableObjects.back()->tempOwner, showMarketWindow, market, hero);
+			INTERFACE_CALL_IF_PRESENT(cl->getTile(obj->visitablePos())->visitableObjects().back()->tempOwner, showMarketWindow, market, hero);
 		}
 		break;
 	case HILL_FORT_WINDOW:
@@ -885,7 +887,7 @@ void OpenWindow::applyCl(CClient *cl)
 			//displays Hill fort window
 			const CGObjectInstance *obj = cl->getObj(ObjectInstanceID(id1));
 			const CGHeroInstance *hero = cl->getHero(ObjectInstanceID(id2));
-			INTERFACE_CALL_IF_PRESENT(cl->getTile(obj->visitablePos())->visitableObjects.back()->tempOwner, showHillFortWindow, obj, hero);
+			INTERFACE_CALL_IF_PRESENT(cl->getTile(obj->visitablePos())->visitableObjects().back()->tempOwner, showHillFortWindow, obj, hero);
 		}
 		break;
 	case PUZZLE_MAP:
@@ -909,7 +911,7 @@ void CenterView::applyCl(CClient *cl)
 
 void NewObject::applyCl(CClient *cl)
 {
-	cl->updatePaths();
+	cl->invalidatePaths();
 
 	const CGObjectInstance *obj = cl->getObj(id);
 	CGI->mh->printObject(obj);
@@ -932,7 +934,7 @@ void SetAvailableArtifacts::applyCl(CClient *cl)
 	{
 		const CGBlackMarket *bm = dynamic_cast<const CGBlackMarket *>(cl->getObj(ObjectInstanceID(id)));
 		assert(bm);
-		INTERFACE_CALL_IF_PRESENT(cl->getTile(bm->visitablePos())->visitableObjects.back()->tempOwner, availableArtifactsChanged, bm);
+		INTERFACE_CALL_IF_PRESENT(cl->getTile(bm->visitablePos())->visitableObjects().back()->tempOwner, availableArtifactsChanged, bm);
 	}
 }
 
@@ -168,6 +168,8 @@ CBattleInterface::CBattleInterface(const CCreatureSet * army1, const CCreatureSe
 		ui8 siegeLevel = curInt->cb->battleGetSiegeLevel();
 		if(siegeLevel >= 2) //citadel or castle
 		{
+			CSDL_Ext::unshare(background);
+
 			//print moat/mlip
 			SDL_Surface * moat = BitmapHandler::loadBitmap( siegeH->getSiegeName(13) ),
 				* mlip = BitmapHandler::loadBitmap( siegeH->getSiegeName(14) );
@@ -364,6 +366,7 @@ CBattleInterface::CBattleInterface(const CCreatureSet * army1, const CCreatureSe
 			idToObstacle[ID] = CDefHandler::giveDef(elem->getInfo().defName);
 			for(auto & _n : idToObstacle[ID]->ourImages)
 			{
+				CSDL_Ext::unshare(_n.bitmap);
 				SDL_SetColorKey(_n.bitmap, SDL_SRCCOLORKEY, SDL_MapRGB(_n.bitmap->format,0,255,255));
 			}
 		}
@@ -3044,6 +3047,8 @@ void CBattleInterface::show(SDL_Surface * to)
 	showProjectiles(to);
 
 	updateBattleAnimations();
+	if(!pendingAnims.empty())
+		GH.notifyActivity(); //animations advance each frame without any input, keep full framerate
 
 	SDL_SetClipRect(to, &buf); //restoring previous clip_rect
 
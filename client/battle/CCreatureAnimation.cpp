@@ -6,6 +6,7 @@
 #include "../../lib/vcmi_endian.h"
 #include "../gui/SDL_Extensions.h"
 #include "../gui/SDL_Pixels.h"
+#include "../CImageCache.h"
 
 #include "../../lib/filesystem/Filesystem.h"
 #include "../../lib/filesystem/CBinaryReader.h"
@@ -144,21 +145,13 @@ void CCreatureAnimation::setType(CCreatureAnim::EAnimType type)
 	play();
 }
 
-CCreatureAnimation::CCreatureAnimation(std::string name, TSpeedController controller)
-    : defName(name),
-      speed(0.1),
-      currentFrame(0),
-      elapsedTime(0),
-	  type(CCreatureAnim::HOLDING),
-	  border(CSDL_Ext::makeColor(0, 0, 0, 0)),
-      speedController(controller),
-      once(false)
+CCreatureAnimationFrames::CCreatureAnimationFrames(const std::string & name)
 {
 	// separate block to avoid accidental use of "data" after it was moved into "pixelData"
 	{
 		ResourceID resID(std::string("SPRITES/") + name, EResType::ANIMATION);
 
-		auto data = CResourceHandler::get()->load(resID)->readAll();
+		auto data = animationCache.readAll(resID);
 
 		pixelData = std::move(data.first);
 		pixelDataSize = data.second;
@@ -178,7 +171,7 @@ CCreatureAnimation::CCreatureAnimation(std::string name, TSpeedController contro
 		elem.r = reader.readUInt8();
 		elem.g = reader.readUInt8();
 		elem.b = reader.readUInt8();
-		elem.unused = 0;
+		elem.unused = 255;
 	}
 
 	for (int i=0; i<totalBlocks; i++)
@@ -190,13 +183,183 @@ CCreatureAnimation::CCreatureAnimation(std::string name, TSpeedController contro
 		reader.skip(4 + 4 + 13 * totalInBlock); // some unused data
 
 		for (int j=0; j<totalInBlock; j++)
-			dataOffsets[groupID].push_back(reader.readUInt32());
+		{
+			Frame frame;
+			frame.dataOffset = reader.readUInt32();
+			frame.surf = nullptr;
+			frame.mirrored = nullptr;
+			frame.leftMargin = frame.rightMargin = frame.topMargin = 0;
+			groups[groupID].push_back(frame);
+		}
 	}
 
 	// if necessary, add one frame into vcmi-only group DEAD
-	if (dataOffsets.count(CCreatureAnim::DEAD) == 0)
-		dataOffsets[CCreatureAnim::DEAD].push_back(dataOffsets[CCreatureAnim::DEATH].back());
+	if (groups.count(CCreatureAnim::DEAD) == 0)
+		groups[CCreatureAnim::DEAD].push_back(groups[CCreatureAnim::DEATH].back());
+}
+
+CCreatureAnimationFrames::~CCreatureAnimationFrames()
+{
+	for (auto & group : groups)
+	{
+		for (auto & frame : group.second)
+		{
+			SDL_FreeSurface(frame.surf);
+			SDL_FreeSurface(frame.mirrored);
+		}
+	}
+}
+
+// frames that are in use by at least one animation, key is uppercase def name
+static std::map<std::string, std::weak_ptr<CCreatureAnimationFrames>> loadedFrames;
+static boost::mutex loadedFramesMx;
+
+std::shared_ptr<CCreatureAnimationFrames> CCreatureAnimationFrames::get(const std::string & name)
+{
+	boost::unique_lock<boost::mutex> lock(loadedFramesMx);
+
+	std::string key = boost::to_upper_copy(name);
+	auto ret = loadedFrames[key].lock();
+	if (!ret)
+	{
+		ret = std::make_shared<CCreatureAnimationFrames>(name);
+		loadedFrames[key] = ret;
+	}
+	return ret;
+}
+
+int CCreatureAnimationFrames::getWidth() const
+{
+	return fullWidth;
+}
+
+int CCreatureAnimationFrames::getHeight() const
+{
+	return fullHeight;
+}
+
+int CCreatureAnimationFrames::framesInGroup(int group) const
+{
+	if(groups.count(group) == 0)
+		return 0;
+
+	return groups.at(group).size();
+}
+
+SDL_Surface * CCreatureAnimationFrames::createSurface(int width, int height) const
+{
+	SDL_Surface * ret = SDL_CreateRGBSurface(SDL_SWSURFACE, std::max(width, 1), std::max(height, 1), 8, 0, 0, 0, 0);
+	SDL_SetColors(ret, const_cast<SDL_Color *>(palette.data()), 0, palette.size());
+	return ret;
+}
+
+void CCreatureAnimationFrames::decode(Frame & frame)
+{
+	CBinaryReader reader(new CMemoryStream(pixelData.get(), pixelDataSize));
+
+	reader.getStream()->seek(frame.dataOffset);
+
+	reader.readUInt32(); // unused, size of pixel data for this frame
+	const ui32 defType2 = reader.readUInt32();
+	const ui32 fullWidth = reader.readUInt32();
+	/*const ui32 fullHeight =*/ reader.readUInt32();
+	const ui32 spriteWidth = reader.readUInt32();
+	const ui32 spriteHeight = reader.readUInt32();
+	const int leftMargin = reader.readInt32();
+	const int topMargin = reader.readInt32();
+
+	const size_t baseOffset = reader.getStream()->tell();
+
+	assert(defType2 == 1);
+	UNUSED(defType2);
+
+	frame.leftMargin = leftMargin;
+	frame.rightMargin = fullWidth - spriteWidth - leftMargin;
+	frame.topMargin = topMargin;
+	frame.surf = createSurface(spriteWidth, spriteHeight);
+
+	SDL_FillRect(frame.surf, nullptr, 0);
+
+	for (ui32 i=0; i<spriteHeight; i++)
+	{
+		ui8 * lineData = pixelData.get() + baseOffset + reader.readUInt32();
+		ui8 * dest = (ui8*)frame.surf->pixels + i * frame.surf->pitch;
+
+		size_t currentOffset = 0;
+		size_t totalRowLength = 0;
+
+		while (totalRowLength < spriteWidth)
+		{
+			ui8 type = lineData[currentOffset++];
+			ui32 length = lineData[currentOffset++] + 1;
+
+			// malformed defs may have rows longer than sprite
+			ui32 toCopy = std::min<ui32>(length, spriteWidth - totalRowLength);
+
+			if (type==0xFF)//Raw data
+			{
+				memcpy(dest + totalRowLength, lineData + currentOffset, toCopy);
+				currentOffset += length;
+			}
+			else// RLE
+			{
+				if (type != 0) // transparency row, surface is already filled with it
+					memset(dest + totalRowLength, type, toCopy);
+			}
+
+			totalRowLength += length;
+		}
+	}
+}
+
+void CCreatureAnimationFrames::mirror(Frame & frame)
+{
+	frame.mirrored = createSurface(frame.surf->w, frame.surf->h);
 
+	for (int y=0; y<frame.surf->h; y++)
+	{
+		const ui8 * src = (ui8*)frame.surf->pixels + y * frame.surf->pitch;
+		ui8 * dest = (ui8*)frame.mirrored->pixels + y * frame.mirrored->pitch;
+
+		std::reverse_copy(src, src + frame.surf->w, dest);
+	}
+}
+
+void CCreatureAnimationFrames::draw(SDL_Surface * dest, const Rect & pos, int group, size_t frameID, bool rotate, const std::array<SDL_Color, 8> & special)
+{
+	assert(groups.count(group) && groups.at(group).size() > frameID);
+
+	Frame & frame = groups.at(group).at(frameID);
+	if (!frame.surf)
+		decode(frame);
+	if (rotate && !frame.mirrored)
+		mirror(frame);
+
+	SDL_Surface * surf = rotate ? frame.mirrored : frame.surf;
+
+	// frames are shared between all stacks, so colors of border and shadow are set right before blit
+	SDL_SetColors(surf, const_cast<SDL_Color *>(special.data()), 0, special.size());
+
+	Rect spriteRect(pos.x + (rotate ? frame.rightMargin : frame.leftMargin), pos.y + frame.topMargin, surf->w, surf->h);
+	Rect visibleRect = spriteRect & pos;
+	if (visibleRect.w <= 0 || visibleRect.h <= 0)
+		return;
+
+	Rect srcRect(visibleRect.x - spriteRect.x, visibleRect.y - spriteRect.y, visibleRect.w, visibleRect.h);
+	CSDL_Ext::blit8bppAlphaTo24bpp(surf, &srcRect, dest, &visibleRect);
+}
+
+CCreatureAnimation::CCreatureAnimation(std::string name, TSpeedController controller)
+    : defName(name),
+      frames(CCreatureAnimationFrames::get(name)),
+      speed(0.1),
+      currentFrame(0),
+      elapsedTime(0),
+	  type(CCreatureAnim::HOLDING),
+	  border(CSDL_Ext::makeColor(0, 0, 0, 0)),
+      speedController(controller),
+      once(false)
+{
 	play();
 }
 
@@ -234,12 +397,12 @@ void CCreatureAnimation::setBorderColor(SDL_Color palette)
 
 int CCreatureAnimation::getWidth() const
 {
-	return fullWidth;
+	return frames->getWidth();
 }
 
 int CCreatureAnimation::getHeight() const
 {
-	return fullHeight;
+	return frames->getHeight();
 }
 
 float CCreatureAnimation::getCurrentFrame() const
@@ -301,124 +464,16 @@ std::array<SDL_Color, 8> CCreatureAnimation::genSpecialPalette()
 	return ret;
 }
 
-template<int bpp>
-void CCreatureAnimation::nextFrameT(SDL_Surface * dest, bool rotate)
-{
-	assert(dataOffsets.count(type) && dataOffsets.at(type).size() > size_t(currentFrame));
-
-	ui32 offset = dataOffsets.at(type).at(floor(currentFrame));
-
-	CBinaryReader reader(new CMemoryStream(pixelData.get(), pixelDataSize));
-
-	reader.getStream()->seek(offset);
-
-	reader.readUInt32(); // unused, size of pixel data for this frame
-	const ui32 defType2 = reader.readUInt32();
-	const ui32 fullWidth = reader.readUInt32();
-	/*const ui32 fullHeight =*/ reader.readUInt32();
-	const ui32 spriteWidth = reader.readUInt32();
-	const ui32 spriteHeight = reader.readUInt32();
-	const int leftMargin = reader.readInt32();
-	const int topMargin = reader.readInt32();
-
-	const int rightMargin = fullWidth - spriteWidth - leftMargin;
-	//const int bottomMargin = fullHeight - spriteHeight - topMargin;
-
-	const size_t baseOffset = reader.getStream()->tell();
-
-	assert(defType2 == 1);
-	UNUSED(defType2);
-
-	auto specialPalette = genSpecialPalette();
-
-	for (ui32 i=0; i<spriteHeight; i++)
-	{
-		//NOTE: if this loop will be optimized to skip empty lines - recheck this read access
-		ui8 * lineData = pixelData.get() + baseOffset + reader.readUInt32();
-
-		size_t destX = pos.x;
-		if (rotate)
-			destX += rightMargin + spriteWidth - 1;
-		else
-			destX += leftMargin;
-
-		size_t destY = pos.y + topMargin + i;
-		size_t currentOffset = 0;
-		size_t totalRowLength = 0;
-
-		while (totalRowLength < spriteWidth)
-		{
-			ui8 type = lineData[currentOffset++];
-			ui32 length = lineData[currentOffset++] + 1;
-
-			if (type==0xFF)//Raw data
-			{
-				for (size_t j=0; j<length; j++)
-					putPixelAt<bpp>(dest, destX + (rotate?(-j):(j)), destY, lineData[currentOffset + j], specialPalette);
-
-				currentOffset += length;
-			}
-			else// RLE
-			{
-				if (type != 0) // transparency row, handle it here for speed
-				{
-					for (size_t j=0; j<length; j++)
-						putPixelAt<bpp>(dest, destX + (rotate?(-j):(j)), destY, type, specialPalette);
-				}
-			}
-
-			destX += rotate ? (-length) : (length);
-			totalRowLength += length;
-		}
-	}
-}
-
 void CCreatureAnimation::nextFrame(SDL_Surface *dest, bool attacker)
 {
 	// Note: please notice that attacker value is inversed when passed further.
 	// This is intended behavior because "attacker" actually does not needs rotation
-	switch(dest->format->BytesPerPixel)
-	{
-	case 2: return nextFrameT<2>(dest, !attacker);
-	case 3: return nextFrameT<3>(dest, !attacker);
-	case 4: return nextFrameT<4>(dest, !attacker);
-	default:
-        logGlobal->errorStream() << (int)dest->format->BitsPerPixel << " bpp is not supported!!!";
-	}
+	frames->draw(dest, pos, type, floor(currentFrame), !attacker, genSpecialPalette());
 }
 
 int CCreatureAnimation::framesInGroup(CCreatureAnim::EAnimType group) const
 {
-	if(dataOffsets.count(group) == 0)
-		return 0;
-
-	return dataOffsets.at(group).size();
-}
-
-ui8 * CCreatureAnimation::getPixelAddr(SDL_Surface * dest, int X, int Y) const
-{
-	return (ui8*)dest->pixels + X * dest->format->BytesPerPixel + Y * dest->pitch;
-}
-
-template<int bpp>
-inline void CCreatureAnimation::putPixelAt(SDL_Surface * dest, int X, int Y, size_t index, const std::array<SDL_Color, 8> & special) const
-{
-	if ( X < pos.x + pos.w && Y < pos.y + pos.h && X >= 0 && Y >= 0)
-		putPixel<bpp>(getPixelAddr(dest, X, Y), palette[index], index, special);
-}
-
-template<int bpp>
-inline void CCreatureAnimation::putPixel(ui8 * dest, const SDL_Color & color, size_t index, const std::array<SDL_Color, 8> & special) const
-{
-	if (index < 8)
-	{
-		const SDL_Color & pal = special[index];
-		ColorPutter<bpp, 0>::PutColor(dest, pal.r, pal.g, pal.b, pal.unused);
-	}
-	else
-	{
-		ColorPutter<bpp, 0>::PutColor(dest, color.r, color.g, color.b);
-	}
+	return frames->framesInGroup(group);
 }
 
 bool CCreatureAnimation::isDead() const
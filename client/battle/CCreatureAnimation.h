@@ -45,15 +45,19 @@ namespace AnimationControls
 	float getFlightDistance(const CCreature * creature);
 }
 
-/// Class which manages animations of creatures/units inside battles
-/// TODO: split into constant image container and class that does *control* of animation
-class CCreatureAnimation : public CIntObject
+/// Frames of creature animation, decoded from def file on first use
+/// Shared between all animations of the same creature, see get()
+class CCreatureAnimationFrames : public boost::noncopyable
 {
-public:
-	typedef boost::function<float(CCreatureAnimation *, size_t)> TSpeedController;
-
-private:
-	std::string defName;
+	struct Frame
+	{
+		ui32 dataOffset; // offset of pixel data of this frame in def file
+		SDL_Surface * surf; // 8 bpp, indexes 0-7 are special colors. nullptr if not decoded yet
+		SDL_Surface * mirrored; // flipped horizontally, for defending side. nullptr if not needed yet
+		int leftMargin;
+		int rightMargin;
+		int topMargin;
+	};
 
 	int fullWidth, fullHeight;
 
@@ -61,14 +65,45 @@ private:
 	std::array<SDL_Color, 256> palette;
 
 	//key = id of group (note that some groups may be missing)
-	//value = offset of pixel data for each frame, vector size = number of frames in group
-	std::map<int, std::vector<unsigned int>> dataOffsets;
+	//value = frames of this group
+	std::map<int, std::vector<Frame>> groups;
 
 	//animation raw data
-	//TODO: use vector instead?
 	unique_ptr<ui8[]> pixelData;
 	size_t pixelDataSize;
 
+	SDL_Surface * createSurface(int width, int height) const;
+	void decode(Frame & frame);
+	void mirror(Frame & frame);
+
+public:
+	/// name - path to .def file, relative to SPRITES/ directory
+	CCreatureAnimationFrames(const std::string & name);
+	~CCreatureAnimationFrames();
+
+	/// returns frames of animation, loads them if they are not used by any other animation
+	static std::shared_ptr<CCreatureAnimationFrames> get(const std::string & name);
+
+	int getWidth() const;
+	int getHeight() const;
+	int framesInGroup(int group) const;
+
+	/// draws frame to dest, only part that is inside of pos
+	/// special - colors of palette indexes 0-7, with alpha
+	void draw(SDL_Surface * dest, const Rect & pos, int group, size_t frame, bool rotate, const std::array<SDL_Color, 8> & special);
+};
+
+/// Class which manages animations of creatures/units inside battles
+class CCreatureAnimation : public CIntObject
+{
+public:
+	typedef boost::function<float(CCreatureAnimation *, size_t)> TSpeedController;
+
+private:
+	std::string defName;
+
+	std::shared_ptr<CCreatureAnimationFrames> frames;
+
 	// speed of animation, measure in frames per second
 	float speed;
 
@@ -86,17 +121,6 @@ private:
 
 	bool once; // animation will be played once and the reset to idling
 
-	ui8 * getPixelAddr(SDL_Surface * dest, int ftcpX, int ftcpY) const;
-
-	template<int bpp>
-	void putPixelAt(SDL_Surface * dest, int X, int Y, size_t index, const std::array<SDL_Color, 8> & special) const;
-
-	template<int bpp>
-	void putPixel( ui8 * dest, const SDL_Color & color, size_t index, const std::array<SDL_Color, 8> & special) const;
-
-	template<int bpp>
-	void nextFrameT(SDL_Surface * dest, bool rotate);
-
 	void endAnimation();
 
 	/// creates 8 special colors for current frame
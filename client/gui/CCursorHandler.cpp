@@ -80,11 +80,13 @@ void CCursorHandler::drawWithScreenRestore()
 	{
 		dndObject->moveTo(Point(x - dndObject->pos.w/2, y - dndObject->pos.h/2));
 		dndObject->showAll(screen);
+		GH.invalidate(dndObject->pos);
 	}
 	else
 	{
 		currentCursor->moveTo(Point(x,y));
 		currentCursor->showAll(screen);
+		GH.invalidate(temp_rect1);
 	}
 }
 
@@ -99,6 +101,7 @@ void CCursorHandler::drawRestored()
 	SDL_Rect temp_rect = genRect(40, 40, x, y);
 	SDL_BlitSurface(help, nullptr, screen, &temp_rect);
 	//blitAt(help,x,y);
+	GH.invalidate(temp_rect); //cursor may move away, so next update should remove it from here
 }
 
 void CCursorHandler::draw(SDL_Surface *to)
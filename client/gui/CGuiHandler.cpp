@@ -4,6 +4,7 @@
 #include "SDL_Extensions.h"
 #include "CIntObject.h"
 #include "../CGameInfo.h"
+#include "../CVideoHandler.h"
 #include "CCursorHandler.h"
 #include "../../lib/CThreadHelper.h"
 #include "../../lib/CConfigHandler.h"
@@ -149,6 +150,87 @@ void CGuiHandler::totalRedraw()
 	for(auto & elem : objsToBlit)
 		elem->showAll(screen2);
 	blitAt(screen2,0,0,screen);
+	invalidateAll();
+	lastFrameInt = nullptr;
+}
+
+void CGuiHandler::invalidate(const Rect &area)
+{
+	//that many rects will be updated as whole screen anyway, don't let list grow if screen is not updated for a while
+	const size_t MAX_DIRTY_RECTS = 64;
+
+	boost::unique_lock<boost::mutex> lock(dirtyRectsMx);
+	if(dirtyRects.size() < MAX_DIRTY_RECTS)
+	{
+		dirtyRects.push_back(area);
+	}
+	else
+	{
+		dirtyRects.clear();
+		dirtyRects.push_back(Rect(0, 0, screen->w, screen->h));
+	}
+}
+
+void CGuiHandler::invalidate(IShowable *obj)
+{
+	auto intObj = dynamic_cast<CIntObject *>(obj);
+	if(intObj && intObj->pos.w && intObj->pos.h)
+		invalidate(intObj->pos);
+	else
+		invalidateAll();
+}
+
+void CGuiHandler::invalidateAll()
+{
+	invalidate(Rect(0, 0, screen->w, screen->h));
+}
+
+bool CGuiHandler::areaChanged(const Rect &area) const
+{
+	const int bpp = screen->format->BytesPerPixel;
+	for(int y = area.y; y < area.y + area.h; y++)
+	{
+		const ui8 *current = static_cast<const ui8 *>(screen->pixels) + y * screen->pitch + area.x * bpp;
+		const ui8 *last = static_cast<const ui8 *>(lastFrame->pixels) + y * lastFrame->pitch + area.x * bpp;
+		if(memcmp(current, last, area.w * bpp))
+			return true;
+	}
+	return false;
+}
+
+void CGuiHandler::storeArea(const Rect &area)
+{
+	const int bpp = screen->format->BytesPerPixel;
+	for(int y = area.y; y < area.y + area.h; y++)
+	{
+		const ui8 *current = static_cast<const ui8 *>(screen->pixels) + y * screen->pitch + area.x * bpp;
+		ui8 *last = static_cast<ui8 *>(lastFrame->pixels) + y * lastFrame->pitch + area.x * bpp;
+		memcpy(last, current, area.w * bpp);
+	}
+}
+
+void CGuiHandler::invalidateChanged(CIntObject *obj, const Rect &clip)
+{
+	const Rect area = obj->pos & clip;
+	if(area.w <= 0 || area.h <= 0 || !areaChanged(area))
+		return;
+
+	//if only some children have changed, only their parts of screen will be updated
+	for(auto child : obj->children)
+		invalidateChanged(child, area);
+
+	if(areaChanged(area))
+	{
+		invalidate(area);
+		storeArea(area);
+	}
+}
+
+void CGuiHandler::updateScreen()
+{
+	boost::unique_lock<boost::mutex> lock(dirtyRectsMx);
+	CSDL_Ext::update(screen, dirtyRects);
+	dirtyRects.clear();
 }
 
 void CGuiHandler::updateTime()
@@ -341,7 +423,43 @@ void CGuiHandler::simpleRedraw()
 	//update only top interface and draw background
 	if(objsToBlit.size() > 1)
 		blitAt(screen2,0,0,screen); //blit background
-	objsToBlit.back()->show(screen); //blit active interface/window
+	IShowable *top = objsToBlit.back();
+	top->show(screen); //blit active interface/window
+
+	//background is same as before, only active interface may change
+	auto intObj = dynamic_cast<CIntObject *>(top);
+	if(!intObj || !intObj->pos.w || !intObj->pos.h)
+	{
+		invalidate(top);
+		return;
+	}
+
+	if(!lastFrame || lastFrame->w != screen->w || lastFrame->h != screen->h
+		|| lastFrame->format->BytesPerPixel != screen->format->BytesPerPixel)
+	{
+		SDL_FreeSurface(lastFrame);
+		lastFrame = CSDL_Ext::newSurface(screen->w, screen->h, screen);
+		lastFrameInt = nullptr;
+	}
+
+	const Rect area = intObj->pos & Rect(0, 0, screen->w, screen->h);
+	if(area.w <= 0 || area.h <= 0)
+		return;
+
+	if(SDL_MUSTLOCK(screen))
+		SDL_LockSurface(screen);
+	if(lastFrameInt != top)
+	{
+		invalidate(area);
+		storeArea(area);
+		lastFrameInt = top;
+	}
+	else
+	{
+		invalidateChanged(intObj, area);
+	}
+	if(SDL_MUSTLOCK(screen))
+		SDL_UnlockSurface(screen);
 }
 
 void CGuiHandler::handleMoveInterested( const SDL_MouseMotionEvent & motion )
@@ -387,6 +505,7 @@ void CGuiHandler::run()
 			if(curInt)
 				curInt->update(); // calls a update and drawing process of the loaded game interface object at the moment
 
+			waitWhileIdle();
 			mainFPSmng->framerateDelay(); // holds a constant FPS
 		}
 	}
@@ -404,6 +523,10 @@ CGuiHandler::CGuiHandler()
 	current = nullptr;
 	terminate = false;
 	statusbar = nullptr;
+	activityHappened = false;
+	lastActivityTime = 0;
+	lastFrame = nullptr;
+	lastFrameInt = nullptr;
 
 	// Creates the FPS manager and sets the framerate to 48 which is doubled the value of the original Heroes 3 FPS rate
 	mainFPSmng = new CFramerateManager(48);
@@ -413,6 +536,7 @@ CGuiHandler::CGuiHandler()
 CGuiHandler::~CGuiHandler()
 {
 	delete mainFPSmng;
+	SDL_FreeSurface(lastFrame);
 }
 
 void CGuiHandler::breakEventHandling()
@@ -420,6 +544,41 @@ void CGuiHandler::breakEventHandling()
 	current = nullptr;
 }
 
+void CGuiHandler::notifyActivity()
+{
+	boost::unique_lock<boost::mutex> lock(activityMx);
+	activityHappened = true;
+	activityCond.notify_all();
+}
+
+void CGuiHandler::waitWhileIdle()
+{
+	//delay before entering idle mode, so animations started by input or network event are smooth
+	const ui32 IDLE_DELAY = 3000;
+
+	boost::unique_lock<boost::mutex> lock(activityMx);
+	if(activityHappened)
+	{
+		activityHappened = false;
+		lastActivityTime = SDL_GetTicks();
+		return;
+	}
+
+	const int idleFramerate = settings["video"]["idleFramerate"].Float();
+	if(idleFramerate >= mainFPSmng->getRate()
+		|| SDL_GetTicks() - lastActivityTime < IDLE_DELAY
+		|| !CCS->videoh->fname.empty()) //videos are always played with full framerate
+	{
+		return;
+	}
+
+	auto activityOrQuit = [&]{ return activityHappened || terminate; };
+	if(idleFramerate > 0)
+		activityCond.timed_wait(lock, boost::posix_time::milliseconds(1000 / idleFramerate), activityOrQuit);
+	else
+		activityCond.wait(lock, activityOrQuit);
+}
+
 void CGuiHandler::drawFPSCounter()
 {
 	const static SDL_Color yellow = {255, 255, 0, 0};
@@ -428,6 +587,7 @@ void CGuiHandler::drawFPSCounter()
 	SDL_FillRect(screen, &overlay, black);
 	std::string fps = boost::lexical_cast<std::string>(mainFPSmng->fps);
 	graphics->fonts[FONT_BIG]->renderTextLeft(screen, fps, yellow, Point(10, 10));
+	invalidate(overlay);
 }
 
 SDLKey CGuiHandler::arrowToNum( SDLKey key )
@@ -9,6 +9,7 @@ class CIntObject;
 class IUpdateable;
 class IShowActivatable;
 class IShowable;
+struct SDL_Surface;
 
 /*
  * CGuiHandler.h, part of VCMI engine
@@ -35,6 +36,7 @@ public:
 	void init(); // needs to be called directly before the main game loop to reset the internal timer
 	void framerateDelay(); // needs to be called every game update cycle
 	ui32 getElapsedMilliseconds() const {return this->timeElapsed;}
+	int getRate() const {return this->rate;}
 };
 
 // Handles GUI logic and drawing
@@ -59,6 +61,24 @@ private:
 	               doubleClickInterested;
 	               
 	void processLists(const ui16 activityFlag, std::function<void (std::list<CIntObject*> *)> cb);               
+
+	//parts of screen changed since last update of display
+	boost::mutex dirtyRectsMx;
+	std::vector<Rect> dirtyRects;
+
+	//copy of top interface from last frame - only parts that differ from it are sent to display
+	SDL_Surface * lastFrame;
+	IShowable * lastFrameInt; //interface stored in lastFrame, nullptr if it has to be stored again
+	bool areaChanged(const Rect &area) const; //compares given part of screen with lastFrame
+	void storeArea(const Rect &area); //copies given part of screen to lastFrame
+	void invalidateChanged(CIntObject *obj, const Rect &clip); //marks changed parts of object, checking its children first
+
+	//idle mode - if there is no input and network activity GUI is updated with lower framerate
+	boost::mutex activityMx;
+	boost::condition_variable activityCond;
+	bool activityHappened;
+	ui32 lastActivityTime;
+	void waitWhileIdle(); //called every frame, returns immediately if there was any activity recently
 public:
 	void handleElementActivate(CIntObject * elem, ui16 activityFlag);
 	void handleElementDeActivate(CIntObject * elem, ui16 activityFlag);
@@ -81,6 +101,12 @@ public:
 	void totalRedraw(); //forces total redraw (using showAll), sets a flag, method gets called at the end of the rendering
 	void simpleRedraw(); //update only top interface and draw background from buffer, sets a flag, method gets called at the end of the rendering
 
+	void invalidate(const Rect &area); //marks part of screen as changed, it will be sent to display by updateScreen
+	void invalidate(IShowable *obj); //marks area drawn by given interface as changed (whole screen if it's not known)
+	void invalidateAll();
+	void updateScreen(); //sends changed parts of screen to display
+	void notifyActivity(); //input or network event happened - ends idle mode
+
 	void popInt(IShowActivatable *top); //removes given interface from the top and activates next
 	void popIntTotally(IShowActivatable *top); //deactivates, deletes, removes given interface from the top and activates next
 	void pushInt(IShowActivatable *newInt); //deactivate old top interface, activates this one and pushes to the top
@@ -282,6 +282,7 @@ void CIntObject::redraw()
 			showAll(screenBuf);
 			if(screenBuf != screen)
 				showAll(screen);
+			GH.invalidate(pos);
 		}
 	}
 }
@@ -134,6 +134,8 @@ void CPicture::convertToScreenBPP()
 
 void CPicture::setAlpha(int value)
 {
+	takeOwnership();
+	CSDL_Ext::unshare(bg);
 	SDL_SetAlpha(bg, SDL_SRCALPHA, value);
 }
 
@@ -172,9 +174,19 @@ void CPicture::colorizeAndConvert(PlayerColor player)
 void CPicture::colorize(PlayerColor player)
 {
 	assert(bg);
+	takeOwnership();
 	graphics->blueToPlayersAdv(bg, player);
 }
 
+void CPicture::takeOwnership()
+{
+	if(!freeSurf)
+	{
+		bg->refcount++;
+		freeSurf = true;
+	}
+}
+
 CFilledTexture::CFilledTexture(std::string imageName, Rect position):
     CIntObject(0, position.topLeft()),
     texture(BitmapHandler::loadBitmap(imageName))
@@ -35,6 +35,7 @@ public:
 class CPicture : public CIntObject
 {
 	void setSurface(SDL_Surface *to);
+	void takeOwnership(); //picture will hold own reference to its surface, so it can be unshared before modification
 public: 
 	SDL_Surface * bg;
 	Rect * srcRect; //if nullptr then whole surface will be used
@@ -54,7 +55,7 @@ public:
 	~CPicture();
 	void init();
 
-	//set alpha value for whole surface. Note: may be messed up if surface is shared
+	//set alpha value for whole surface, shared surface is copied first
 	// 0=transparent, 255=opaque
 	void setAlpha(int value);
 
@@ -19,6 +19,105 @@
  *
  */
 
+CRenderedTextCache::CRenderedTextCache():
+	totalBytes(0)
+{
+}
+
+CRenderedTextCache::~CRenderedTextCache()
+{
+	clear();
+}
+
+CRenderedTextCache::TKey CRenderedTextCache::makeKey(const std::string & data, const SDL_Color & color)
+{
+	return TKey(data, (ui32(color.r) << 16) | (ui32(color.g) << 8) | ui32(color.b));
+}
+
+SDL_Surface * CRenderedTextCache::get(const std::string & data, const SDL_Color & color, int & offsetX)
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+
+	auto it = entries.find(makeKey(data, color));
+	if(it == entries.end())
+		return nullptr;
+
+	Entry & entry = it->second;
+	lru.splice(lru.begin(), lru, entry.lruPos);
+
+	offsetX = entry.offsetX;
+	entry.surf->refcount++;
+	return entry.surf;
+}
+
+void CRenderedTextCache::add(const std::string & data, const SDL_Color & color, SDL_Surface * surf, int offsetX)
+{
+	const size_t bytes = size_t(surf->pitch) * surf->h;
+	if(bytes > budget)
+		return; // huge texts are rare, no need to evict everything else for them
+
+	TKey key = makeKey(data, color);
+
+	boost::unique_lock<boost::mutex> lock(mx);
+	if(vstd::contains(entries, key))
+		return;
+
+	evict(budget - bytes);
+
+	surf->refcount++;
+	lru.push_front(key);
+
+	Entry & entry = entries[key];
+	entry.surf = surf;
+	entry.offsetX = offsetX;
+	entry.bytes = bytes;
+	entry.lruPos = lru.begin();
+	totalBytes += bytes;
+}
+
+void CRenderedTextCache::evict(size_t limit)
+{
+	while(totalBytes > limit && !lru.empty())
+	{
+		auto it = entries.find(lru.back());
+		totalBytes -= it->second.bytes;
+		SDL_FreeSurface(it->second.surf);
+		entries.erase(it);
+		lru.pop_back();
+	}
+}
+
+void CRenderedTextCache::clear()
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+	evict(0);
+}
+
+SDL_Surface * IFont::renderTextSurface(const std::string & data, const SDL_Color & color, int & offsetX) const
+{
+	return nullptr;
+}
+
+void IFont::renderTextCached(SDL_Surface * surface, const std::string & data, const SDL_Color & color, const Point & pos) const
+{
+	if (data.empty())
+		return;
+
+	int offsetX = 0;
+	SDL_Surface * rendered = textCache.get(data, color, offsetX);
+	if (!rendered)
+	{
+		rendered = renderTextSurface(data, color, offsetX);
+		if (!rendered)
+			return;
+		textCache.add(data, color, rendered, offsetX);
+	}
+
+	Rect rect(pos.x + offsetX, pos.y, rendered->w, rendered->h);
+	SDL_BlitSurface(rendered, nullptr, surface, &rect);
+	SDL_FreeSurface(rendered);
+}
+
 size_t IFont::getStringWidth(const std::string & data) const
 {
 	size_t width = 0;
@@ -102,13 +201,55 @@ std::array<CBitmapFont::BitmapChar, CBitmapFont::totalChars> CBitmapFont::loadCh
 
 		assert(pixelOffset + 4128 < data.second);
 	}
+
+	si32 atlasX = 0;
+	for (auto & elem : ret)
+	{
+		elem.atlasX = atlasX;
+		atlasX += elem.width;
+	}
+	return ret;
+}
+
+SDL_Surface * CBitmapFont::loadAtlas() const
+{
+	const BitmapChar & last = chars.back();
+	SDL_Surface * ret = SDL_CreateRGBSurface(SDL_SWSURFACE, std::max<int>(1, last.atlasX + last.width), std::max<int>(1, height), 8, 0, 0, 0, 0);
+
+	const SDL_Color white = { 255, 255, 255, SDL_ALPHA_OPAQUE};
+	const SDL_Color key   = { 0, 255, 255, SDL_ALPHA_OPAQUE};
+	const SDL_Color black = { 0, 0, 0, SDL_ALPHA_OPAQUE};
+
+	SDL_Color palette[256];
+	for (auto & elem : palette)
+		elem = white; // text colour, replaced on rendering
+	palette[0] = key;
+	palette[1] = black;
+	SDL_SetColors(ret, palette, 0, 256);
+
+	SDL_LockSurface(ret);
+	for(auto & elem : chars)
+	{
+		for(int y = 0; y < height; y++)
+		{
+			const ui8 * srcLine = elem.pixels + y * elem.width;
+			ui8 * dstLine = (ui8*)ret->pixels + y * ret->pitch + elem.atlasX;
+
+			for(ui32 x = 0; x < elem.width; x++)
+				dstLine[x] = (srcLine[x] == 1 || srcLine[x] == 255) ? srcLine[x] : 0;
+		}
+	}
+	SDL_UnlockSurface(ret);
+
+	SDL_SetColorKey(ret, SDL_SRCCOLORKEY, 0);
 	return ret;
 }
 
 CBitmapFont::CBitmapFont(const std::string & filename):
     data(CResourceHandler::get()->load(ResourceID("data/" + filename, EResType::BMP_FONT))->readAll()),
     chars(loadChars()),
-    height(data.first.get()[5])
+    height(data.first.get()[5]),
+    atlas(loadAtlas(), SDL_FreeSurface)
 {}
 
 size_t CBitmapFont::getLineHeight() const
@@ -180,28 +321,58 @@ void CBitmapFont::renderCharacter(SDL_Surface * surface, const BitmapChar & char
 
 void CBitmapFont::renderText(SDL_Surface * surface, const std::string & data, const SDL_Color & color, const Point & pos) const
 {
-	if (data.empty())
-		return;
-
 	assert(surface);
 
-	int posX = pos.x;
-	int posY = pos.y;
-
 	// Should be used to detect incorrect text parsing. Disabled right now due to some old UI code (mostly pregame and battles)
 	//assert(data[0] != '{');
 	//assert(data[data.size()-1] != '}');
 
-	SDL_LockSurface(surface);
+	renderTextCached(surface, data, color, pos);
+}
+
+SDL_Surface * CBitmapFont::renderTextSurface(const std::string & data, const SDL_Color & color, int & offsetX) const
+{
+	std::vector<std::pair<const BitmapChar *, int> > glyphs; // character and its position
+	int posX = 0;
+	int minX = 0;
+	int maxX = 0;
 
 	for(size_t i=0; i<data.size(); i += Unicode::getCharacterSize(data[i]))
 	{
 		std::string localChar = Unicode::fromUnicode(data.substr(i, Unicode::getCharacterSize(data[i])));
 
 		if (localChar.size() == 1)
-			renderCharacter(surface, chars[ui8(localChar[0])], color, posX, posY);
+		{
+			const BitmapChar & character = chars[ui8(localChar[0])];
+			posX += character.leftOffset;
+			glyphs.push_back(std::make_pair(&character, posX));
+			vstd::amin(minX, posX);
+			vstd::amax(maxX, posX + int(character.width));
+			posX += character.width + character.rightOffset;
+		}
 	}
-	SDL_UnlockSurface(surface);
+
+	if (maxX <= minX)
+		return nullptr;
+
+	SDL_Surface * ret = SDL_CreateRGBSurface(SDL_SWSURFACE, maxX - minX, height, 8, 0, 0, 0, 0);
+	// same palette as in atlas so glyphs are copied as they are
+	SDL_SetColors(ret, atlas->format->palette->colors, 0, 256);
+	SDL_FillRect(ret, nullptr, 0);
+
+	for(auto & glyph : glyphs)
+	{
+		Rect srcRect(glyph.first->atlasX, 0, glyph.first->width, height);
+		Rect dstRect(glyph.second - minX, 0, glyph.first->width, height);
+		SDL_BlitSurface(atlas.get(), &srcRect, ret, &dstRect);
+	}
+
+	SDL_Color textColor = color;
+	SDL_SetColors(ret, &textColor, 255, 1);
+	SDL_SetColorKey(ret, SDL_SRCCOLORKEY | SDL_RLEACCEL, 0);
+
+	offsetX = minX;
+	return ret;
 }
 
 std::pair<std::unique_ptr<ui8[]>, ui64> CTrueTypeFont::loadData(const JsonNode & config)
@@ -271,23 +442,23 @@ void CTrueTypeFont::renderText(SDL_Surface * surface, const std::string & data,
 	if (color.r != 0 && color.g != 0 && color.b != 0) // not black - add shadow
 	{
 		SDL_Color black = { 0, 0, 0, SDL_ALPHA_OPAQUE};
-		renderText(surface, data, black, Point(pos.x + 1, pos.y + 1));
+		renderTextCached(surface, data, black, Point(pos.x + 1, pos.y + 1));
 	}
 
-	if (!data.empty())
-	{
-		SDL_Surface * rendered;
-		if (blended)
-			rendered = TTF_RenderUTF8_Blended(font.get(), data.c_str(), color);
-		else
-			rendered = TTF_RenderUTF8_Solid(font.get(), data.c_str(), color);
-
-		assert(rendered);
+	renderTextCached(surface, data, color, pos);
+}
 
-		Rect rect(pos.x, pos.y, rendered->w, rendered->h);
-		SDL_BlitSurface(rendered, nullptr, surface, &rect);
-		SDL_FreeSurface(rendered);
-	}
+SDL_Surface * CTrueTypeFont::renderTextSurface(const std::string & data, const SDL_Color & color, int & offsetX) const
+{
+	SDL_Surface * rendered;
+	if (blended)
+		rendered = TTF_RenderUTF8_Blended(font.get(), data.c_str(), color);
+	else
+		rendered = TTF_RenderUTF8_Solid(font.get(), data.c_str(), color);
+
+	assert(rendered);
+	offsetX = 0;
+	return rendered;
 }
 
 size_t CBitmapHanFont::getCharacterDataOffset(size_t index) const
@@ -21,12 +21,55 @@ typedef struct _TTF_Font TTF_Font;
 class CBitmapFont;
 class CBitmapHanFont;
 
+/// LRU cache of strings rendered by font, so static labels are not rendered again on every redraw
+class CRenderedTextCache
+{
+	typedef std::pair<std::string, ui32> TKey; // text and its colour
+
+	struct Entry
+	{
+		SDL_Surface * surf;
+		int offsetX; // position of surface relative to position of text
+		size_t bytes;
+		std::list<TKey>::iterator lruPos;
+	};
+
+	std::map<TKey, Entry> entries;
+	std::list<TKey> lru; // most recently used first
+	size_t totalBytes;
+	mutable boost::mutex mx;
+
+	static TKey makeKey(const std::string & data, const SDL_Color & color);
+	void evict(size_t limit);
+
+public:
+	/// memory limit of each font, in bytes
+	static const size_t budget = 2 * 1024 * 1024;
+
+	CRenderedTextCache();
+	~CRenderedTextCache();
+
+	/// returns new reference to cached surface or nullptr. Caller must free it with SDL_FreeSurface
+	SDL_Surface * get(const std::string & data, const SDL_Color & color, int & offsetX);
+	/// adds its own reference to surface
+	void add(const std::string & data, const SDL_Color & color, SDL_Surface * surf, int offsetX);
+	void clear();
+};
+
 class IFont
 {
+	mutable CRenderedTextCache textCache;
+
 protected:
 	/// Internal function to render font, see renderTextLeft
 	virtual void renderText(SDL_Surface * surface, const std::string & data, const SDL_Color & color, const Point & pos) const = 0;
 
+	/// Renders whole string to new surface that uses colour key or alpha for transparency, used to fill cache of rendered strings
+	/// offsetX - position of returned surface relative to position of text. Default implementation returns nullptr (not supported)
+	virtual SDL_Surface * renderTextSurface(const std::string & data, const SDL_Color & color, int & offsetX) const;
+	/// Blits string from cache of rendered strings, rendering it with renderTextSurface if needed
+	void renderTextCached(SDL_Surface * surface, const std::string & data, const SDL_Color & color, const Point & pos) const;
+
 public:
 	virtual ~IFont()
 	{}
@@ -69,6 +112,7 @@ class CBitmapFont : public IFont
 		ui32 width;
 		si32 rightOffset;
 		ui8 *pixels; // pixels of this character, part of BitmapFont::data
+		si32 atlasX; // position of this character in atlas
 	};
 
 	const std::pair<std::unique_ptr<ui8[]>, ui64> data;
@@ -76,11 +120,16 @@ class CBitmapFont : public IFont
 	const std::array<BitmapChar, totalChars> chars;
 	const ui8 height;
 
+	// all characters in one paletted surface: 0 - transparent, 1 - shadow, 255 - text colour (placeholder)
+	const std::unique_ptr<SDL_Surface, void (*)(SDL_Surface*)> atlas;
+
 	std::array<BitmapChar, totalChars> loadChars() const;
+	SDL_Surface * loadAtlas() const;
 
 	void renderCharacter(SDL_Surface * surface, const BitmapChar & character, const SDL_Color & color, int &posX, int &posY) const;
 
 	void renderText(SDL_Surface * surface, const std::string & data, const SDL_Color & color, const Point & pos) const override;
+	SDL_Surface * renderTextSurface(const std::string & data, const SDL_Color & color, int & offsetX) const override;
 public:
 	CBitmapFont(const std::string & filename);
 
@@ -124,6 +173,7 @@ class CTrueTypeFont : public IFont
 	int getFontStyle(const JsonNode & config);
 
 	void renderText(SDL_Surface * surface, const std::string & data, const SDL_Color & color, const Point & pos) const override;
+	SDL_Surface * renderTextSurface(const std::string & data, const SDL_Color & color, int & offsetX) const override;
 public:
 	CTrueTypeFont(const JsonNode & fontConfig);
 
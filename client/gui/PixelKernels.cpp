@@ -0,0 +1,433 @@
+#include "StdInc.h"
+#include "PixelKernels.h"
+
+#include "../../lib/CStopWatch.h"
+
+/*
+ * PixelKernels.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+// SSE2 kernels are built only if SSE2 is part of target baseline (always true on x86-64),
+// AVX2 kernels are built with per-function target and used only if CPU and OS support them
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define VCMI_KERNELS_SSE2
+	#include <emmintrin.h>
+
+	#if defined(__clang__)
+		#if __clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 8)
+			#define VCMI_KERNELS_AVX2
+		#endif
+	#elif defined(__GNUC__)
+		#if __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+			#define VCMI_KERNELS_AVX2
+		#endif
+	#elif defined(_MSC_VER) && _MSC_VER >= 1700
+		#define VCMI_KERNELS_AVX2
+	#endif
+#endif
+
+#ifdef VCMI_KERNELS_AVX2
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define TARGET_AVX2
+	#else
+		#define TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#endif
+
+namespace PixelKernels
+{
+
+static const ui32 ALPHA_MASK = 0xFF000000;
+
+// Portable kernels, also used for remainders of rows by vectorized ones
+
+static inline void blendPixel(ui32 & dst, ui32 src)
+{
+	const ui32 alpha = src >> 24;
+	if(alpha == 0)
+		return;
+	if(alpha == 255)
+	{
+		dst = src;
+		return;
+	}
+
+	// same as ((src - dst) * alpha >> 8) + dst; covers "optimized" 50% case as well
+	ui32 ret = ALPHA_MASK;
+	for(int shift = 0; shift < 24; shift += 8)
+	{
+		const ui32 s = (src >> shift) & 0xFF;
+		const ui32 d = (dst >> shift) & 0xFF;
+		ret |= ((d * (256 - alpha) + s * alpha) >> 8) << shift;
+	}
+	dst = ret;
+}
+
+static void blendRowScalar(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	for(int i = 0; i < count; i++)
+		blendPixel(dst[i], palette[src[i]]);
+}
+
+static void copyRowScalar(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	for(int i = 0; i < count; i++)
+		dst[i] = palette[src[i]];
+}
+
+static void copyRowReversedScalar(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	for(int i = 0; i < count; i++)
+		dst[count - 1 - i] = palette[src[i]];
+}
+
+static void copyRowKeyedScalar(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	for(int i = 0; i < count; i++)
+	{
+		if(src[i])
+			dst[i] = palette[src[i]];
+	}
+}
+
+static void copyRowKeyedReversedScalar(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	for(int i = 0; i < count; i++)
+	{
+		if(src[i])
+			dst[count - 1 - i] = palette[src[i]];
+	}
+}
+
+static const KernelSet scalarKernels =
+{
+	"portable", blendRowScalar, copyRowScalar, copyRowReversedScalar, copyRowKeyedScalar, copyRowKeyedReversedScalar
+};
+
+#ifdef VCMI_KERNELS_SSE2
+
+static inline __m128i gather4(const ui8 * src, const ui32 * palette)
+{
+	return _mm_set_epi32(palette[src[3]], palette[src[2]], palette[src[1]], palette[src[0]]);
+}
+
+// blends two pixels unpacked to 16 bit channels; alpha 255 is turned to 256 to copy source exactly
+static inline __m128i blend2SSE2(__m128i src, __m128i dst)
+{
+	__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, 0xFF), 0xFF);
+	alpha = _mm_sub_epi16(alpha, _mm_cmpeq_epi16(alpha, _mm_set1_epi16(255)));
+	const __m128i inverted = _mm_sub_epi16(_mm_set1_epi16(256), alpha);
+	return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dst, inverted)), 8);
+}
+
+static void blendRowSSE2(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaMask = _mm_set1_epi32(ALPHA_MASK);
+
+	int i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		const __m128i s = gather4(src + i, palette);
+		const __m128i alpha = _mm_and_si128(s, alphaMask);
+		const __m128i transparent = _mm_cmpeq_epi32(alpha, zero);
+		if(_mm_movemask_epi8(transparent) == 0xFFFF)
+			continue;
+
+		__m128i * const dp = reinterpret_cast<__m128i *>(dst + i);
+		if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xFFFF)
+		{
+			_mm_storeu_si128(dp, s);
+			continue;
+		}
+
+		const __m128i d = _mm_loadu_si128(dp);
+		__m128i ret = _mm_packus_epi16(blend2SSE2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero)),
+		                               blend2SSE2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero)));
+
+		//destination alpha is kept for skipped pixels and set to opaque for all others
+		const __m128i retAlpha = _mm_or_si128(_mm_and_si128(transparent, d), _mm_andnot_si128(transparent, alphaMask));
+		ret = _mm_or_si128(_mm_andnot_si128(alphaMask, ret), _mm_and_si128(alphaMask, retAlpha));
+		_mm_storeu_si128(dp, ret);
+	}
+	blendRowScalar(dst + i, src + i, palette, count - i);
+}
+
+static void copyRowSSE2(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	int i = 0;
+	for(; i + 4 <= count; i += 4)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), gather4(src + i, palette));
+	copyRowScalar(dst + i, src + i, palette, count - i);
+}
+
+static void copyRowReversedSSE2(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	int i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		const __m128i s = _mm_shuffle_epi32(gather4(src + i, palette), _MM_SHUFFLE(0, 1, 2, 3));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + count - i - 4), s);
+	}
+	copyRowReversedScalar(dst, src + i, palette, count - i);
+}
+
+static void copyRowKeyedSSE2(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	int i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		const __m128i keyed = _mm_cmpeq_epi32(_mm_set_epi32(src[i+3], src[i+2], src[i+1], src[i]), _mm_setzero_si128());
+		__m128i * const dp = reinterpret_cast<__m128i *>(dst + i);
+		const __m128i s = gather4(src + i, palette);
+		_mm_storeu_si128(dp, _mm_or_si128(_mm_and_si128(keyed, _mm_loadu_si128(dp)), _mm_andnot_si128(keyed, s)));
+	}
+	copyRowKeyedScalar(dst + i, src + i, palette, count - i);
+}
+
+static void copyRowKeyedReversedSSE2(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	int i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		const __m128i keyed = _mm_cmpeq_epi32(_mm_set_epi32(src[i], src[i+1], src[i+2], src[i+3]), _mm_setzero_si128());
+		__m128i * const dp = reinterpret_cast<__m128i *>(dst + count - i - 4);
+		const __m128i s = _mm_shuffle_epi32(gather4(src + i, palette), _MM_SHUFFLE(0, 1, 2, 3));
+		_mm_storeu_si128(dp, _mm_or_si128(_mm_and_si128(keyed, _mm_loadu_si128(dp)), _mm_andnot_si128(keyed, s)));
+	}
+	copyRowKeyedReversedScalar(dst, src + i, palette, count - i);
+}
+
+static const KernelSet sse2Kernels =
+{
+	"SSE2", blendRowSSE2, copyRowSSE2, copyRowReversedSSE2, copyRowKeyedSSE2, copyRowKeyedReversedSSE2
+};
+
+#endif // VCMI_KERNELS_SSE2
+
+#ifdef VCMI_KERNELS_AVX2
+
+TARGET_AVX2 static inline __m256i indices8(const ui8 * src)
+{
+	return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src)));
+}
+
+TARGET_AVX2 static inline __m256i gather8(__m256i indices, const ui32 * palette)
+{
+	return _mm256_i32gather_epi32(reinterpret_cast<const int *>(palette), indices, 4);
+}
+
+TARGET_AVX2 static inline __m256i reverse8(__m256i pixels)
+{
+	return _mm256_permutevar8x32_epi32(pixels, _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+TARGET_AVX2 static inline __m256i blend4AVX2(__m256i src, __m256i dst)
+{
+	__m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(src, 0xFF), 0xFF);
+	alpha = _mm256_sub_epi16(alpha, _mm256_cmpeq_epi16(alpha, _mm256_set1_epi16(255)));
+	const __m256i inverted = _mm256_sub_epi16(_mm256_set1_epi16(256), alpha);
+	return _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(src, alpha), _mm256_mullo_epi16(dst, inverted)), 8);
+}
+
+TARGET_AVX2 static void blendRowAVX2(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i alphaMask = _mm256_set1_epi32(ALPHA_MASK);
+
+	int i = 0;
+	for(; i + 8 <= count; i += 8)
+	{
+		const __m256i s = gather8(indices8(src + i), palette);
+		const __m256i alpha = _mm256_and_si256(s, alphaMask);
+		const __m256i transparent = _mm256_cmpeq_epi32(alpha, zero);
+		if(_mm256_movemask_epi8(transparent) == -1)
+			continue;
+
+		__m256i * const dp = reinterpret_cast<__m256i *>(dst + i);
+		if(_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, alphaMask)) == -1)
+		{
+			_mm256_storeu_si256(dp, s);
+			continue;
+		}
+
+		//unpack and pack work within 128 bit lanes, so pixel order is preserved
+		const __m256i d = _mm256_loadu_si256(dp);
+		__m256i ret = _mm256_packus_epi16(blend4AVX2(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero)),
+		                                  blend4AVX2(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero)));
+
+		const __m256i retAlpha = _mm256_or_si256(_mm256_and_si256(transparent, d), _mm256_andnot_si256(transparent, alphaMask));
+		ret = _mm256_or_si256(_mm256_andnot_si256(alphaMask, ret), _mm256_and_si256(alphaMask, retAlpha));
+		_mm256_storeu_si256(dp, ret);
+	}
+	blendRowScalar(dst + i, src + i, palette, count - i);
+}
+
+TARGET_AVX2 static void copyRowAVX2(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	int i = 0;
+	for(; i + 8 <= count; i += 8)
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), gather8(indices8(src + i), palette));
+	copyRowScalar(dst + i, src + i, palette, count - i);
+}
+
+TARGET_AVX2 static void copyRowReversedAVX2(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	int i = 0;
+	for(; i + 8 <= count; i += 8)
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + count - i - 8), reverse8(gather8(indices8(src + i), palette)));
+	copyRowReversedScalar(dst, src + i, palette, count - i);
+}
+
+TARGET_AVX2 static void copyRowKeyedAVX2(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	int i = 0;
+	for(; i + 8 <= count; i += 8)
+	{
+		const __m256i indices = indices8(src + i);
+		const __m256i keyed = _mm256_cmpeq_epi32(indices, _mm256_setzero_si256());
+		__m256i * const dp = reinterpret_cast<__m256i *>(dst + i);
+		_mm256_storeu_si256(dp, _mm256_blendv_epi8(gather8(indices, palette), _mm256_loadu_si256(dp), keyed));
+	}
+	copyRowKeyedScalar(dst + i, src + i, palette, count - i);
+}
+
+TARGET_AVX2 static void copyRowKeyedReversedAVX2(ui32 * dst, const ui8 * src, const ui32 * palette, int count)
+{
+	int i = 0;
+	for(; i + 8 <= count; i += 8)
+	{
+		const __m256i indices = reverse8(indices8(src + i));
+		const __m256i keyed = _mm256_cmpeq_epi32(indices, _mm256_setzero_si256());
+		__m256i * const dp = reinterpret_cast<__m256i *>(dst + count - i - 8);
+		_mm256_storeu_si256(dp, _mm256_blendv_epi8(gather8(indices, palette), _mm256_loadu_si256(dp), keyed));
+	}
+	copyRowKeyedReversedScalar(dst, src + i, palette, count - i);
+}
+
+static const KernelSet avx2Kernels =
+{
+	"AVX2", blendRowAVX2, copyRowAVX2, copyRowReversedAVX2, copyRowKeyedAVX2, copyRowKeyedReversedAVX2
+};
+
+static bool cpuSupportsAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if(info[0] < 7)
+		return false;
+
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	if(!osxsave || !avx || (_xgetbv(0) & 6) != 6) //OS must save YMM registers
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // VCMI_KERNELS_AVX2
+
+//all kernel sets usable on this CPU, fastest last
+static std::vector<const KernelSet *> supportedKernels()
+{
+	std::vector<const KernelSet *> ret;
+	ret.push_back(&scalarKernels);
+#ifdef VCMI_KERNELS_SSE2
+	ret.push_back(&sse2Kernels);
+#endif
+#ifdef VCMI_KERNELS_AVX2
+	if(cpuSupportsAVX2())
+		ret.push_back(&avx2Kernels);
+#endif
+	return ret;
+}
+
+// selected during static initialization - before any blits and before other threads are started
+static const KernelSet * const selectedKernels = supportedKernels().back();
+
+const KernelSet & get()
+{
+	return *selectedKernels;
+}
+
+void benchmark()
+{
+	const int width = 1920, height = 1080, frames = 10;
+
+	//simple LCG, quality doesn't matter here
+	ui32 seed = 12345;
+	auto random = [&]() -> ui32
+	{
+		seed = seed * 1103515245 + 12345;
+		return seed >> 8;
+	};
+
+	//mix of transparent, opaque, 50% and other alpha values, like in def palettes
+	ui32 palette[256];
+	for(ui32 & color : palette)
+	{
+		const ui32 alphas[] = { 0, 255, 128, random() & 0xFF };
+		color = (alphas[random() % 4] << 24) | (random() & 0xFFFFFF);
+	}
+
+	std::vector<ui8> src(width * height);
+	for(ui8 & index : src)
+		index = random() & 0xFF;
+	std::vector<ui32> initialDst(width * height);
+	for(ui32 & pixel : initialDst)
+		pixel = random();
+
+	struct KernelInfo
+	{
+		const char * name;
+		TRowKernel KernelSet::*kernel;
+	};
+	const KernelInfo kernels[] =
+	{
+		{ "blendRow", &KernelSet::blendRow },
+		{ "copyRow", &KernelSet::copyRow },
+		{ "copyRowReversed", &KernelSet::copyRowReversed },
+		{ "copyRowKeyed", &KernelSet::copyRowKeyed },
+		{ "copyRowKeyedReversed", &KernelSet::copyRowKeyedReversed }
+	};
+
+	const auto sets = supportedKernels();
+	logGlobal->infoStream() << "Pixel kernels: " << frames << " frames of " << width << "x" << height << ", selected: " << get().name;
+	for(const KernelInfo & kernel : kernels)
+	{
+		std::vector<ui32> expected;
+		for(const KernelSet * set : sets)
+		{
+			std::vector<ui32> dst = initialDst;
+			CStopWatch timer;
+			for(int frame = 0; frame < frames; frame++)
+			{
+				for(int y = 0; y < height; y++)
+					(set->*kernel.kernel)(dst.data() + y * width, src.data() + y * width, palette, width);
+			}
+			const si64 time = timer.getDiff();
+
+			if(expected.empty())
+				expected = dst; //portable kernel is reference
+			logGlobal->infoStream() << "\t" << kernel.name << " " << set->name << ": " << time << " ms"
+				<< (dst == expected ? "" : " - OUTPUT DIFFERS!");
+		}
+	}
+}
+
+}
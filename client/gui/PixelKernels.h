@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+ * PixelKernels.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+/// Row kernels for blitting 8 bpp paletted images to 32 bpp surfaces.
+/// Palette is expanded to destination format first: alpha in bits 24-31, then red, green and blue.
+/// All implementations give exactly the same output as ColorPutter<4, ...>.
+namespace PixelKernels
+{
+	typedef void (*TRowKernel)(ui32 * dst, const ui8 * src, const ui32 * palette, int count);
+
+	struct KernelSet
+	{
+		const char * name;
+		TRowKernel blendRow; //blends using alpha of palette entry, like ColorPutter::PutColorAlphaSwitch
+		TRowKernel copyRow; //dst[i] = palette[src[i]]
+		TRowKernel copyRowReversed; //dst[count-1-i] = palette[src[i]]
+		TRowKernel copyRowKeyed; //as copyRow, but pixels with index 0 are skipped
+		TRowKernel copyRowKeyedReversed;
+	};
+
+	//fastest kernels supported by CPU, selected once on startup
+	const KernelSet & get();
+
+	//measures all kernel sets supported by CPU on random data and checks they match portable one, results are logged
+	void benchmark();
+}
@@ -1,6 +1,7 @@
 #include "StdInc.h"
 #include "SDL_Extensions.h"
 #include "SDL_Pixels.h"
+#include "PixelKernels.h"
 
 #include <SDL_ttf.h>
 #include "../CGameInfo.h"
@@ -31,6 +32,16 @@ SDL_Surface * CSDL_Ext::copySurface(SDL_Surface * mod) //returns copy of given s
 	return SDL_ConvertSurface(mod, mod->format, mod->flags);
 }
 
+void CSDL_Ext::unshare(SDL_Surface * & surf)
+{
+	if (surf && surf->refcount > 1)
+	{
+		SDL_Surface * copy = copySurface(surf);
+		SDL_FreeSurface(surf);
+		surf = copy;
+	}
+}
+
 template<int bpp>
 SDL_Surface * CSDL_Ext::createSurfaceWithBpp(int width, int height)
 {
@@ -44,6 +55,23 @@ SDL_Surface * CSDL_Ext::createSurfaceWithBpp(int width, int height)
 	return SDL_CreateRGBSurface( SDL_SWSURFACE, width, height, bpp * 8, rMask, gMask, bMask, aMask);
 }
 
+// 32 bpp destinations are handled by row kernels, with palette converted to destination format once per blit
+static void expandPalette(const SDL_Surface * src, ui32 * palette, bool opaque)
+{
+	const SDL_Palette * pal = src->format->palette;
+	for(int i = 0; i < 256; i++)
+	{
+		if(i < pal->ncolors)
+		{
+			const SDL_Color & color = pal->colors[i];
+			const ui32 alpha = opaque ? 255 : color.unused;
+			palette[i] = (alpha << 24) | (color.r << 16) | (color.g << 8) | color.b;
+		}
+		else
+			palette[i] = opaque ? 0xFF000000 : 0;
+	}
+}
+
 bool isItIn(const SDL_Rect * rect, int x, int y)
 {
 	return (x>rect->x && x<rect->x+rect->w) && (y>rect->y && y<rect->y+rect->h);
@@ -140,9 +168,10 @@ Uint32 CSDL_Ext::SDL_GetPixel(SDL_Surface *surface, const int & x, const int & y
 	}
 }
 
-void CSDL_Ext::alphaTransform(SDL_Surface *src)
+void CSDL_Ext::alphaTransform(SDL_Surface * & src)
 {
 	assert(src->format->BitsPerPixel == 8);
+	unshare(src);
 	SDL_Color colors[] =
 	{
 	    {  0,   0,  0,   0}, {  0,   0,   0,  32}, {  0,   0,   0,  64},
@@ -221,6 +250,16 @@ void CSDL_Ext::blitWithRotate1(const SDL_Surface *src, const SDL_Rect * srcRect,
 	Uint8 *dporg = (Uint8 *)dst->pixels + dstRect->y*dst->pitch + (dstRect->x+dstRect->w)*bpp;
 	const SDL_Color * const colors = src->format->palette->colors;
 
+	if(bpp == 4)
+	{
+		ui32 palette[256];
+		expandPalette(src, palette, true);
+		const auto kernel = PixelKernels::get().copyRowReversed;
+		for(int i=dstRect->h; i>0; i--, dporg += dst->pitch, sp += src->w)
+			kernel((ui32 *)dporg - dstRect->w, sp, palette, dstRect->w);
+		return;
+	}
+
 	for(int i=dstRect->h; i>0; i--, dporg += dst->pitch)
 	{
 		Uint8 *dp = dporg;
@@ -238,6 +277,16 @@ void CSDL_Ext::blitWithRotate2(const SDL_Surface *src, const SDL_Rect * srcRect,
 	Uint8 *dporg = (Uint8 *)dst->pixels + (dstRect->y + dstRect->h - 1)*dst->pitch + dstRect->x*bpp;
 	const SDL_Color * const colors = src->format->palette->colors;
 
+	if(bpp == 4)
+	{
+		ui32 palette[256];
+		expandPalette(src, palette, true);
+		const auto kernel = PixelKernels::get().copyRow;
+		for(int i=dstRect->h; i>0; i--, dporg -= dst->pitch, sp += src->w)
+			kernel((ui32 *)dporg, sp, palette, dstRect->w);
+		return;
+	}
+
 	for(int i=dstRect->h; i>0; i--, dporg -= dst->pitch)
 	{
 		Uint8 *dp = dporg;
@@ -256,6 +305,16 @@ void CSDL_Ext::blitWithRotate3(const SDL_Surface *src, const SDL_Rect * srcRect,
 	Uint8 *dporg = (Uint8 *)dst->pixels +(dstRect->y + dstRect->h - 1)*dst->pitch + (dstRect->x+dstRect->w)*bpp;
 	const SDL_Color * const colors = src->format->palette->colors;
 
+	if(bpp == 4)
+	{
+		ui32 palette[256];
+		expandPalette(src, palette, true);
+		const auto kernel = PixelKernels::get().copyRowReversed;
+		for(int i=dstRect->h; i>0; i--, dporg -= dst->pitch, sp += src->w)
+			kernel((ui32 *)dporg - dstRect->w, sp, palette, dstRect->w);
+		return;
+	}
+
 	for(int i=dstRect->h; i>0; i--, dporg -= dst->pitch)
 	{
 		Uint8 *dp = dporg;
@@ -273,6 +332,16 @@ void CSDL_Ext::blitWithRotate1WithAlpha(const SDL_Surface *src, const SDL_Rect *
 	Uint8 *dporg = (Uint8 *)dst->pixels + dstRect->y*dst->pitch + (dstRect->x+dstRect->w)*bpp;
 	const SDL_Color * const colors = src->format->palette->colors;
 
+	if(bpp == 4)
+	{
+		ui32 palette[256];
+		expandPalette(src, palette, true);
+		const auto kernel = PixelKernels::get().copyRowKeyedReversed;
+		for(int i=dstRect->h; i>0; i--, dporg += dst->pitch, sp += src->w)
+			kernel((ui32 *)dporg - dstRect->w, sp, palette, dstRect->w);
+		return;
+	}
+
 	for(int i=dstRect->h; i>0; i--, dporg += dst->pitch)
 	{
 		Uint8 *dp = dporg;
@@ -295,6 +364,16 @@ void CSDL_Ext::blitWithRotate2WithAlpha(const SDL_Surface *src, const SDL_Rect *
 	Uint8 *dporg = (Uint8 *)dst->pixels + (dstRect->y + dstRect->h - 1)*dst->pitch + dstRect->x*bpp;
 	const SDL_Color * const colors = src->format->palette->colors;
 
+	if(bpp == 4)
+	{
+		ui32 palette[256];
+		expandPalette(src, palette, true);
+		const auto kernel = PixelKernels::get().copyRowKeyed;
+		for(int i=dstRect->h; i>0; i--, dporg -= dst->pitch, sp += src->w)
+			kernel((ui32 *)dporg, sp, palette, dstRect->w);
+		return;
+	}
+
 	for(int i=dstRect->h; i>0; i--, dporg -= dst->pitch)
 	{
 		Uint8 *dp = dporg;
@@ -318,6 +397,16 @@ void CSDL_Ext::blitWithRotate3WithAlpha(const SDL_Surface *src, const SDL_Rect *
 	Uint8 *dporg = (Uint8 *)dst->pixels +(dstRect->y + dstRect->h - 1)*dst->pitch + (dstRect->x+dstRect->w)*bpp;
 	const SDL_Color * const colors = src->format->palette->colors;
 
+	if(bpp == 4)
+	{
+		ui32 palette[256];
+		expandPalette(src, palette, true);
+		const auto kernel = PixelKernels::get().copyRowKeyedReversed;
+		for(int i=dstRect->h; i>0; i--, dporg -= dst->pitch, sp += src->w)
+			kernel((ui32 *)dporg - dstRect->w, sp, palette, dstRect->w);
+		return;
+	}
+
 	for(int i=dstRect->h; i>0; i--, dporg -= dst->pitch)
 	{
 		Uint8 *dp = dporg;
@@ -436,6 +525,18 @@ int CSDL_Ext::blit8bppAlphaTo24bppT(const SDL_Surface * src, const SDL_Rect * sr
 			Uint8 *colory = (Uint8*)src->pixels + srcy*src->pitch + srcx;
 			Uint8 *py = (Uint8*)dst->pixels + dstRect->y*dst->pitch + dstRect->x*bpp;
 
+			if(bpp == 4)
+			{
+				ui32 palette[256];
+				expandPalette(src, palette, false);
+				const auto kernel = PixelKernels::get().blendRow;
+				for(int y=h; y; y--, colory+=src->pitch, py+=dst->pitch)
+					kernel((ui32 *)py, colory, palette, w);
+
+				SDL_UnlockSurface(dst);
+				return 0;
+			}
+
 			for(int y=h; y; y--, colory+=src->pitch, py+=dst->pitch)
 			{
 				Uint8 *color = colory;
@@ -484,6 +585,35 @@ void CSDL_Ext::update(SDL_Surface * what)
 	if(what)
 		SDL_UpdateRect(what, 0, 0, what->w, what->h);
 }
+
+void CSDL_Ext::update(SDL_Surface * what, const std::vector<Rect> & areas)
+{
+	//above that number updating whole screen at once is faster than many small updates
+	const size_t MAX_RECTS = 16;
+
+	if(!what || areas.empty())
+		return;
+
+	std::vector<SDL_Rect> rects;
+	rects.reserve(areas.size());
+	int totalArea = 0;
+	for(auto & area : areas)
+	{
+		//clip to surface, SDL_UpdateRects doesn't accept rects outside of it
+		int x1 = std::max<int>(area.x, 0), y1 = std::max<int>(area.y, 0);
+		int x2 = std::min<int>(area.x + area.w, what->w), y2 = std::min<int>(area.y + area.h, what->h);
+		if(x1 >= x2 || y1 >= y2)
+			continue;
+
+		rects.push_back(genRect(y2 - y1, x2 - x1, x1, y1));
+		totalArea += (x2 - x1) * (y2 - y1);
+	}
+
+	if(rects.size() > MAX_RECTS || totalArea >= what->w * what->h)
+		update(what);
+	else if(!rects.empty())
+		SDL_UpdateRects(what, rects.size(), rects.data());
+}
 void CSDL_Ext::drawBorder(SDL_Surface * sur, int x, int y, int w, int h, const int3 &color)
 {
 	for(int i = 0; i < w; i++)
@@ -31,6 +31,8 @@
 const bool MARK_BLOCKED_POSITIONS = false;
 const bool MARK_VISITABLE_POSITIONS = false;
 
+const int CMapHandler::TERRAIN_CHUNK_SIZE;
+
 #define ADVOPT (conf.go()->ac)
 
 std::string nameFromType (int typ)
@@ -319,6 +321,8 @@ void CMapHandler::init()
 	CStopWatch th;
 	th.getDiff();
 
+	clearTerrainChunks();
+
 	graphics->advmapobjGraphics["AB01_.DEF"] = graphics->boatAnims[0];
 	graphics->advmapobjGraphics["AB02_.DEF"] = graphics->boatAnims[1];
 	graphics->advmapobjGraphics["AB03_.DEF"] = graphics->boatAnims[2];
@@ -423,11 +427,10 @@ void CMapHandler::terrainRect( int3 top_tile, ui8 anim, const std::vector< std::
 	SDL_GetClipRect(extSurf, &prevClip);
 	SDL_SetClipRect(extSurf, extRect); //preventing blitting outside of that rect
 
-	const BlitterWithRotationVal blitterWithRotation = CSDL_Ext::getBlitterWithRotation(extSurf);
-	const BlitterWithRotationVal blitterWithRotationAndAlpha = CSDL_Ext::getBlitterWithRotationAndAlpha(extSurf);
-	//const BlitterWithRotationAndAlphaVal blitterWithRotation = CSDL_Ext::getBlitterWithRotation(extSurf);
-
 	// printing terrain
+	drawTerrainChunks(top_tile, dx, dy, srx_init, sry_init, extSurf);
+
+	// printing objects
 	srx = srx_init;
 
 	for (int bx = 0; bx < dx; bx++, srx+=32)
@@ -447,44 +450,12 @@ void CMapHandler::terrainRect( int3 top_tile, ui8 anim, const std::vector< std::
 				continue;
 
 			const TerrainTile2 & tile = ttiles[pos.x][pos.y][pos.z];
-			const TerrainTile &tinfo = map->getTile(int3(pos.x, pos.y, pos.z));
 
 			SDL_Rect sr;
 			sr.x=srx;
 			sr.y=sry;
 			sr.h=sr.w=32;
 
-			//blit terrain with river/road
-			if(tile.terbitmap)
-			{ //if custom terrain graphic - use it
-				SDL_Rect temp_rect = genRect(sr.h, sr.w, 0, 0);
-				CSDL_Ext::blitSurface(tile.terbitmap, &temp_rect, extSurf, &sr);
-			}
-			else //use default terrain graphic
-			{
-                blitterWithRotation(terrainGraphics[tinfo.terType][tinfo.terView],rtile, extSurf, sr, tinfo.extTileFlags%4);
-			}
-            if(tinfo.riverType) //print river if present
-			{
-                blitterWithRotationAndAlpha(staticRiverDefs[tinfo.riverType-1]->ourImages[tinfo.riverDir].bitmap,rtile, extSurf, sr, (tinfo.extTileFlags>>2)%4);
-			}
-
-			//Roads are shifted by 16 pixels to bottom. We have to draw both parts separately
-			if (pos.y > 0 && map->getTile(int3(pos.x, pos.y-1, pos.z)).roadType != ERoadType::NO_ROAD)
-			{ //part from top tile
-				const TerrainTile &topTile = map->getTile(int3(pos.x, pos.y-1, pos.z));
-				Rect source(0, 16, 32, 16);
-				Rect dest(sr.x, sr.y, sr.w, sr.h/2);
-                blitterWithRotationAndAlpha(roadDefs[topTile.roadType - 1]->ourImages[topTile.roadDir].bitmap, source, extSurf, dest, (topTile.extTileFlags>>4)%4);
-			}
-
-            if(tinfo.roadType != ERoadType::NO_ROAD) //print road from this tile
-			{
-				Rect source(0, 0, 32, 32);
-				Rect dest(sr.x, sr.y+16, sr.w, sr.h/2);
-                blitterWithRotationAndAlpha(roadDefs[tinfo.roadType-1]->ourImages[tinfo.roadDir].bitmap, source, extSurf, dest, (tinfo.extTileFlags>>4)%4);
-			}
-
 			//blit objects
 			const std::vector < std::pair<const CGObjectInstance*,SDL_Rect> > &objects = tile.objects;
 			for(auto & object : objects)
@@ -991,8 +962,9 @@ ui8 CMapHandler::getDir(const int3 &a, const int3 &b)
 	return -2; //shouldn't happen
 }
 
-void shiftColors(SDL_Surface *img, int from, int howMany) //shifts colors in palette
+void shiftColors(SDL_Surface * &img, int from, int howMany) //shifts colors in palette, shared surface is replaced with own copy
 {
+	CSDL_Ext::unshare(img);
 	//works with at most 16 colors, if needed more -> increase values
 	assert(howMany < 16);
 	SDL_Color palette[16];
@@ -1004,6 +976,131 @@ void shiftColors(SDL_Surface *img, int from, int howMany) //shifts colors in pal
 	SDL_SetColors(img,palette,from,howMany);
 }
 
+void CMapHandler::drawTerrainChunks(const int3 & topTile, int dx, int dy, int srxInit, int sryInit, SDL_Surface * extSurf) const
+{
+	//chunks of 256x256 pixels, enough for screens much bigger than 1920x1200
+	const size_t MAX_TERRAIN_CHUNKS = 128;
+
+	terrainRectCalls++;
+
+	//chunks are rendered in format of surface they are blitted to, it may change e.g. when resolution is changed
+	if(!terrainChunks.empty() && terrainChunks.begin()->second.surface->format->BitsPerPixel != extSurf->format->BitsPerPixel)
+		clearTerrainChunks();
+
+	//visible tiles inside the map
+	const int firstTileX = std::max(topTile.x, 0), endTileX = std::min<int>(topTile.x + dx, sizes.x);
+	const int firstTileY = std::max(topTile.y, 0), endTileY = std::min<int>(topTile.y + dy, sizes.y);
+	if(firstTileX >= endTileX || firstTileY >= endTileY)
+		return;
+
+	for(int cx = firstTileX / TERRAIN_CHUNK_SIZE; cx <= (endTileX - 1) / TERRAIN_CHUNK_SIZE; cx++)
+	{
+		for(int cy = firstTileY / TERRAIN_CHUNK_SIZE; cy <= (endTileY - 1) / TERRAIN_CHUNK_SIZE; cy++)
+		{
+			const int3 chunkPos(cx, cy, topTile.z);
+			TerrainChunk & chunk = terrainChunks[chunkPos];
+			if(!chunk.valid)
+				renderTerrainChunk(chunk, chunkPos, extSurf);
+			chunk.lastUsed = terrainRectCalls;
+
+			//parts of chunk outside of terrain rect are cut off by clip rect
+			SDL_Rect dst = genRect(chunk.surface->h, chunk.surface->w,
+				srxInit + (cx * TERRAIN_CHUNK_SIZE - topTile.x) * 32,
+				sryInit + (cy * TERRAIN_CHUNK_SIZE - topTile.y) * 32);
+			CSDL_Ext::blitSurface(chunk.surface, nullptr, extSurf, &dst);
+		}
+	}
+
+	//free chunks that were not displayed for longest time
+	while(terrainChunks.size() > MAX_TERRAIN_CHUNKS)
+	{
+		auto oldest = std::min_element(terrainChunks.begin(), terrainChunks.end(),
+			[](const std::pair<const int3, TerrainChunk> & a, const std::pair<const int3, TerrainChunk> & b)
+		{
+			return a.second.lastUsed < b.second.lastUsed;
+		});
+		SDL_FreeSurface(oldest->second.surface);
+		terrainChunks.erase(oldest);
+	}
+}
+
+void CMapHandler::renderTerrainChunk(TerrainChunk & chunk, const int3 & chunkPos, SDL_Surface * formatSurf) const
+{
+	// Basic rectangle for a tile. Should be a const but conflicts with SDL headers
+	SDL_Rect rtile = { 0, 0, 32, 32 };
+
+	//chunks at right and bottom edge of map may be smaller
+	const int chunkW = std::min(TERRAIN_CHUNK_SIZE, sizes.x - chunkPos.x * TERRAIN_CHUNK_SIZE);
+	const int chunkH = std::min(TERRAIN_CHUNK_SIZE, sizes.y - chunkPos.y * TERRAIN_CHUNK_SIZE);
+
+	if(!chunk.surface)
+		chunk.surface = CSDL_Ext::newSurface(chunkW * 32, chunkH * 32, formatSurf);
+
+	const BlitterWithRotationVal blitterWithRotation = CSDL_Ext::getBlitterWithRotation(chunk.surface);
+	const BlitterWithRotationVal blitterWithRotationAndAlpha = CSDL_Ext::getBlitterWithRotationAndAlpha(chunk.surface);
+
+	chunk.animated = false;
+	for(int bx = 0; bx < chunkW; bx++)
+	{
+		for(int by = 0; by < chunkH; by++)
+		{
+			int3 pos(chunkPos.x * TERRAIN_CHUNK_SIZE + bx, chunkPos.y * TERRAIN_CHUNK_SIZE + by, chunkPos.z);
+
+			const TerrainTile2 & tile = ttiles[pos.x][pos.y][pos.z];
+			const TerrainTile &tinfo = map->getTile(pos);
+
+			SDL_Rect sr = genRect(32, 32, bx * 32, by * 32);
+
+			//blit terrain with river/road
+			if(tile.terbitmap)
+			{ //if custom terrain graphic - use it
+				SDL_Rect temp_rect = genRect(sr.h, sr.w, 0, 0);
+				CSDL_Ext::blitSurface(tile.terbitmap, &temp_rect, chunk.surface, &sr);
+			}
+			else //use default terrain graphic
+			{
+				blitterWithRotation(terrainGraphics[tinfo.terType][tinfo.terView],rtile, chunk.surface, sr, tinfo.extTileFlags%4);
+			}
+			if(tinfo.riverType) //print river if present
+			{
+				blitterWithRotationAndAlpha(staticRiverDefs[tinfo.riverType-1]->ourImages[tinfo.riverDir].bitmap,rtile, chunk.surface, sr, (tinfo.extTileFlags>>2)%4);
+			}
+
+			//Roads are shifted by 16 pixels to bottom. We have to draw both parts separately
+			if (pos.y > 0 && map->getTile(int3(pos.x, pos.y-1, pos.z)).roadType != ERoadType::NO_ROAD)
+			{ //part from top tile
+				const TerrainTile &topTile = map->getTile(int3(pos.x, pos.y-1, pos.z));
+				Rect source(0, 16, 32, 16);
+				Rect dest(sr.x, sr.y, sr.w, sr.h/2);
+				blitterWithRotationAndAlpha(roadDefs[topTile.roadType - 1]->ourImages[topTile.roadDir].bitmap, source, chunk.surface, dest, (topTile.extTileFlags>>4)%4);
+			}
+
+			if(tinfo.roadType != ERoadType::NO_ROAD) //print road from this tile
+			{
+				Rect source(0, 0, 32, 32);
+				Rect dest(sr.x, sr.y+16, sr.w, sr.h/2);
+				blitterWithRotationAndAlpha(roadDefs[tinfo.roadType-1]->ourImages[tinfo.roadDir].bitmap, source, chunk.surface, dest, (tinfo.extTileFlags>>4)%4);
+			}
+
+			//palettes of these graphics are shifted by updateWater
+			if(tinfo.terType == ETerrainType::LAVA || tinfo.terType == ETerrainType::WATER
+				|| tinfo.riverType == ERiverType::CLEAR_RIVER || tinfo.riverType == ERiverType::MUDDY_RIVER || tinfo.riverType == ERiverType::LAVA_RIVER)
+			{
+				chunk.animated = true;
+			}
+		}
+	}
+
+	chunk.valid = true;
+}
+
+void CMapHandler::clearTerrainChunks() const
+{
+	for(auto & elem : terrainChunks)
+		SDL_FreeSurface(elem.second.surface);
+	terrainChunks.clear();
+}
+
 void CMapHandler::updateWater() //shift colors in palettes of water tiles
 {
 	for(auto & elem : terrainGraphics[7])
@@ -1030,6 +1127,12 @@ void CMapHandler::updateWater() //shift colors in palettes of water tiles
 	{
 		shiftColors(elem.bitmap,240, 9); 
 	}
+
+	for(auto & elem : terrainChunks)
+	{
+		if(elem.second.animated)
+			elem.second.valid = false;
+	}
 }
 
 CMapHandler::~CMapHandler()
@@ -1049,11 +1152,14 @@ CMapHandler::~CMapHandler()
 			SDL_FreeSurface(elem[j]);
 	}
 	terrainGraphics.clear();
+
+	clearTerrainChunks();
 }
 
 CMapHandler::CMapHandler()
 {
 	frameW = frameH = 0;
+	terrainRectCalls = 0;
 	graphics->FoWfullHide = nullptr;
 	graphics->FoWpartialHide = nullptr;
 }
@@ -1094,3 +1200,7 @@ ui8 CMapHandler::getPhaseShift(const CGObjectInstance *object) const
 TerrainTile2::TerrainTile2()
  :terbitmap(nullptr)
 {}
+
+TerrainChunk::TerrainChunk()
+ :surface(nullptr), animated(false), valid(false), lastUsed(0)
+{}
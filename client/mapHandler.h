@@ -33,6 +33,17 @@ struct TerrainTile2
 	TerrainTile2();
 };
 
+/// Terrain, rivers and roads of square of tiles, prerendered so they don't have to be blitted tile by tile every frame
+struct TerrainChunk
+{
+	SDL_Surface * surface;
+	bool animated; //contains water, lava or rivers with animated palettes - has to be rendered again when they change
+	bool valid; //false if surface has to be rendered again
+	ui32 lastUsed; //number of terrainRect call in which chunk was displayed last time
+
+	TerrainChunk();
+};
+
 template <typename T> class PseudoV
 {
 public:
@@ -102,6 +113,10 @@ public:
 
 	mutable std::map<const CGObjectInstance*, ui8> animationPhase;
 
+	static const int TERRAIN_CHUNK_SIZE = 8; //size of side of terrain chunk, in tiles
+	mutable std::map<int3, TerrainChunk> terrainChunks; //[chunk position (tile position / TERRAIN_CHUNK_SIZE)]
+	mutable ui32 terrainRectCalls;
+
 	static const bool MARK_BLOCKED_POSITIONS;
 	static const bool MARK_VISITABLE_POSITIONS;
 
@@ -125,6 +140,9 @@ public:
 	void prepareFOWDefs();
 
 	void terrainRect(int3 top_tile, ui8 anim, const std::vector< std::vector< std::vector<ui8> > > * visibilityMap, bool otherHeroAnim, ui8 heroAnim, SDL_Surface * extSurf, const SDL_Rect * extRect, int moveX, int moveY, bool puzzleMode, int3 grailPosRel) const;
+	void drawTerrainChunks(const int3 & topTile, int dx, int dy, int srxInit, int sryInit, SDL_Surface * extSurf) const; //terrainRect helper, blits terrain of visible tiles
+	void renderTerrainChunk(TerrainChunk & chunk, const int3 & chunkPos, SDL_Surface * formatSurf) const; //renders terrain of all tiles in chunk to its surface
+	void clearTerrainChunks() const; //frees all prerendered terrain, to be called when terrain changes
 	void updateWater();
 	ui8 getHeroFrameNum(ui8 dir, bool isMoving) const; //terrainRect helper function
 	void validateRectTerr(SDL_Rect * val, const SDL_Rect * ext); //terrainRect helper
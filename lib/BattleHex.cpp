@@ -56,20 +56,114 @@ BattleHex BattleHex::operator+(EDir dir) const
 	return ret;
 }
 
+namespace
+{
+	std::vector<BattleHex> calculateNeighbouringTiles(si16 hex)
+	{
+		std::vector<BattleHex> ret;
+		const int WN = GameConstants::BFIELD_WIDTH;
+		// H3 order : TR, R, BR, BL, L, TL (T = top, B = bottom ...)
+
+		BattleHex::checkAndPush(hex - ( (hex/WN)%2 ? WN+1 : WN ), ret); // 1
+		BattleHex::checkAndPush(hex + 1, ret); // 2
+		BattleHex::checkAndPush(hex + ( (hex/WN)%2 ? WN : WN+1 ), ret); // 3
+		BattleHex::checkAndPush(hex + ( (hex/WN)%2 ? WN-1 : WN ), ret); // 4
+		BattleHex::checkAndPush(hex - 1, ret); // 5
+		BattleHex::checkAndPush(hex - ( (hex/WN)%2 ? WN : WN-1 ), ret); // 6
+
+		return ret;
+	}
+
+	/// all adjacent hexes including side columns, hexes at left and right border don't wrap to other rows
+	std::vector<BattleHex> calculateAllNeighbouringTiles(si16 hex)
+	{
+		std::vector<BattleHex> ret;
+		const int x = hex % GameConstants::BFIELD_WIDTH;
+		const int y = hex / GameConstants::BFIELD_WIDTH;
+		const int shift = y % 2 ? -1 : 0; //odd rows are shifted left
+		auto push = [&](int tileX, int tileY)
+		{
+			if(tileX >= 0 && tileX < GameConstants::BFIELD_WIDTH && tileY >= 0 && tileY < GameConstants::BFIELD_HEIGHT)
+				ret.push_back(BattleHex(tileX, tileY));
+		};
+
+		push(x + shift, y - 1); //top left
+		push(x + shift + 1, y - 1); //top right
+		push(x - 1, y); //left
+		push(x + 1, y); //right
+		push(x + shift, y + 1); //bottom left
+		push(x + shift + 1, y + 1); //bottom right
+		return ret;
+	}
+
+	char calculateDistance(BattleHex hex1, BattleHex hex2)
+	{
+		int y1 = hex1.getY(),
+			y2 = hex2.getY();
+
+		int x1 = hex1.getX() + y1 / 2.0,
+			x2 = hex2.getX() + y2 / 2.0;
+
+		int xDst = x2 - x1,
+			yDst = y2 - y1;
+
+		if ((xDst >= 0 && yDst >= 0) || (xDst < 0 && yDst < 0))
+			return std::max(std::abs(xDst), std::abs(yDst));
+		else
+			return std::abs(xDst) + std::abs(yDst);
+	}
+
+	/// neighbours and distances of all valid hexes, filled once on library load
+	struct BattleHexTables
+	{
+		BattleHex::NeighbouringTiles neighbours[GameConstants::BFIELD_SIZE];
+		BattleHex::NeighbouringTiles allNeighbours[GameConstants::BFIELD_SIZE];
+		BattleHex::NeighbouringTiles noNeighbours;
+		char distances[GameConstants::BFIELD_SIZE][GameConstants::BFIELD_SIZE];
+
+		BattleHexTables()
+		{
+			noNeighbours.count = 0;
+			for(si16 i = 0; i < GameConstants::BFIELD_SIZE; i++)
+			{
+				auto tiles = calculateNeighbouringTiles(i);
+				neighbours[i].count = tiles.size();
+				boost::copy(tiles, neighbours[i].tiles);
+
+				auto allTiles = calculateAllNeighbouringTiles(i);
+				allNeighbours[i].count = allTiles.size();
+				boost::copy(allTiles, allNeighbours[i].tiles);
+
+				for(si16 j = 0; j < GameConstants::BFIELD_SIZE; j++)
+					distances[i][j] = calculateDistance(i, j);
+			}
+		}
+	};
+
+	const BattleHexTables hexTables;
+}
+
 std::vector<BattleHex> BattleHex::neighbouringTiles() const
 {
-	std::vector<BattleHex> ret;
-	const int WN = GameConstants::BFIELD_WIDTH;
-	// H3 order : TR, R, BR, BL, L, TL (T = top, B = bottom ...)
+	if(!isValid())
+		return calculateNeighbouringTiles(hex);
 
-	checkAndPush(hex - ( (hex/WN)%2 ? WN+1 : WN ), ret); // 1
-	checkAndPush(hex + 1, ret); // 2
-	checkAndPush(hex + ( (hex/WN)%2 ? WN : WN+1 ), ret); // 3
-	checkAndPush(hex + ( (hex/WN)%2 ? WN-1 : WN ), ret); // 4
-	checkAndPush(hex - 1, ret); // 5
-	checkAndPush(hex - ( (hex/WN)%2 ? WN : WN-1 ), ret); // 6
+	const NeighbouringTiles & tiles = hexTables.neighbours[hex];
+	return std::vector<BattleHex>(tiles.begin(), tiles.end());
+}
 
-	return ret;
+const BattleHex::NeighbouringTiles & BattleHex::getNeighbouringTiles() const
+{
+	if(!isValid())
+		return hexTables.noNeighbours;
+	return hexTables.neighbours[hex];
+}
+
+const BattleHex::NeighbouringTiles & BattleHex::getAllNeighbouringTiles() const
+{
+	if(!isValid())
+		return hexTables.noNeighbours;
+	return hexTables.allNeighbours[hex];
 }
 
 signed char BattleHex::mutualPosition(BattleHex hex1, BattleHex hex2)
@@ -90,20 +184,10 @@ signed char BattleHex::mutualPosition(BattleHex hex1, BattleHex hex2)
 }
 
 char BattleHex::getDistance(BattleHex hex1, BattleHex hex2)
-{	
-	int y1 = hex1.getY(), 
-		y2 = hex2.getY();
-
-	int x1 = hex1.getX() + y1 / 2.0, 
-		x2 = hex2.getX() + y2 / 2.0;
-
-	int xDst = x2 - x1,
-		yDst = y2 - y1;
-
-	if ((xDst >= 0 && yDst >= 0) || (xDst < 0 && yDst < 0)) 
-		return std::max(std::abs(xDst), std::abs(yDst));
-	else 
-		return std::abs(xDst) + std::abs(yDst);
+{
+	if(hex1.isValid() && hex2.isValid())
+		return hexTables.distances[hex1][hex2];
+	return calculateDistance(hex1, hex2);
 }
 
 void BattleHex::checkAndPush(BattleHex tile, std::vector<BattleHex> & ret)
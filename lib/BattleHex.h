@@ -98,6 +98,14 @@ struct DLL_LINKAGE BattleHex
 
 	std::vector<BattleHex> neighbouringTiles() const;
 
+	struct NeighbouringTiles;
+
+	//same as neighbouringTiles() but doesn't allocate; for invalid hex returns empty list
+	const NeighbouringTiles & getNeighbouringTiles() const;
+
+	//all adjacent hexes, including side columns; for invalid hex returns empty list
+	const NeighbouringTiles & getAllNeighbouringTiles() const;
+
 	//returns info about mutual position of given hexes (-1 - they're distant, 0 - left top, 1 - right top, 2 - right, 3 - right bottom, 4 - left bottom, 5 - left)
 	static signed char mutualPosition(BattleHex hex1, BattleHex hex2);
 
@@ -114,4 +122,69 @@ struct DLL_LINKAGE BattleHex
 	static BattleHex getClosestTile(bool attackerOwned, BattleHex initialPos, std::set<BattleHex> & possibilities); //TODO: vector or set? copying one to another is bad
 };
 
+/// available neighbours of hex, taken from precomputed table
+struct BattleHex::NeighbouringTiles
+{
+	BattleHex tiles[6];
+	ui8 count;
+
+	const BattleHex * begin() const { return tiles; }
+	const BattleHex * end() const { return tiles + count; }
+};
+
+/// Set of battlefield hexes stored as fixed-size bitset, doesn't allocate. Invalid hexes are ignored.
+class BattleHexSet
+{
+public:
+	void insert(BattleHex hex)
+	{
+		if(hex.isValid())
+			hexes.set(hex.hex);
+	}
+
+	void erase(BattleHex hex)
+	{
+		if(hex.isValid())
+			hexes.reset(hex.hex);
+	}
+
+	bool contains(BattleHex hex) const
+	{
+		return hex.isValid() && hexes.test(hex.hex);
+	}
+
+	size_t size() const { return hexes.count(); }
+	bool empty() const { return hexes.none(); }
+	void clear() { hexes.reset(); }
+
+	BattleHexSet & operator|=(const BattleHexSet & other)
+	{
+		hexes |= other.hexes;
+		return *this;
+	}
+
+	bool operator==(const BattleHexSet & other) const { return hexes == other.hexes; }
+	bool operator!=(const BattleHexSet & other) const { return hexes != other.hexes; }
+
+	/// calls func for every hex in set, in ascending order
+	template<typename Func>
+	void forEach(Func func) const
+	{
+		for(si16 i = 0; i < GameConstants::BFIELD_SIZE; i++)
+			if(hexes.test(i))
+				func(BattleHex(i));
+	}
+
+	std::vector<BattleHex> toVector() const
+	{
+		std::vector<BattleHex> ret;
+		ret.reserve(size());
+		forEach([&](BattleHex hex){ ret.push_back(hex); });
+		return ret;
+	}
+
+private:
+	std::bitset<GameConstants::BFIELD_SIZE> hexes;
+};
+
 DLL_EXPORT std::ostream & operator<<(std::ostream & os, const BattleHex & hex);
@@ -0,0 +1,153 @@
+#include "StdInc.h"
+#include "BattleReplay.h"
+
+#include "Connection.h"
+#include "CObjectHandler.h"
+#include "BattleState.h"
+#include "CHeroHandler.h"
+#include "CSpellHandler.h"
+
+/*
+ * BattleReplay.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+static const std::string BATTLE_RECORDING_MAGIC = "VCMIBATTLE";
+
+/// Copies bonuses of all ancestors of node except battle, which is recorded and to which army is attached again on replay
+static std::vector<Bonus> getInheritedBonuses(const CBonusSystemNode * node)
+{
+	std::vector<Bonus> ret;
+	std::set<const CBonusSystemNode *> visited;
+	std::set<const Bonus *> copied; //propagated bonuses may be wielded by more than one ancestor
+	std::vector<const CBonusSystemNode *> toVisit(1, node);
+	while(!toVisit.empty())
+	{
+		const CBonusSystemNode * current = toVisit.back();
+		toVisit.pop_back();
+		for(const CBonusSystemNode * parent : current->getParentNodes())
+		{
+			if(parent->getNodeType() == CBonusSystemNode::BATTLE || !visited.insert(parent).second)
+				continue;
+
+			for(const Bonus * b : parent->getBonusList())
+			{
+				if(!copied.insert(b).second)
+					continue;
+
+				ret.push_back(*b);
+				ret.back().propagator.reset(); //already propagated to node that wields it
+			}
+			toVisit.push_back(parent);
+		}
+	}
+	return ret;
+}
+
+static std::vector<RecordedArmy> getRecordedArmies(const BattleInfo * battle)
+{
+	std::vector<RecordedArmy> ret;
+	for(const SideInBattle & side : battle->sides)
+	{
+		const CArmedInstance * objects[] = {side.armyObject, side.hero};
+		for(const CArmedInstance * army : objects)
+		{
+			if(!army || vstd::contains_if(ret, [=](const RecordedArmy & recorded){ return recorded.army == army; }))
+				continue;
+
+			RecordedArmy recorded;
+			recorded.army = army;
+			recorded.inheritedBonuses = getInheritedBonuses(army);
+			ret.push_back(recorded);
+		}
+	}
+	return ret;
+}
+
+CBattleRecorder::CBattleRecorder(const std::string & filename, const BattleInfo * battle, ui32 seed)
+	: file(make_unique<CSaveFile>(filename))
+{
+	file->putMagicBytes(BATTLE_RECORDING_MAGIC);
+	//handler objects are referenced by ID, objects taking part in battle are written with it
+	file->addLibVecItems();
+	file->addTownTypes();
+	*file << battle << getRecordedArmies(battle) << seed;
+}
+
+CBattleRecorder::~CBattleRecorder()
+{
+}
+
+void CBattleRecorder::recordAction(const BattleAction & ba, bool custom)
+{
+	RecordedBattleAction recorded;
+	recorded.custom = custom;
+	recorded.action = ba;
+	actions.push_back(recorded);
+}
+
+void CBattleRecorder::finish(const BattleResult & result)
+{
+	*file << actions << result;
+	file.reset();
+}
+
+CBattleReplay::CBattleReplay(const std::string & filename)
+	: battle(nullptr), seed(0), nextActionIndex(0)
+{
+	CLoadFile file(filename);
+	file.checkMagicBytes(BATTLE_RECORDING_MAGIC);
+	file.addLibVecItems();
+	file.addTownTypes();
+	file >> battle >> armies >> seed >> actions >> recordedResult;
+
+	for(const RecordedArmy & recorded : armies)
+	{
+		auto army = const_cast<CArmedInstance *>(recorded.army);
+		auto node = make_unique<CBonusSystemNode>();
+		for(const Bonus & b : recorded.inheritedBonuses)
+			node->addNewBonus(new Bonus(b));
+
+		//loading attached army to its artifacts and town again, their bonuses are already in inherited ones
+		army->detachFromAll();
+		army->attachTo(node.get());
+		inheritedBonuses.push_back(std::move(node));
+	}
+}
+
+CBattleReplay::~CBattleReplay()
+{
+	for(size_t i = 0; i < armies.size(); i++)
+		const_cast<CArmedInstance *>(armies[i].army)->detachFrom(inheritedBonuses[i].get());
+}
+
+std::vector<CGObjectInstance *> CBattleReplay::getObjects() const
+{
+	std::vector<CGObjectInstance *> ret;
+	for(const RecordedArmy & recorded : armies)
+		ret.push_back(const_cast<CArmedInstance *>(recorded.army));
+	return ret;
+}
+
+bool CBattleReplay::hasNextAction() const
+{
+	return nextActionIndex < actions.size();
+}
+
+const RecordedBattleAction & CBattleReplay::nextAction()
+{
+	return actions.at(nextActionIndex++);
+}
+
+bool CBattleReplay::resultMatches(const BattleResult & result) const
+{
+	return result.result == recordedResult.result
+		&& result.winner == recordedResult.winner
+		&& result.casualties[0] == recordedResult.casualties[0]
+		&& result.casualties[1] == recordedResult.casualties[1];
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "BattleAction.h"
+#include "NetPacks.h"
+#include "HeroBonus.h"
+
+/*
+ * BattleReplay.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+class CSaveFile;
+class CArmedInstance;
+struct BattleInfo;
+
+/// Action made by player during recorded battle
+struct DLL_LINKAGE RecordedBattleAction
+{
+	bool custom; //hero spell, applied by makeCustomAction instead of makeBattleAction
+	BattleAction action;
+
+	template <typename Handler> void serialize(Handler &h, const int version)
+	{
+		h & custom & action;
+	}
+};
+
+/// Hero or army taking part in recorded battle. Rest of game state is not recorded, so bonuses
+/// that object inherits from it (player, team, artifacts, visited town...) are stored as copies.
+struct DLL_LINKAGE RecordedArmy
+{
+	const CArmedInstance *army;
+	std::vector<Bonus> inheritedBonuses;
+
+	template <typename Handler> void serialize(Handler &h, const int version)
+	{
+		h & army & inheritedBonuses;
+	}
+};
+
+/// Writes battle recording: battle at the beginning with objects taking part in it, seed of random generator,
+/// actions made by players and battle result. Actions made by server itself (war machines, morale,
+/// berserk...) are not recorded, they are repeated by replaying battle with the same seed.
+class DLL_LINKAGE CBattleRecorder
+{
+public:
+	CBattleRecorder(const std::string & filename, const BattleInfo * battle, ui32 seed); //throws!
+	~CBattleRecorder();
+
+	void recordAction(const BattleAction & ba, bool custom);
+	void finish(const BattleResult & result); //writes actions and result
+
+private:
+	unique_ptr<CSaveFile> file;
+	std::vector<RecordedBattleAction> actions;
+};
+
+/// Loads battle recording and gives recorded actions to game handler, which re-simulates battle without clients
+class DLL_LINKAGE CBattleReplay
+{
+public:
+	BattleInfo * battle; //battle at the moment of recording start
+	ui32 seed;
+	BattleResult recordedResult;
+
+	CBattleReplay(const std::string & filename); //throws!
+	~CBattleReplay();
+
+	std::vector<CGObjectInstance *> getObjects() const; //heroes and armies taking part in battle
+	bool hasNextAction() const;
+	const RecordedBattleAction & nextAction();
+	bool resultMatches(const BattleResult & result) const; //compares winner and casualties with recorded ones
+
+private:
+	std::vector<RecordedArmy> armies;
+	std::vector<unique_ptr<CBonusSystemNode> > inheritedBonuses; //replace parents of recorded armies
+	std::vector<RecordedBattleAction> actions;
+	size_t nextActionIndex;
+};
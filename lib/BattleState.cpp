@@ -51,7 +51,7 @@ int BattleInfo::getAvaliableHex(CreatureID creID, bool attackerOwned, int initia
  			pos = GameConstants::BFIELD_WIDTH - 1; //top right
  	}
 
-	auto accessibility = getAccesibility();
+	auto accessibility = calculateAccesibility(); //called while stacks are being added, state version may be not increased yet
 
 	std::set<BattleHex> occupyable;
 	for(int i = 0; i < accessibility.size(); i++)
@@ -829,11 +829,17 @@ CStack * BattleInfo::getStackT(BattleHex tileID, bool onlyAlive /*= true*/)
 }
 
 BattleInfo::BattleInfo()
+	: stateVersion(0)
 {
 	setBattle(this);
 	setNodeType(BATTLE);
 }
 
+void BattleInfo::stateChanged()
+{
+	stateVersion++;
+}
+
 CArmedInstance * BattleInfo::battleGetArmyObject(ui8 side) const
 {
 	return const_cast<CArmedInstance*>(CBattleInfoEssentials::battleGetArmyObject(side));
@@ -1059,6 +1065,25 @@ std::vector<BattleHex> CStack::getSurroundingHexes(BattleHex attackerPos) const
 	}
 }
 
+void CStack::getSurroundingHexes(BattleHexSet & out, BattleHex attackerPos) const
+{
+	BattleHex hex = (attackerPos != BattleHex::INVALID) ? attackerPos : position; //use hypothetical position
+	BattleHexSet hexes;
+	for(BattleHex neighbour : hex.getNeighbouringTiles())
+		hexes.insert(neighbour);
+
+	if (doubleWide())
+	{
+		//surroundings of two-hex stack are neighbours of both its hexes
+		BattleHex otherHex = occupiedHex(hex);
+		for(BattleHex neighbour : otherHex.getNeighbouringTiles())
+			hexes.insert(neighbour);
+		hexes.erase(hex);
+		hexes.erase(otherHex);
+	}
+	out |= hexes;
+}
+
 std::vector<si32> CStack::activeSpells() const
 {
 	std::vector<si32> ret;
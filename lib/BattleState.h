@@ -77,6 +77,48 @@ struct DLL_LINKAGE SideInBattle
 	}
 };
 
+/// Values calculated from state of battle, all of them are dropped when state version changes
+template <typename Key, typename Value>
+class BattleStateCache
+{
+	boost::mutex mx;
+	ui32 stateVersion;
+	std::map<Key, Value> values;
+
+public:
+	BattleStateCache() : stateVersion(0) {}
+
+	/// returns value stored for key in given state version, calculate() is called if there is none
+	template <typename Calculate>
+	Value get(ui32 currentVersion, const Key &key, Calculate calculate)
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		if(stateVersion != currentVersion)
+		{
+			values.clear();
+			stateVersion = currentVersion;
+		}
+
+		auto it = values.find(key);
+		if(it == values.end())
+			it = values.insert(std::make_pair(key, calculate())).first;
+
+		return it->second;
+	}
+};
+
+/// Results of battleGetStackQueue, key: turn (0 or -1), number of stacks
+struct StackQueueCache : public BattleStateCache<std::pair<int, int>, std::vector<const CStack *> > {};
+
+/// Damage factors of pairs of stacks, key: attacker ID, defender ID, shooting
+struct DamageFactorsCache : public BattleStateCache<std::tuple<ui32, ui32, bool>, DamageFactors> {};
+
+/// Accessibility of hexes, key: perspective of callback - some obstacles are hidden
+struct AccessibilityCache : public BattleStateCache<BattlePerspective::BattlePerspective, AccessibilityInfo> {};
+
+/// Reachability of stacks from their current positions, key: perspective of callback, stack ID, perspective of reachability
+struct ReachabilityCache : public BattleStateCache<std::tuple<BattlePerspective::BattlePerspective, ui32, BattlePerspective::BattlePerspective>, ReachabilityInfo> {};
+
 struct DLL_LINKAGE BattleInfo : public CBonusSystemNode, public CBattleInfoCallback
 {
 	std::array<SideInBattle, 2> sides; //sides[0] - attacker, sides[1] - defender
@@ -94,6 +136,12 @@ struct DLL_LINKAGE BattleInfo : public CBonusSystemNode, public CBattleInfoCallb
 	ui8 tacticsSide; //which side is requested to play tactics phase
 	ui8 tacticDistance; //how many hexes we can go forward (1 = only hexes adjacent to margin line)
 
+	ui32 stateVersion; //increased after every netpack applied during battle, used to invalidate caches; not serialized
+	mutable StackQueueCache stackQueueCache;
+	mutable DamageFactorsCache damageFactorsCache;
+	mutable AccessibilityCache accessibilityCache;
+	mutable ReachabilityCache reachabilityCache;
+
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
 		h & sides;
@@ -107,6 +155,8 @@ struct DLL_LINKAGE BattleInfo : public CBonusSystemNode, public CBattleInfoCallb
 	BattleInfo();
 	~BattleInfo(){};
 
+	void stateChanged(); //invalidates caches of battle state
+
 	//////////////////////////////////////////////////////////////////////////
 	CStack * getStackT(BattleHex tileID, bool onlyAlive = true);
 	CStack * getStack(int stackID, bool onlyAlive = true);
@@ -220,6 +270,7 @@ public:
 	static std::vector<BattleHex> getHexes(BattleHex assumedPos, bool twoHex, bool AttackerOwned); //up to two occupied hexes, starting from front
 	bool coversPos(BattleHex position) const; //checks also if unit is double-wide
 	std::vector<BattleHex> getSurroundingHexes(BattleHex attackerPos = BattleHex::INVALID) const; // get six or 8 surrounding hexes depending on creature size
+	void getSurroundingHexes(BattleHexSet & out, BattleHex attackerPos = BattleHex::INVALID) const; // adds surrounding hexes to out, doesn't allocate
 
 	std::pair<int,int> countKilledByAttack(int damageReceived) const; //returns pair<killed count, new left HP>
 	void prepareAttacked(BattleStackAttacked &bsa, boost::optional<int> customCount = boost::none) const; //requires bsa.damageAmout filled
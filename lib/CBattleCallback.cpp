@@ -268,6 +268,32 @@ si8 CBattleInfoEssentials::battleTacticDist() const
 	return getBattle()->tacticDistance;
 }
 
+ui32 CBattleInfoEssentials::battleGetStateVersion() const
+{
+	RETURN_IF_NOT_BATTLE(0);
+	return getBattle()->stateVersion;
+}
+
+StackQueueCache & CBattleInfoEssentials::battleGetStackQueueCache() const
+{
+	return getBattle()->stackQueueCache;
+}
+
+DamageFactorsCache & CBattleInfoEssentials::battleGetDamageFactorsCache() const
+{
+	return getBattle()->damageFactorsCache;
+}
+
+AccessibilityCache & CBattleInfoEssentials::battleGetAccessibilityCache() const
+{
+	return getBattle()->accessibilityCache;
+}
+
+ReachabilityCache & CBattleInfoEssentials::battleGetReachabilityCache() const
+{
+	return getBattle()->reachabilityCache;
+}
+
 si8 CBattleInfoEssentials::battleGetTacticsSide() const
 {
 	RETURN_IF_NOT_BATTLE(-1);
@@ -472,27 +498,36 @@ si8 CBattleInfoCallback::battleCanTeleportTo(const CStack * stack, BattleHex des
 
 std::set<BattleHex> CBattleInfoCallback::battleGetAttackedHexes(const CStack* attacker, BattleHex destinationTile, BattleHex attackerPos  /*= BattleHex::INVALID*/) const
 {
-	std::set<BattleHex> attackedHexes;
-	RETURN_IF_NOT_BATTLE(attackedHexes);
+	BattleHexSet attackedHexes;
+	battleGetAttackedHexes(attackedHexes, attacker, destinationTile, attackerPos);
 
-	AttackableTiles at = getPotentiallyAttackableHexes(attacker, destinationTile, attackerPos);
+	std::set<BattleHex> ret;
+	attackedHexes.forEach([&](BattleHex tile){ ret.insert(ret.end(), tile); });
+	return ret;
+}
 
-	for (BattleHex tile : at.hostileCreaturePositions)
-	{
-		const CStack * st = battleGetStackByPos(tile, true);
-		if(st && st->owner != attacker->owner) //only hostile stacks - does it work well with Berserk?
-		{
-			attackedHexes.insert(tile);
-		}
-	}
-	for (BattleHex tile : at.friendlyCreaturePositions)
+void CBattleInfoCallback::battleGetAttackedHexes(BattleHexSet & out, const CStack* attacker, BattleHex destinationTile, BattleHex attackerPos /*= BattleHex::INVALID*/) const
+{
+	out.clear();
+	RETURN_IF_NOT_BATTLE();
+
+	BattleHexSet hostile, friendly;
+	getPotentiallyAttackableHexes(hostile, friendly, attacker, destinationTile, attackerPos);
+
+	for(const CStack * st : battleGetAllStacks(true))
 	{
-		if(battleGetStackByPos(tile, true)) //friendly stacks can also be damaged by Dragon Breath
+		if(!st->alive())
+			continue;
+
+		const BattleHex hexes[] = {st->position, st->occupiedHex()};
+		for(BattleHex tile : hexes)
 		{
-			attackedHexes.insert(tile);
+			if(st->owner != attacker->owner && hostile.contains(tile)) //only hostile stacks - does it work well with Berserk?
+				out.insert(tile);
+			if(friendly.contains(tile)) //friendly stacks can also be damaged by Dragon Breath
+				out.insert(tile);
 		}
 	}
-	return attackedHexes;
 }
 
 SpellID CBattleInfoCallback::battleGetRandomStackSpell(const CStack * stack, ERandomSpell mode) const
@@ -525,6 +560,24 @@ void CBattleInfoCallback::battleGetStackQueue(std::vector<const CStack *> &out,
 {
 	RETURN_IF_NOT_BATTLE();
 
+	//only queue starting from current moment is cached - it's requested by client, AI and server after every action
+	if(!out.empty() || (turn != 0 && turn != -1) || lastMoved != -1)
+	{
+		calculateStackQueue(out, howMany, turn, lastMoved);
+		return;
+	}
+
+	out = battleGetStackQueueCache().get(battleGetStateVersion(), std::make_pair(turn, howMany), [&]() -> std::vector<const CStack *>
+	{
+		std::vector<const CStack *> queue;
+		calculateStackQueue(queue, howMany, turn, lastMoved);
+		return queue;
+	});
+}
+
+void CBattleInfoCallback::calculateStackQueue(std::vector<const CStack *> &out, const int howMany, const int turn, int lastMoved) const
+{
+
 	//let's define a huge lambda
 	auto takeStack = [&](std::vector<const CStack *> &st) -> const CStack*
 	{
@@ -670,7 +723,7 @@ void CBattleInfoCallback::battleGetStackQueue(std::vector<const CStack *> &out,
 			if(pi > 3)
 			{
 				//if(turn != 2)
-				battleGetStackQueue(out, howMany, turn + 1, lastMoved);
+				calculateStackQueue(out, howMany, turn + 1, lastMoved);
 				return;
 			}
 		}
@@ -692,11 +745,24 @@ void CBattleInfoCallback::battleGetStackCountOutsideHexes(bool *ac) const
 
 std::vector<BattleHex> CBattleInfoCallback::battleGetAvailableHexes(const CStack * stack, bool addOccupiable, std::vector<BattleHex> * attackable) const
 {
-	std::vector<BattleHex> ret;
+	BattleHexSet available, attackableSet;
+	battleGetAvailableHexes(available, stack, addOccupiable, attackable ? &attackableSet : nullptr);
 
-	RETURN_IF_NOT_BATTLE(ret);
+	if(attackable)
+	{
+		auto attackableHexes = attackableSet.toVector();
+		attackable->insert(attackable->end(), attackableHexes.begin(), attackableHexes.end());
+	}
+	return available.toVector();
+}
+
+void CBattleInfoCallback::battleGetAvailableHexes(BattleHexSet & out, const CStack * stack, bool addOccupiable, BattleHexSet * attackable) const
+{
+	out.clear();
+
+	RETURN_IF_NOT_BATTLE();
 	if(!stack->position.isValid()) //turrets
-		return ret;
+		return;
 
 	auto reachability = getReachability(stack);
 
@@ -719,12 +785,12 @@ std::vector<BattleHex> CBattleInfoCallback::battleGetAvailableHexes(const CStack
 				continue;
 		}
 
-		ret.push_back(i);
+		out.insert(i);
 
 		if(addOccupiable && stack->doubleWide())
 		{
 			//If two-hex stack can stand on hex i then obviously it can occupy its second hex from that position
-			ret.push_back(stack->occupiedHex(i));
+			out.insert(stack->occupiedHex(i));
 		}
 	}
 
@@ -734,11 +800,11 @@ std::vector<BattleHex> CBattleInfoCallback::battleGetAvailableHexes(const CStack
 		auto meleeAttackable = [&](BattleHex hex) -> bool
 		{
 			// Return true if given hex has at least one available neighbour.
-			// Available hexes are already present in ret vector.
-			auto availableNeighbor = boost::find_if(ret, [=] (BattleHex availableHex)
-				{  return BattleHex::mutualPosition(hex, availableHex) >= 0;  });
-
-			return availableNeighbor != ret.end();
+			// Second hex of two-hex stack may stand in side column, so these neighbours count too.
+			for(BattleHex neighbour : hex.getAllNeighbouringTiles())
+				if(out.contains(neighbour))
+					return true;
+			return false;
 		};
 
 		for(const CStack * otherSt : battleAliveStacks(stack->attackerOwned))
@@ -746,26 +812,22 @@ std::vector<BattleHex> CBattleInfoCallback::battleGetAvailableHexes(const CStack
 			if(!otherSt->isValidTarget(false))
 				continue;
 
-			std::vector<BattleHex> occupied = otherSt->getHexes();
+			const BattleHex occupied[] = {otherSt->position, otherSt->occupiedHex()};
 
 			if(battleCanShoot(stack, otherSt->position))
 			{
-				attackable->insert(attackable->end(), occupied.begin(), occupied.end());
+				for(BattleHex he : occupied)
+					attackable->insert(he);
 				continue;
 			}
 
 			for(BattleHex he : occupied)
 			{
 				if(meleeAttackable(he))
-					attackable->push_back(he);
+					attackable->insert(he);
 			}
 		}
 	}
-
-	//adding occupiable likely adds duplicates to ret -> clean it up
-	boost::sort(ret);
-	ret.erase(boost::unique(ret).end(), ret.end());
-	return ret;
 }
 
 bool CBattleInfoCallback::battleCanShoot(const CStack * stack, BattleHex dest) const
@@ -804,6 +866,140 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const CStack* attacker, const C
 }
 
 TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo &info) const
+{
+	//hypothetic bonus bearers (used by AI) may change at any moment, cache only factors of real stacks
+	if(info.attackerBonuses != info.attacker || info.defenderBonuses != info.defender || !duringBattle())
+		return calculateDmgRange(info, calculateDmgFactors(info));
+
+	const auto key = std::make_tuple(info.attacker->ID, info.defender->ID, info.shooting);
+	const DamageFactors factors = battleGetDamageFactorsCache().get(battleGetStateVersion(), key, [&]{ return calculateDmgFactors(info); });
+	return calculateDmgRange(info, factors);
+}
+
+TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo &info, const DamageFactors &factors) const
+{
+	double additiveBonus = 1.0, multBonus = factors.multBonus,
+		minDmg = factors.minDmg,
+		maxDmg = factors.maxDmg;
+
+	if(factors.multiplyByCount)
+	{
+		minDmg *= info.attackerCount;
+		maxDmg *= info.attackerCount;
+	}
+
+	additiveBonus += factors.attackDefenceBonus;
+
+	//applying jousting bonus
+	if(factors.jousting)
+		additiveBonus += info.chargedFields * 0.05;
+
+	additiveBonus += factors.skillBonus;
+	additiveBonus += factors.hateBonus;
+
+	//luck bonus
+	if (info.luckyHit)
+	{
+		additiveBonus += 1.0;
+	}
+	//unlucky hit, used only if negative luck is enabled
+	if (info.unluckyHit)
+	{
+		additiveBonus -= 0.5; // FIXME: how bad (and luck in general) should work with following bonuses?
+	}
+
+	//ballista double dmg
+	if(info.ballistaDoubleDamage)
+	{
+		additiveBonus += 1.0;
+	}
+
+	if (info.deathBlow) //Dread Knight and many WoGified creatures
+	{
+		additiveBonus += 1.0;
+	}
+
+	//wall / distance penalty + advanced air shield
+	if (info.shooting)
+	{
+		const bool distPenalty = !factors.noDistancePenalty && battleHasDistancePenalty(info.attackerBonuses, info.attackerPosition, info.defenderPosition);
+		if (distPenalty || factors.airShield)
+		{
+			multBonus *= 0.5;
+		}
+		if (battleHasWallPenalty(info.attackerBonuses, info.attackerPosition, info.defenderPosition))
+		{
+			multBonus *= 0.5; //cumulative
+		}
+	}
+	if(!info.shooting && factors.meleePenalty)
+	{
+		multBonus *= 0.5;
+	}
+
+
+	// TODO attack on petrified unit 50%
+	// psychic elementals versus mind immune units 50%
+	// blinded unit retaliates
+
+	minDmg *= additiveBonus * multBonus;
+	maxDmg *= additiveBonus * multBonus;
+
+	TDmgRange returnedVal;
+
+	if(factors.curse) //curse handling (rest)
+	{
+		minDmg += factors.curseBlessModifier;
+		returnedVal = std::make_pair(int(minDmg), int(minDmg));
+	}
+	else if(factors.bless) //bless handling
+	{
+		maxDmg += factors.curseBlessModifier;
+		returnedVal =  std::make_pair(int(maxDmg), int(maxDmg));
+	}
+	else
+	{
+		returnedVal =  std::make_pair(int(minDmg), int(maxDmg));
+	}
+
+	//damage cannot be less than 1
+	vstd::amax(returnedVal.first, 1);
+	vstd::amax(returnedVal.second, 1);
+
+	return returnedVal;
+}
+
+void CBattleInfoCallback::calculateDmgRanges(std::vector<TDmgRange> &out, const BattleAttackInfo &info, const TStacks &defenders) const
+{
+	out.clear();
+	out.reserve(defenders.size());
+
+	DamageFactors attackerFactors;
+	calculateAttackerDmgFactors(attackerFactors, info);
+
+	for(const CStack *defender : defenders)
+	{
+		BattleAttackInfo bai = info;
+		bai.defender = defender;
+		bai.defenderBonuses = defender;
+		bai.defenderPosition = defender->position;
+		bai.defenderCount = defender->count;
+
+		DamageFactors factors = attackerFactors;
+		calculateDefenderDmgFactors(factors, bai);
+		out.push_back(calculateDmgRange(bai, factors));
+	}
+}
+
+DamageFactors CBattleInfoCallback::calculateDmgFactors(const BattleAttackInfo &info) const
+{
+	DamageFactors ret;
+	calculateAttackerDmgFactors(ret, info);
+	calculateDefenderDmgFactors(ret, info);
+	return ret;
+}
+
+void CBattleInfoCallback::calculateAttackerDmgFactors(DamageFactors &out, const BattleAttackInfo &info) const
 {
 	auto battleBonusValue = [&](const IBonusBearer * bearer, CSelector selector) -> int
 	{
@@ -816,16 +1012,16 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo &info) c
 		return bearer->getBonuses(selector, noLimit.Or(limitMatches))->totalValue();
 	};
 
-	double additiveBonus = 1.0, multBonus = 1.0,
-		minDmg = info.attackerBonuses->getMinDamage() * info.attackerCount,//TODO: ONLY_MELEE_FIGHT / ONLY_DISTANCE_FIGHT
-		maxDmg = info.attackerBonuses->getMaxDamage() * info.attackerCount;
+	out.minDmg = info.attackerBonuses->getMinDamage(); //TODO: ONLY_MELEE_FIGHT / ONLY_DISTANCE_FIGHT
+	out.maxDmg = info.attackerBonuses->getMaxDamage();
+	out.multiplyByCount = true;
 
-	const CCreature *attackerType = info.attacker->getCreature(),
-		*defenderType = info.defender->getCreature();
+	const CCreature *attackerType = info.attacker->getCreature();
 
 	if(attackerType->idNumber == CreatureID::ARROW_TOWERS)
 	{
-		SiegeStuffThatShouldBeMovedToHandlers::retreiveTurretDamageRange(battleGetDefendedTown(), info.attacker, minDmg, maxDmg);
+		SiegeStuffThatShouldBeMovedToHandlers::retreiveTurretDamageRange(battleGetDefendedTown(), info.attacker, out.minDmg, out.maxDmg);
+		out.multiplyByCount = false;
 	}
 
 	if(info.attackerBonuses->hasBonusOfType(Bonus::SIEGE_WEAPON) && attackerType->idNumber != CreatureID::ARROW_TOWERS) //any siege weapon, but only ballista can attack (second condition - not arrow turret)
@@ -837,17 +1033,40 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo &info) c
 		};
 
 
-		minDmg *= retreiveHeroPrimSkill(PrimarySkill::ATTACK) + 1;
-		maxDmg *= retreiveHeroPrimSkill(PrimarySkill::ATTACK) + 1;
+		out.minDmg *= retreiveHeroPrimSkill(PrimarySkill::ATTACK) + 1;
+		out.maxDmg *= retreiveHeroPrimSkill(PrimarySkill::ATTACK) + 1;
 	}
 
-	int attackDefenceDifference = 0;
+	out.attackReduction = (100 - battleBonusValue (info.attackerBonuses, Selector::type(Bonus::GENERAL_ATTACK_REDUCTION))) / 100.0;
+	out.attack = battleBonusValue (info.attackerBonuses, Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK));
+	out.defenceReduction = (100 - battleBonusValue (info.attackerBonuses, Selector::type(Bonus::ENEMY_DEFENCE_REDUCTION))) / 100.0;
+
+	out.jousting = info.attackerBonuses->hasBonusOfType(Bonus::JOUSTING);
+
+	//handling secondary abilities and artifacts giving premies to them
+	if(info.shooting)
+		out.skillBonus = info.attackerBonuses->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARCHERY) / 100.0;
+	else
+		out.skillBonus = info.attackerBonuses->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::OFFENCE) / 100.0;
 
-	double multAttackReduction = (100 - battleBonusValue (info.attackerBonuses, Selector::type(Bonus::GENERAL_ATTACK_REDUCTION))) / 100.0;
-	attackDefenceDifference += battleBonusValue (info.attackerBonuses, Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK)) * multAttackReduction;
+	TBonusListPtr curseEffects = info.attackerBonuses->getBonuses(Selector::type(Bonus::ALWAYS_MINIMUM_DAMAGE));
+	TBonusListPtr blessEffects = info.attackerBonuses->getBonuses(Selector::type(Bonus::ALWAYS_MAXIMUM_DAMAGE));
+	out.curse = curseEffects->size();
+	out.bless = blessEffects->size();
+	out.curseBlessModifier = blessEffects->totalValue() - curseEffects->totalValue();
+	out.cursePenalty = curseEffects->size() ? (*std::max_element(curseEffects->begin(), curseEffects->end(), &Bonus::compareByAdditionalInfo))->additionalInfo : 0;
 
-	double multDefenceReduction = (100 - battleBonusValue (info.attackerBonuses, Selector::type(Bonus::ENEMY_DEFENCE_REDUCTION))) / 100.0;
-	attackDefenceDifference -= info.defenderBonuses->Defense() * multDefenceReduction;
+	out.noDistancePenalty = info.attackerBonuses->hasBonusOfType(Bonus::NO_DISTANCE_PENALTY);
+	out.meleePenalty = info.attackerBonuses->hasBonusOfType(Bonus::SHOOTER) && !info.attackerBonuses->hasBonusOfType(Bonus::NO_MELEE_PENALTY);
+}
+
+void CBattleInfoCallback::calculateDefenderDmgFactors(DamageFactors &out, const BattleAttackInfo &info) const
+{
+	const CCreature *defenderType = info.defender->getCreature();
+
+	int attackDefenceDifference = 0;
+	attackDefenceDifference += out.attack * out.attackReduction;
+	attackDefenceDifference -= info.defenderBonuses->Defense() * out.defenceReduction;
 
 	if(const Bonus *slayerEffect = info.attackerBonuses->getEffect(SpellID::SLAYER)) //slayer handling //TODO: apply only ONLY_MELEE_FIGHT / DISTANCE_FIGHT?
 	{
@@ -878,76 +1097,42 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo &info) c
 		}
 	}
 
+	out.attackDefenceBonus = 0;
+	out.multBonus = 1.0;
+
 	//bonus from attack/defense skills
 	if(attackDefenceDifference < 0) //decreasing dmg
 	{
 		const double dec = std::min(0.025 * (-attackDefenceDifference), 0.7);
-		multBonus *= 1.0 - dec;
+		out.multBonus *= 1.0 - dec;
 	}
 	else //increasing dmg
 	{
 		const double inc = std::min(0.05 * attackDefenceDifference, 4.0);
-		additiveBonus += inc;
+		out.attackDefenceBonus = inc;
 	}
 
-
-	//applying jousting bonus
-	if( info.attackerBonuses->hasBonusOfType(Bonus::JOUSTING) && !info.defenderBonuses->hasBonusOfType(Bonus::CHARGE_IMMUNITY) )
-		additiveBonus += info.chargedFields * 0.05;
-
-
-	//handling secondary abilities and artifacts giving premies to them
-	if(info.shooting)
-		additiveBonus += info.attackerBonuses->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARCHERY) / 100.0;
-	else
-		additiveBonus += info.attackerBonuses->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::OFFENCE) / 100.0;
+	out.jousting = out.jousting && !info.defenderBonuses->hasBonusOfType(Bonus::CHARGE_IMMUNITY);
 
 	if(info.defenderBonuses)
-		multBonus *= (std::max(0, 100 - info.defenderBonuses->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARMORER))) / 100.0;
+		out.multBonus *= (std::max(0, 100 - info.defenderBonuses->valOfBonuses(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARMORER))) / 100.0;
 
 	//handling hate effect
-	additiveBonus += info.attackerBonuses->valOfBonuses(Bonus::HATE, defenderType->idNumber.toEnum()) / 100.;
-
-	//luck bonus
-	if (info.luckyHit)
-	{
-		additiveBonus += 1.0;
-	}
-	//unlucky hit, used only if negative luck is enabled
-	if (info.unluckyHit)
-	{
-		additiveBonus -= 0.5; // FIXME: how bad (and luck in general) should work with following bonuses?
-	}
-
-	//ballista double dmg
-	if(info.ballistaDoubleDamage)
-	{
-		additiveBonus += 1.0;
-	}
-
-	if (info.deathBlow) //Dread Knight and many WoGified creatures
-	{
-		additiveBonus += 1.0;
-	}
+	out.hateBonus = info.attackerBonuses->valOfBonuses(Bonus::HATE, defenderType->idNumber.toEnum()) / 100.;
 
 	//handling spell effects
 	if(!info.shooting) //eg. shield
 	{
-		multBonus *= (100 - info.defenderBonuses->valOfBonuses(Bonus::GENERAL_DAMAGE_REDUCTION, 0)) / 100.0;
+		out.multBonus *= (100 - info.defenderBonuses->valOfBonuses(Bonus::GENERAL_DAMAGE_REDUCTION, 0)) / 100.0;
 	}
 	else if(info.shooting) //eg. air shield
 	{
-		multBonus *= (100 - info.defenderBonuses->valOfBonuses(Bonus::GENERAL_DAMAGE_REDUCTION, 1)) / 100.0;
+		out.multBonus *= (100 - info.defenderBonuses->valOfBonuses(Bonus::GENERAL_DAMAGE_REDUCTION, 1)) / 100.0;
 	}
 
-	TBonusListPtr curseEffects = info.attackerBonuses->getBonuses(Selector::type(Bonus::ALWAYS_MINIMUM_DAMAGE));
-	TBonusListPtr blessEffects = info.attackerBonuses->getBonuses(Selector::type(Bonus::ALWAYS_MAXIMUM_DAMAGE));
-	int curseBlessAdditiveModifier = blessEffects->totalValue() - curseEffects->totalValue();
-	double curseMultiplicativePenalty = curseEffects->size() ? (*std::max_element(curseEffects->begin(), curseEffects->end(), &Bonus::compareByAdditionalInfo))->additionalInfo : 0;
-
-	if(curseMultiplicativePenalty) //curse handling (partial, the rest is below)
+	if(out.cursePenalty) //curse handling (partial, the rest is in calculateDmgRange)
 	{
-		multBonus *= 1.0 - curseMultiplicativePenalty/100;
+		out.multBonus *= 1.0 - out.cursePenalty/100;
 	}
 
 	auto isAdvancedAirShield = [](const Bonus *bonus)
@@ -956,57 +1141,7 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo &info) c
 			&& bonus->sid == SpellID::AIR_SHIELD
 			&& bonus->val >= SecSkillLevel::ADVANCED;
 	};
-
-	//wall / distance penalty + advanced air shield
-	const bool distPenalty = !info.attackerBonuses->hasBonusOfType(Bonus::NO_DISTANCE_PENALTY) && battleHasDistancePenalty(info.attackerBonuses, info.attackerPosition, info.defenderPosition);
-	const bool obstaclePenalty = battleHasWallPenalty(info.attackerBonuses, info.attackerPosition, info.defenderPosition);
-
-	if (info.shooting)
-	{
-		if (distPenalty || info.defenderBonuses->hasBonus(isAdvancedAirShield))
-		{
-			multBonus *= 0.5;
-		}
-		if (obstaclePenalty)
-		{
-			multBonus *= 0.5; //cumulative
-		}
-	}
-	if(!info.shooting && info.attackerBonuses->hasBonusOfType(Bonus::SHOOTER) && !info.attackerBonuses->hasBonusOfType(Bonus::NO_MELEE_PENALTY))
-	{
-		multBonus *= 0.5;
-	}
-
-
-	// TODO attack on petrified unit 50%
-	// psychic elementals versus mind immune units 50%
-	// blinded unit retaliates
-
-	minDmg *= additiveBonus * multBonus;
-	maxDmg *= additiveBonus * multBonus;
-
-	TDmgRange returnedVal;
-
-	if(curseEffects->size()) //curse handling (rest)
-	{
-		minDmg += curseBlessAdditiveModifier;
-		returnedVal = std::make_pair(int(minDmg), int(minDmg));
-	}
-	else if(blessEffects->size()) //bless handling
-	{
-		maxDmg += curseBlessAdditiveModifier;
-		returnedVal =  std::make_pair(int(maxDmg), int(maxDmg));
-	}
-	else
-	{
-		returnedVal =  std::make_pair(int(minDmg), int(maxDmg));
-	}
-
-	//damage cannot be less than 1
-	vstd::amax(returnedVal.first, 1);
-	vstd::amax(returnedVal.second, 1);
-
-	return returnedVal;
+	out.airShield = info.shooting && info.defenderBonuses->hasBonus(isAdvancedAirShield);
 }
 
 TDmgRange CBattleInfoCallback::calculateDmgRange( const CStack* attacker, const CStack* defender, TQuantity attackerCount,
@@ -1081,6 +1216,14 @@ shared_ptr<const CObstacleInstance> CBattleInfoCallback::battleGetObstacleOnPos(
 }
 
 AccessibilityInfo CBattleInfoCallback::getAccesibility() const
+{
+	if(!duringBattle())
+		return calculateAccesibility();
+
+	return battleGetAccessibilityCache().get(battleGetStateVersion(), battleGetMySide(), [&]{ return calculateAccesibility(); });
+}
+
+AccessibilityInfo CBattleInfoCallback::calculateAccesibility() const
 {
 	AccessibilityInfo ret;
 	ret.fill(EAccessibility::ACCESSIBLE);
@@ -1166,16 +1309,17 @@ ReachabilityInfo CBattleInfoCallback::makeBFS(const AccessibilityInfo &accessibi
 	//const bool twoHexCreature = params.doubleWide;
 
 
-	std::queue<BattleHex> hexq; //bfs queue
+	//bfs queue - every hex is queued at most once, when its final distance is found
+	BattleHex hexq[GameConstants::BFIELD_SIZE];
+	int queueBegin = 0, queueEnd = 0;
 
 	//first element
-	hexq.push(params.startPosition);
+	hexq[queueEnd++] = params.startPosition;
 	ret.distances[params.startPosition] = 0;
 
-	while(!hexq.empty()) //bfs loop
+	while(queueBegin != queueEnd) //bfs loop
 	{
-		const BattleHex curHex = hexq.front();
-		hexq.pop();
+		const BattleHex curHex = hexq[queueBegin++];
 
 		//walking stack can't step past the quicksands
 		//TODO what if second hex of two-hex creature enters quicksand
@@ -1183,14 +1327,15 @@ ReachabilityInfo CBattleInfoCallback::makeBFS(const AccessibilityInfo &accessibi
 			continue;
 
 		const int costToNeighbour = ret.distances[curHex] + 1;
-		for(BattleHex neighbour : curHex.neighbouringTiles())
+		for(BattleHex neighbour : curHex.getNeighbouringTiles())
 		{
 			const bool accessible = accessibility.accessible(neighbour, params.doubleWide, params.attackerOwned);
 			const int costFoundSoFar = ret.distances[neighbour];
 
 			if(accessible  &&  costToNeighbour < costFoundSoFar)
 			{
-				hexq.push(neighbour);
+				assert(queueEnd < GameConstants::BFIELD_SIZE);
+				hexq[queueEnd++] = neighbour;
 				ret.distances[neighbour] = costToNeighbour;
 				ret.predecessors[neighbour] = curHex;
 			}
@@ -1292,21 +1437,31 @@ ReachabilityInfo CBattleInfoCallback::getReachability(const CStack *stack) const
 		params.perspective = battleGetMySide();
 	}
 
-	return getReachability(params);
+	if(!duringBattle())
+		return getReachability(params);
+
+	//stack position and movement bonuses can be changed only by netpacks, so stack ID is enough to identify parameters
+	const auto key = std::make_tuple(battleGetMySide(), stack->ID, params.perspective);
+	return battleGetReachabilityCache().get(battleGetStateVersion(), key, [&]{ return getReachability(params); });
 }
 
 ReachabilityInfo CBattleInfoCallback::getReachability(const ReachabilityInfo::Parameters &params) const
+{
+	return getReachability(getAccesibility(params.knownAccessible), params);
+}
+
+ReachabilityInfo CBattleInfoCallback::getReachability(const AccessibilityInfo &accessibility, const ReachabilityInfo::Parameters &params) const
 {
 	if(params.flying)
-		return getFlyingReachability(params);
+		return getFlyingReachability(accessibility, params);
 	else
-		return makeBFS(getAccesibility(params.knownAccessible), params);
+		return makeBFS(accessibility, params);
 }
 
-ReachabilityInfo CBattleInfoCallback::getFlyingReachability(const ReachabilityInfo::Parameters &params) const
+ReachabilityInfo CBattleInfoCallback::getFlyingReachability(const AccessibilityInfo &accessibility, const ReachabilityInfo::Parameters &params) const
 {
 	ReachabilityInfo ret;
-	ret.accessibility = getAccesibility(params.knownAccessible);
+	ret.accessibility = accessibility;
 
 	for(int i = 0; i < GameConstants::BFIELD_SIZE; i++)
 	{
@@ -1321,13 +1476,26 @@ ReachabilityInfo CBattleInfoCallback::getFlyingReachability(const ReachabilityIn
 }
 
 AttackableTiles CBattleInfoCallback::getPotentiallyAttackableHexes (const CStack* attacker, BattleHex destinationTile, BattleHex attackerPos) const
+{
+	AttackableTiles at;
+	RETURN_IF_NOT_BATTLE(at);
+
+	BattleHexSet hostile, friendly;
+	getPotentiallyAttackableHexes(hostile, friendly, attacker, destinationTile, attackerPos);
+	hostile.forEach([&](BattleHex tile){ at.hostileCreaturePositions.insert(at.hostileCreaturePositions.end(), tile); });
+	friendly.forEach([&](BattleHex tile){ at.friendlyCreaturePositions.insert(at.friendlyCreaturePositions.end(), tile); });
+	return at;
+}
+
+void CBattleInfoCallback::getPotentiallyAttackableHexes(BattleHexSet & hostile, BattleHexSet & friendly, const CStack* attacker, BattleHex destinationTile, BattleHex attackerPos) const
 {
 	//does not return hex attacked directly
 	//TODO: apply rotation to two-hex attackers
 	bool isAttacker = attacker->attackerOwned;
 
-	AttackableTiles at;
-	RETURN_IF_NOT_BATTLE(at);
+	hostile.clear();
+	friendly.clear();
+	RETURN_IF_NOT_BATTLE();
 
 	const int WN = GameConstants::BFIELD_WIDTH;
 	ui16 hex = (attackerPos != BattleHex::INVALID) ? attackerPos.hex : attacker->position.hex; //real or hypothetical (cursor) position
@@ -1340,78 +1508,83 @@ AttackableTiles CBattleInfoCallback::getPotentiallyAttackableHexes (const CStack
 	}
 	if (attacker->hasBonusOfType(Bonus::ATTACKS_ALL_ADJACENT))
 	{
-		boost::copy (attacker->getSurroundingHexes (attackerPos), vstd::set_inserter (at.hostileCreaturePositions));
+		attacker->getSurroundingHexes(hostile, attackerPos);
 	}
 	if (attacker->hasBonusOfType(Bonus::THREE_HEADED_ATTACK))
 	{
-		std::vector<BattleHex> hexes = attacker->getSurroundingHexes(attackerPos);
-		for (BattleHex tile : hexes)
+		BattleHexSet hexes;
+		attacker->getSurroundingHexes(hexes, attackerPos);
+		hexes.forEach([&](BattleHex tile)
 		{
 			if ((BattleHex::mutualPosition(tile, destinationTile) > -1 && BattleHex::mutualPosition (tile, hex) > -1)) //adjacent both to attacker's head and attacked tile
 			{
 				const CStack * st = battleGetStackByPos(tile, true);
 				if(st && st->owner != attacker->owner) //only hostile stacks - does it work well with Berserk?
 				{
-					at.hostileCreaturePositions.insert(tile);
+					hostile.insert(tile);
 				}
 			}
-		}
+		});
 	}
 	if (attacker->hasBonusOfType(Bonus::TWO_HEX_ATTACK_BREATH) && BattleHex::mutualPosition (destinationTile.hex, hex) > -1) //only adjacent hexes are subject of dragon breath calculation
 	{
-		std::vector<BattleHex> hexes; //only one, in fact
+		BattleHex tile; //only one, in fact
 		int pseudoVector = destinationTile.hex - hex;
 		switch (pseudoVector)
 		{
 		case 1:
 		case -1:
-			BattleHex::checkAndPush (destinationTile.hex + pseudoVector, hexes);
+			tile = destinationTile.hex + pseudoVector;
 			break;
 		case WN: //17 //left-down or right-down
 		case -WN: //-17 //left-up or right-up
 		case WN + 1: //18 //right-down
 		case -WN + 1: //-16 //right-up
-			BattleHex::checkAndPush (destinationTile.hex + pseudoVector + ((hex/WN)%2 ? 1 : -1 ), hexes);
+			tile = destinationTile.hex + pseudoVector + ((hex/WN)%2 ? 1 : -1 );
 			break;
 		case WN-1: //16 //left-down
 		case -WN-1: //-18 //left-up
-			BattleHex::checkAndPush (destinationTile.hex + pseudoVector + ((hex/WN)%2 ? 1 : 0), hexes);
+			tile = destinationTile.hex + pseudoVector + ((hex/WN)%2 ? 1 : 0);
 			break;
 		}
-		for (BattleHex tile : hexes)
-		{
-			//friendly stacks can also be damaged by Dragon Breath
-			if (battleGetStackByPos (tile, true))
-				at.friendlyCreaturePositions.insert (tile);
-		}
+		//friendly stacks can also be damaged by Dragon Breath
+		if (tile.isAvailable() && battleGetStackByPos (tile, true))
+			friendly.insert (tile);
 	}
-
-	return at;
 }
 
 std::set<const CStack*> CBattleInfoCallback::getAttackedCreatures(const CStack* attacker, BattleHex destinationTile, BattleHex attackerPos /*= BattleHex::INVALID*/) const
 {
-	std::set<const CStack*> attackedCres;
-	RETURN_IF_NOT_BATTLE(attackedCres);
+	std::vector<const CStack*> attackedCres;
+	getAttackedCreatures(attackedCres, attacker, destinationTile, attackerPos);
+	return std::set<const CStack*>(attackedCres.begin(), attackedCres.end());
+}
 
-	AttackableTiles at = getPotentiallyAttackableHexes(attacker, destinationTile, attackerPos);
-	for (BattleHex tile : at.hostileCreaturePositions) //all around & three-headed attack
-	{
-		const CStack * st = battleGetStackByPos(tile, true);
-		if(st && st->owner != attacker->owner) //only hostile stacks - does it work well with Berserk?
-		{
-			attackedCres.insert(st);
-		}
-	}
-	for (BattleHex tile : at.friendlyCreaturePositions)
+void CBattleInfoCallback::getAttackedCreatures(std::vector<const CStack*> & out, const CStack* attacker, BattleHex destinationTile, BattleHex attackerPos /*= BattleHex::INVALID*/) const
+{
+	out.clear();
+	RETURN_IF_NOT_BATTLE();
+
+	BattleHexSet hostile, friendly;
+	getPotentiallyAttackableHexes(hostile, friendly, attacker, destinationTile, attackerPos);
+
+	for(const CStack * st : battleGetAllStacks(true))
 	{
-		const CStack * st = battleGetStackByPos(tile, true);
-		if(st) //friendly stacks can also be damaged by Dragon Breath
+		if(!st->alive())
+			continue;
+
+		const bool isHostile = st->owner != attacker->owner; //only hostile stacks - does it work well with Berserk?
+		const BattleHex hexes[] = {st->position, st->occupiedHex()};
+		for(BattleHex tile : hexes)
 		{
-			attackedCres.insert(st);
+			//friendly stacks can also be damaged by Dragon Breath
+			if((isHostile && hostile.contains(tile)) || friendly.contains(tile))
+			{
+				out.push_back(st);
+				break;
+			}
 		}
 	}
-	return attackedCres;
 }
 
 //TODO: this should apply also to mechanics and cursor interface
@@ -2485,6 +2658,13 @@ BattleAttackInfo::BattleAttackInfo(const CStack *Attacker, const CStack *Defende
 	ballistaDoubleDamage = false;
 }
 
+DamageFactors::DamageFactors()
+	: minDmg(0), maxDmg(0), multiplyByCount(true), attack(0), attackReduction(1.0), defenceReduction(1.0), skillBonus(0),
+	cursePenalty(0), curse(false), bless(false), curseBlessModifier(0), noDistancePenalty(false), meleePenalty(false),
+	jousting(false), attackDefenceBonus(0), hateBonus(0), multBonus(1.0), airShield(false)
+{
+}
+
 BattleAttackInfo BattleAttackInfo::reverse() const
 {
 	BattleAttackInfo ret = *this;
@@ -17,6 +17,10 @@ class CGHeroInstance;
 class CStack;
 class CSpell;
 struct BattleInfo;
+struct StackQueueCache;
+struct DamageFactorsCache;
+struct AccessibilityCache;
+struct ReachabilityCache;
 struct CObstacleInstance;
 class IBonusBearer;
 struct InfoAboutHero;
@@ -157,6 +161,10 @@ class DLL_LINKAGE CBattleInfoEssentials : public virtual CCallbackBase
 {
 protected:
 	bool battleDoWeKnowAbout(ui8 side) const;
+	StackQueueCache & battleGetStackQueueCache() const;
+	DamageFactorsCache & battleGetDamageFactorsCache() const;
+	AccessibilityCache & battleGetAccessibilityCache() const;
+	ReachabilityCache & battleGetReachabilityCache() const;
 public:
 	enum EStackOwnership
 	{
@@ -174,6 +182,7 @@ public:
 	const CGTownInstance * battleGetDefendedTown() const; //returns defended town if current battle is a siege, nullptr instead
 	const CStack *battleActiveStack() const;
 	si8 battleTacticDist() const; //returns tactic distance in current tactics phase; 0 if not in tactics phase
+	ui32 battleGetStateVersion() const; //changes every time battle state is changed, may be used to invalidate cached data
 	si8 battleGetTacticsSide() const; //returns which side is in tactics phase, undefined if none (?)
 	bool battleCanFlee(PlayerColor player) const;
 	bool battleCanSurrender(PlayerColor player) const;
@@ -216,6 +225,32 @@ struct DLL_LINKAGE BattleAttackInfo
 	BattleAttackInfo reverse() const;
 };
 
+/// Parts of damage formula that depend only on attacker, defender and type of attack.
+/// Stack counts, positions, charged fields and luck are applied by CBattleInfoCallback::calculateDmgRange.
+struct DLL_LINKAGE DamageFactors
+{
+	//attacker only
+	double minDmg, maxDmg; //of single creature (including ballista hero bonus) or of whole turret
+	bool multiplyByCount; //false for turrets
+	int attack; //attack skill
+	double attackReduction, defenceReduction; //GENERAL_ATTACK_REDUCTION and ENEMY_DEFENCE_REDUCTION multipliers
+	double skillBonus; //archery or offence
+	double cursePenalty;
+	bool curse, bless;
+	int curseBlessModifier;
+	bool noDistancePenalty;
+	bool meleePenalty; //shooter fighting in melee
+
+	//attacker and defender
+	bool jousting; //jousting bonus and defender not immune
+	double attackDefenceBonus; //additive bonus for attack higher than defence
+	double hateBonus;
+	double multBonus; //defence higher than attack, armorer, damage reduction spells and curse penalty
+	bool airShield; //advanced air shield on defender
+
+	DamageFactors();
+};
+
 class DLL_LINKAGE CBattleInfoCallback : public virtual CBattleInfoEssentials
 {
 public:
@@ -234,15 +269,20 @@ public:
 
 
 	std::vector<BattleHex> battleGetAvailableHexes(const CStack * stack, bool addOccupiable, std::vector<BattleHex> * attackable = nullptr) const; //returns hexes reachable by creature with id ID (valid movement destinations), DOES contain stack current position
+	void battleGetAvailableHexes(BattleHexSet & out, const CStack * stack, bool addOccupiable, BattleHexSet * attackable = nullptr) const; //as above, doesn't allocate
 
 	int battleGetSurrenderCost(PlayerColor Player) const; //returns cost of surrendering battle, -1 if surrendering is not possible
 	ReachabilityInfo::TDistances battleGetDistances(const CStack * stack, BattleHex hex = BattleHex::INVALID, BattleHex * predecessors = nullptr) const; //returns vector of distances to [dest hex number]
 	std::set<BattleHex> battleGetAttackedHexes(const CStack* attacker, BattleHex destinationTile, BattleHex attackerPos = BattleHex::INVALID) const;
+	void battleGetAttackedHexes(BattleHexSet & out, const CStack* attacker, BattleHex destinationTile, BattleHex attackerPos = BattleHex::INVALID) const; //as above, doesn't allocate
 	bool battleCanShoot(const CStack * stack, BattleHex dest) const; //determines if stack with given ID shoot at the selected destination
 	bool battleIsStackBlocked(const CStack * stack) const; //returns true if there is neighboring enemy stack
 	std::set<const CStack*>  batteAdjacentCreatures (const CStack * stack) const;
 	
 	TDmgRange calculateDmgRange(const BattleAttackInfo &info) const; //charge - number of hexes travelled before attack (for champion's jousting); returns pair <min dmg, max dmg>
+	TDmgRange calculateDmgRange(const BattleAttackInfo &info, const DamageFactors &factors) const; //as above, with factors already calculated for the same attacker, defender and attack type
+	void calculateDmgRanges(std::vector<TDmgRange> &out, const BattleAttackInfo &info, const TStacks &defenders) const; //damage of one attacker against many defenders; defender fields of info are replaced by each defender
+	DamageFactors calculateDmgFactors(const BattleAttackInfo &info) const; //parts of damage formula independent of stack counts, positions and luck
 	TDmgRange calculateDmgRange(const CStack* attacker, const CStack* defender, TQuantity attackerCount, bool shooting, ui8 charge, bool lucky, bool unlucky, bool deathBlow, bool ballistaDoubleDmg) const; //charge - number of hexes travelled before attack (for champion's jousting); returns pair <min dmg, max dmg>
 	TDmgRange calculateDmgRange(const CStack* attacker, const CStack* defender, bool shooting, ui8 charge, bool lucky, bool unlucky, bool deathBlow, bool ballistaDoubleDmg) const; //charge - number of hexes travelled before attack (for champion's jousting); returns pair <min dmg, max dmg>
 
@@ -296,21 +336,28 @@ public:
 	si8 battleGetTacticDist() const; //returns tactic distance for calling player or 0 if this player is not in tactic phase (for ALL_KNOWING actual distance for tactic side)
 
 	AttackableTiles getPotentiallyAttackableHexes(const CStack* attacker, BattleHex destinationTile, BattleHex attackerPos) const; //TODO: apply rotation to two-hex attacker
+	void getPotentiallyAttackableHexes(BattleHexSet & hostile, BattleHexSet & friendly, const CStack* attacker, BattleHex destinationTile, BattleHex attackerPos) const; //as above, doesn't allocate
 	std::set<const CStack*> getAttackedCreatures(const CStack* attacker, BattleHex destinationTile, BattleHex attackerPos = BattleHex::INVALID) const; //calculates range of multi-hex attacks
+	void getAttackedCreatures(std::vector<const CStack*> & out, const CStack* attacker, BattleHex destinationTile, BattleHex attackerPos = BattleHex::INVALID) const; //as above, reuses memory of out
 	bool isToReverse(BattleHex hexFrom, BattleHex hexTo, bool curDir /*if true, creature is in attacker's direction*/, bool toDoubleWide, bool toDir) const; //determines if creature should be reversed (it stands on hexFrom and should 'see' hexTo)
 	bool isToReverseHlp(BattleHex hexFrom, BattleHex hexTo, bool curDir) const; //helper for isToReverse
 
 	ReachabilityInfo getReachability(const CStack *stack) const;
 	ReachabilityInfo getReachability(const ReachabilityInfo::Parameters &params) const;
+	ReachabilityInfo getReachability(const AccessibilityInfo &accessibility, const ReachabilityInfo::Parameters &params) const; //for hypothetical battle states, eg. AI simulations
 	AccessibilityInfo getAccesibility() const;
 	AccessibilityInfo getAccesibility(const CStack *stack) const; //Hexes ocupied by stack will be marked as accessible.
 	AccessibilityInfo getAccesibility(const std::vector<BattleHex> &accessibleHexes) const; //given hexes will be marked as accessible
 	std::pair<const CStack *, BattleHex> getNearestStack(const CStack * closest, boost::logic::tribool attackerOwned) const;
+	void calculateStackQueue(std::vector<const CStack *> &out, const int howMany, const int turn, int lastMoved) const; //uncached version of battleGetStackQueue
+	AccessibilityInfo calculateAccesibility() const; //uncached version of getAccesibility, to be used while battle state is being changed
 protected:
-	ReachabilityInfo getFlyingReachability(const ReachabilityInfo::Parameters &params) const;
+	ReachabilityInfo getFlyingReachability(const AccessibilityInfo &accessibility, const ReachabilityInfo::Parameters &params) const;
 	ReachabilityInfo makeBFS(const AccessibilityInfo &accessibility, const ReachabilityInfo::Parameters &params) const;
 	ReachabilityInfo makeBFS(const CStack *stack) const; //uses default parameters -> stack position and owner's perspective
 	std::set<BattleHex> getStoppers(BattlePerspective::BattlePerspective whichSidePerspective) const; //get hexes with stopping obstacles (quicksands)
+	void calculateAttackerDmgFactors(DamageFactors &out, const BattleAttackInfo &info) const;
+	void calculateDefenderDmgFactors(DamageFactors &out, const BattleAttackInfo &info) const; //attacker factors must be already calculated
 
 
 };
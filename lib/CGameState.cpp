@@ -70,6 +70,8 @@ public:
 
 		boost::unique_lock<boost::shared_mutex> lock(*gs->mx);
 		ptr->applyGs(gs);
+		if(gs->curB)
+			gs->curB->stateChanged(); //battle packs don't have common base, any pack may change battle
 	}
 };
 
@@ -1820,7 +1822,7 @@ BFieldType CGameState::battleGetBattlefieldType(int3 tile) const
 
 	const TerrainTile &t = map->getTile(tile);
 	//fight in mine -> subterranean
-	if(dynamic_cast<const CGMine *>(t.visitableObjects.front()))
+	if(dynamic_cast<const CGMine *>(t.visitableObjects().front()))
 		return BFieldType::SUBTERRANEAN;
 
 	for(auto &obj : map->objects)
@@ -1928,7 +1930,7 @@ UpgradeInfo CGameState::getUpgradeInfo(const CStackInstance &stack)
 	}
 
 	//hero is visiting Hill Fort
-	if(h && map->getTile(h->visitablePos()).visitableObjects.front()->ID == Obj::HILL_FORT)
+	if(h && map->getTile(h->visitablePos()).visitableObjects().front()->ID == Obj::HILL_FORT)
 	{
 		static const int costModifiers[] = {0, 25, 50, 75, 100}; //we get cheaper upgrades depending on level
 		const int costModifier = costModifiers[std::min<int>(std::max((int)base->level - 1, 0), ARRAY_COUNT(costModifiers) - 1)];
@@ -1976,7 +1978,7 @@ void CGameState::getNeighbours(const TerrainTile &srct, int3 tile, std::vector<i
 		const TerrainTile &hlpt = map->getTile(hlp);
 
 // 		//we cannot visit things from blocked tiles
-// 		if(srct.blocked && !srct.visitable && hlpt.visitable && srct.blockingObjects.front()->ID != HEROI_TYPE)
+// 		if(srct.blocked && !srct.visitable && hlpt.visitable && srct.blockingObjects().front()->ID != HEROI_TYPE)
 // 		{
 // 			continue;
 // 		}
@@ -2087,7 +2089,7 @@ std::vector<CGObjectInstance*> CGameState::guardingCreatures (int3 pos) const
 	const TerrainTile &posTile = map->getTile(pos);
 	if (posTile.visitable)
 	{
-		for (CGObjectInstance* obj : posTile.visitableObjects)
+		for (CGObjectInstance* obj : posTile.visitableObjects())
 		{
 			if(obj->blockVisit)
 			{
@@ -2106,7 +2108,7 @@ std::vector<CGObjectInstance*> CGameState::guardingCreatures (int3 pos) const
 				const auto & tile = map->getTile(pos);
                 if (tile.visitable && (tile.isWater() == posTile.isWater()))
 				{
-					for (CGObjectInstance* obj : tile.visitableObjects)
+					for (CGObjectInstance* obj : tile.visitableObjects())
 					{
 						if (obj->ID == Obj::MONSTER  &&  checkForVisitableDir(pos, &map->getTile(originalPos), originalPos)) // Monster being able to attack investigated tile
 						{
@@ -2134,7 +2136,7 @@ int3 CGameState::guardingCreaturePosition (int3 pos) const
 	const TerrainTile &posTile = map->getTile(pos);
 	if (posTile.visitable)
 	{
-		for (CGObjectInstance* obj : posTile.visitableObjects)
+		for (CGObjectInstance* obj : posTile.visitableObjects())
 		{
 			if(obj->blockVisit)
 			{
@@ -2157,7 +2159,7 @@ int3 CGameState::guardingCreaturePosition (int3 pos) const
 				const auto & tile = map->getTile(pos);
                 if (tile.visitable && (tile.isWater() == posTile.isWater()))
 				{
-					for (CGObjectInstance* obj : tile.visitableObjects)
+					for (CGObjectInstance* obj : tile.visitableObjects())
 					{
 						if (obj->ID == Obj::MONSTER  &&  checkForVisitableDir(pos, &map->getTile(originalPos), originalPos)) // Monster being able to attack investigated tile
 						{
@@ -2214,12 +2216,12 @@ bool CGameState::checkForVisitableDir(const int3 & src, const int3 & dst) const
 
 bool CGameState::checkForVisitableDir( const int3 & src, const TerrainTile *pom, const int3 & dst ) const
 {
-	for(ui32 b=0; b<pom->visitableObjects.size(); ++b) //checking destination tile
+	for(ui32 b=0; b<pom->visitableObjects().size(); ++b) //checking destination tile
 	{
-		if(!vstd::contains(pom->blockingObjects, pom->visitableObjects[b])) //this visitable object is not blocking, ignore
+		if(!vstd::contains(pom->blockingObjects(), pom->visitableObjects()[b])) //this visitable object is not blocking, ignore
 			continue;
 
-		const CGObjectInstance * obj = pom->visitableObjects[b];
+		const CGObjectInstance * obj = pom->visitableObjects()[b];
 
 		if (!obj->appearance.isVisitableFrom(src.x - dst.x, src.y - dst.y))
 			return false;
@@ -3285,7 +3287,7 @@ void CPathfinder::calculatePaths(int3 src /*= int3(-1,-1,-1)*/, int movement /*=
 		if(subterraneanEntry)
 		{
 			//try finding the exit gate
-			if(const CGObjectInstance *outGate = getObj(CGTeleport::getMatchingGate(ct->visitableObjects.back()->id), false))
+			if(const CGObjectInstance *outGate = getObj(CGTeleport::getMatchingGate(ct->visitableObjects().back()->id), false))
 			{
 				const int3 outPos = outGate->visitablePos();
 				//gs->getNeighbours(*getTile(outPos), outPos, neighbours, boost::logic::indeterminate, !cp->land);
@@ -3395,13 +3397,13 @@ CGPathNode::EAccessibility CPathfinder::evaluateAccessibility(const TerrainTile
 
 	if(tinfo->visitable)
 	{
-		if(tinfo->visitableObjects.front()->ID == Obj::SANCTUARY && tinfo->visitableObjects.back()->ID == Obj::HERO && tinfo->visitableObjects.back()->tempOwner != hero->tempOwner) //non-owned hero stands on Sanctuary
+		if(tinfo->visitableObjects().front()->ID == Obj::SANCTUARY && tinfo->visitableObjects().back()->ID == Obj::HERO && tinfo->visitableObjects().back()->tempOwner != hero->tempOwner) //non-owned hero stands on Sanctuary
 		{
 			return CGPathNode::BLOCKED;
 		}
 		else
 		{
-			for(const CGObjectInstance *obj : tinfo->visitableObjects)
+			for(const CGObjectInstance *obj : tinfo->visitableObjects())
 			{
 				if(obj->passableFor(hero->tempOwner)) //special object instance specific passableness flag - overwrites other accessibility flags
 				{
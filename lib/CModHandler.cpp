@@ -689,12 +689,8 @@ static ui32 calculateModChecksum(const std::string modName, ISimpleResourceLoade
 		modChecksum.process_bytes(reinterpret_cast<const void *>(&configChecksum), sizeof(configChecksum));
 	}
 	// third - add all detected text files from this mod into checksum
-	auto files = filesystem->getFilteredFiles([](const ResourceID & resID)
-	{
-		return resID.getType() == EResType::TEXT &&
-			   ( boost::starts_with(resID.getName(), "DATA") ||
-				 boost::starts_with(resID.getName(), "CONFIG"));
-	});
+	auto files = filesystem->getFilesWithPrefix("DATA", EResType::TEXT);
+	boost::range::copy(filesystem->getFilesWithPrefix("CONFIG", EResType::TEXT), std::inserter(files, files.end()));
 
 	// these two files may change between two runs of vcmi and must be handled separately
 	files.erase(ResourceID("CONFIG/SETTINGS", EResType::TEXT));
@@ -1585,7 +1585,7 @@ CGHeroInstance::ECanDig CGHeroInstance::diggingStatus() const
 		const TerrainTile *t = cb->getTile(getPosition());
 		//TODO look for hole
 		//CGI->mh->getTerrainDescr(h->getPosition(false), hlp, false);
-		if(/*hlp.length() || */t->blockingObjects.size() > 1)
+		if(/*hlp.length() || */t->blockingObjects().size() > 1)
 			return TILE_OCCUPIED;
 		else
 			return CAN_DIG;
@@ -6848,7 +6848,7 @@ int3 IBoatGenerator::bestLocation() const
 	{
 		if (const TerrainTile *tile = IObjectInterface::cb->getTile(o->pos + offset, false)) //tile is in the map
 		{
-            if (tile->terType == ETerrainType::WATER  &&  (!tile->blocked || tile->blockingObjects.front()->ID == 8)) //and is water and is not blocked or is blocked by boat
+            if (tile->terType == ETerrainType::WATER  &&  (!tile->blocked || tile->blockingObjects().front()->ID == 8)) //and is water and is not blocked or is blocked by boat
 				return o->pos + offset;
 		}
 	}
@@ -6861,9 +6861,9 @@ IBoatGenerator::EGeneratorState IBoatGenerator::shipyardStatus() const
 	const TerrainTile *t = IObjectInterface::cb->getTile(tile);
 	if(!t)
 		return TILE_BLOCKED; //no available water
-	else if(!t->blockingObjects.size())
+	else if(!t->blockingObjects().size())
 		return GOOD; //OK
-	else if(t->blockingObjects.front()->ID == Obj::BOAT)
+	else if(t->blockingObjects().front()->ID == Obj::BOAT)
 		return BOAT_ALREADY_BUILT; //blocked with boat
 	else
 		return TILE_BLOCKED; //blocked
@@ -24,6 +24,8 @@ extern template void registerTypes<CSaveFile>(CSaveFile & s);
 extern template void registerTypes<CLoadFile>(CLoadFile & s);
 extern template void registerTypes<CTypeList>(CTypeList & s);
 extern template void registerTypes<CLoadIntegrityValidator>(CLoadIntegrityValidator & s);
+extern template void registerTypes<CMemorySaver>(CMemorySaver & s);
+extern template void registerTypes<CMemoryLoader>(CMemoryLoader & s);
 
 CTypeList typeList;
 
@@ -477,16 +479,12 @@ CSerializer::CSerializer()
 
 void CSerializer::addStdVecItems(CGameState *gs, LibClasses *lib)
 {
+	addLibVecItems(lib);
+
 	registerVectoredType<CGObjectInstance, ObjectInstanceID>(&gs->map->objects, 
 		[](const CGObjectInstance &obj){ return obj.id; });
-	registerVectoredType<CHero, HeroTypeID>(&lib->heroh->heroes, 
-		[](const CHero &h){ return h.ID; });
 	registerVectoredType<CGHeroInstance, HeroTypeID>(&gs->map->allHeroes,
 		[](const CGHeroInstance &h){ return h.type->ID; });
-	registerVectoredType<CCreature, CreatureID>(&lib->creh->creatures, 
-		[](const CCreature &cre){ return cre.idNumber; });
-	registerVectoredType<CArtifact, ArtifactID>(&lib->arth->artifacts,
-		[](const CArtifact &art){ return art.id; });
 	registerVectoredType<CArtifactInstance, ArtifactInstanceID>(&gs->map->artInstances, 
 		[](const CArtifactInstance &artInst){ return artInst.id; });
 	registerVectoredType<CQuest, si32>(&gs->map->quests, 
@@ -495,6 +493,29 @@ void CSerializer::addStdVecItems(CGameState *gs, LibClasses *lib)
 	smartVectorMembersSerialization = true;
 }
 
+void CSerializer::addLibVecItems(LibClasses *lib)
+{
+	registerVectoredType<CHero, HeroTypeID>(&lib->heroh->heroes, 
+		[](const CHero &h){ return h.ID; });
+	registerVectoredType<CCreature, CreatureID>(&lib->creh->creatures, 
+		[](const CCreature &cre){ return cre.idNumber; });
+	registerVectoredType<CArtifact, ArtifactID>(&lib->arth->artifacts,
+		[](const CArtifact &art){ return art.id; });
+
+	smartVectorMembersSerialization = true;
+}
+
+std::vector<CTown *> CSerializer::getTownTypes(LibClasses *lib)
+{
+	std::vector<CTown *> ret;
+	for(auto & faction : lib->townh->factions)
+	{
+		if(faction->town)
+			ret.push_back(faction->town);
+	}
+	return ret;
+}
+
 CLoadIntegrityValidator::CLoadIntegrityValidator( const std::string &primaryFileName, const std::string &controlFileName, int minimalVersion /*= version*/ )
 	: foundDesync(false)
 {
@@ -541,3 +562,37 @@ void CLoadIntegrityValidator::checkMagicBytes( const std::string &text )
 	primaryFile->checkMagicBytes(text);
 	controlFile->checkMagicBytes(text);
 }
+
+CMemorySaver::CMemorySaver()
+{
+	registerTypes(*this);
+}
+
+int CMemorySaver::write(const void * data, unsigned size)
+{
+	auto bytes = static_cast<const ui8 *>(data);
+	buffer.insert(buffer.end(), bytes, bytes + size);
+	return size;
+}
+
+CMemoryLoader::CMemoryLoader(const ui8 * data, si64 size, int dataVersion /*= version*/):
+	buffer(data),
+	bufferSize(size),
+	position(0)
+{
+	if(dataVersion > version)
+		THROW_FORMAT("Error: too new data format (%d)!", dataVersion);
+
+	registerTypes(*this);
+	fileVersion = dataVersion;
+}
+
+int CMemoryLoader::read(const void * data, unsigned size)
+{
+	if(position + size > bufferSize)
+		throw std::runtime_error("Unexpected end of data while reading from memory!");
+
+	std::copy(buffer + position, buffer + position + size, (ui8 *)data);
+	position += size;
+	return size;
+}
@@ -37,6 +37,7 @@ class CGameState;
 class CCreature;
 class LibClasses;
 class CHero;
+class CTown;
 struct CPack;
 extern DLL_LINKAGE LibClasses * VLC;
 namespace mpl = boost::mpl;
@@ -417,6 +418,10 @@ public:
 	}
 
 	void addStdVecItems(CGameState *gs, LibClasses *lib = VLC);
+	/// registers only vectors of handler objects (heroes, creatures, artifacts) that are not part of game state
+	void addLibVecItems(LibClasses *lib = VLC);
+	/// town types are owned by factions and are not stored in any vector, see COSer::addTownTypes
+	static std::vector<CTown *> getTownTypes(LibClasses *lib);
 };
 
 class DLL_LINKAGE CSaverBase : public virtual CSerializer
@@ -574,6 +579,17 @@ public:
 		saving=true;
 		smartPointerSerialization = true;
 	}
+
+	/// registers town types as already saved pointers, so that only their number is written;
+	/// loader has to call CISer::addTownTypes before loading
+	void addTownTypes(LibClasses *lib = VLC)
+	{
+		for(CTown *town : getTownTypes(lib))
+		{
+			const ui32 pid = savedPointers.size();
+			savedPointers[town] = pid;
+		}
+	}
 	~COSer()
 	{
 		std::map<ui16,CBasicPointerSaver*>::iterator iter;
@@ -890,6 +906,16 @@ public:
 		reverseEndianess = false;
 	}
 
+	/// town types saved by COSer::addTownTypes are restored as handler objects
+	void addTownTypes(LibClasses *lib = VLC)
+	{
+		for(CTown *town : getTownTypes(lib))
+		{
+			const ui32 pid = loadedPointers.size();
+			loadedPointers[pid] = town;
+		}
+	}
+
 	~CISer()
 	{
 		std::map<ui16,CBasicPointerLoader*>::iterator iter;
@@ -1322,6 +1348,30 @@ public:
 	unique_ptr<CLoadFile> decay(); //returns primary file. CLoadIntegrityValidator stops being usable anymore
 };
 
+/// Serializer that writes into memory buffer
+class DLL_LINKAGE CMemorySaver
+	: public COSer<CMemorySaver>
+{
+public:
+	std::vector<ui8> buffer;
+
+	CMemorySaver();
+	int write(const void * data, unsigned size);
+};
+
+/// Deserializer that reads from memory buffer. The data buffer won't be free'd. (no ownership)
+class DLL_LINKAGE CMemoryLoader
+	: public CISer<CMemoryLoader>
+{
+	const ui8 * buffer;
+	si64 bufferSize;
+	si64 position;
+
+public:
+	CMemoryLoader(const ui8 * data, si64 size, int dataVersion = version); //throws!
+	int read(const void * data, unsigned size); //throws!
+};
+
 typedef boost::asio::basic_stream_socket < boost::asio::ip::tcp , boost::asio::stream_socket_service<boost::asio::ip::tcp>  > TSocket;
 typedef boost::asio::basic_socket_acceptor<boost::asio::ip::tcp, boost::asio::socket_acceptor_service<boost::asio::ip::tcp> > TAcceptor;
 
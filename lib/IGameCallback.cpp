@@ -460,7 +460,7 @@ std::vector < std::string > CGameInfoCallback::getObjDescriptions(int3 pos) cons
 	ERROR_RET_VAL_IF(!t, "Not a valid tile given!", ret);
 
 
-	for(const CGObjectInstance * obj : t->blockingObjects)
+	for(const CGObjectInstance * obj : t->blockingObjects())
 		ret.push_back(obj->getHoverText());
 	return ret;
 }
@@ -502,7 +502,7 @@ std::vector < const CGObjectInstance * > CGameInfoCallback::getBlockingObjs( int
 	const TerrainTile *t = getTile(pos);
 	ERROR_RET_VAL_IF(!t, "Not a valid tile requested!", ret);
 
-	for(const CGObjectInstance * obj : t->blockingObjects)
+	for(const CGObjectInstance * obj : t->blockingObjects())
 		ret.push_back(obj);
 	return ret;
 }
@@ -513,7 +513,7 @@ std::vector <const CGObjectInstance * > CGameInfoCallback::getVisitableObjs(int3
 	const TerrainTile *t = getTile(pos, verbose);
 	ERROR_VERBOSE_OR_NOT_RET_VAL_IF(!t, verbose, pos << " is not visible!", ret);
 
-	for(const CGObjectInstance * obj : t->visitableObjects)
+	for(const CGObjectInstance * obj : t->visitableObjects())
 	{
 		if(player < nullptr || obj->ID != Obj::EVENT) //hide events from players
 			ret.push_back(obj);
@@ -527,7 +527,7 @@ std::vector < const CGObjectInstance * > CGameInfoCallback::getFlaggableObjects(
 	std::vector<const CGObjectInstance *> ret;
 	const TerrainTile *t = getTile(pos);
 	ERROR_RET_VAL_IF(!t, "Not a valid tile requested!", ret);
-	for(const CGObjectInstance *obj : t->blockingObjects)
+	for(const CGObjectInstance *obj : t->blockingObjects())
 		if(obj->tempOwner != PlayerColor::UNFLAGGABLE)
 			ret.push_back(obj);
 // 	const std::vector < std::pair<const CGObjectInstance*,SDL_Rect> > & objs = CGI->mh->ttiles[pos.x][pos.y][pos.z].objects;
@@ -677,7 +677,7 @@ bool CGameInfoCallback::isOwnedOrVisited(const CGObjectInstance *obj) const
 		return true;
 
 	const TerrainTile *t = getTile(obj->visitablePos()); //get entrance tile
-	const CGObjectInstance *visitor = t->visitableObjects.back(); //visitong hero if present or the obejct itself at last
+	const CGObjectInstance *visitor = t->visitableObjects().back(); //visitong hero if present or the obejct itself at last
 	return visitor->ID == Obj::HERO && canGetFullInfo(visitor); //owned or allied hero is a visitor
 }
 
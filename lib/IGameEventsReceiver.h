@@ -131,6 +131,7 @@ public:
 	virtual void playerBlocked(int reason, bool start){}; //reason: 0 - upcoming battle
 	virtual void gameOver(PlayerColor player, const EVictoryLossCheckResult & victoryLossCheckResult) {}; //player lost or won the game
 	virtual void playerStartsTurn(PlayerColor player){};
+	virtual void packBatchFinished(){}; //called after batch of packs received from server is applied, lets interface redraw once instead of after every pack
 	virtual void showComp(const Component &comp, std::string message) {}; //display component in the advmapint infobox
 
 	//TODO shouldnt be moved down the tree?
@@ -42,9 +42,10 @@ struct SharedMem
 	boost::interprocess::shared_memory_object smo;
 	boost::interprocess::mapped_region *mr;
 	ServerReady *sr;
+	std::string name;
 	
-	SharedMem() //c-tor
-		:smo(boost::interprocess::open_or_create,"vcmi_memory",boost::interprocess::read_write) 
+	SharedMem(const std::string &Name) //c-tor
+		:smo(boost::interprocess::open_or_create,Name.c_str(),boost::interprocess::read_write), name(Name)
 	{
 		smo.truncate(sizeof(ServerReady));
 		mr = new boost::interprocess::mapped_region(smo,boost::interprocess::read_write);
@@ -53,6 +54,12 @@ struct SharedMem
 	~SharedMem() //d-tor
 	{
 		delete mr;
-		boost::interprocess::shared_memory_object::remove("vcmi_memory");
+		boost::interprocess::shared_memory_object::remove(name.c_str());
+	}
+
+	//memory is unique for server port, so that local servers at different ports don't interfere
+	static std::string getName(const std::string &port)
+	{
+		return "vcmi_memory_" + port;
 	}
 };
\ No newline at end of file
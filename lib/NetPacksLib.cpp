@@ -415,8 +415,8 @@ void TryMoveHero::applyGs( CGameState *gs )
 	if(result == EMBARK) //hero enters boat at dest tile
 	{
 		const TerrainTile &tt = gs->map->getTile(CGHeroInstance::convertPosition(end, false));
-		assert(tt.visitableObjects.size() >= 1  &&  tt.visitableObjects.back()->ID == Obj::BOAT); //the only vis obj at dest is Boat
-		CGBoat *boat = static_cast<CGBoat*>(tt.visitableObjects.back());
+		assert(tt.visitableObjects().size() >= 1  &&  tt.visitableObjects().back()->ID == Obj::BOAT); //the only vis obj at dest is Boat
+		CGBoat *boat = static_cast<CGBoat*>(tt.visitableObjects().back());
 
 		gs->map->removeBlockVisTiles(boat); //hero blockvis mask will be used, we don't need to duplicate it with boat
 		h->boat = boat;
@@ -1416,6 +1416,7 @@ DLL_LINKAGE void StacksHealedOrResurrected::applyGs( CGameState *gs )
 		if(resurrected)
 		{
 			changedStack->state.insert(EBattleStackState::ALIVE);
+			gs->curB->stateChanged(); //next resurrected stacks must not be placed on this one
 		}
 		//int missingHPfirst = changedStack->MaxHealth() - changedStack->firstHPleft;
 		int res = std::min( elem.healedHP / changedStack->MaxHealth() , changedStack->baseAmount - changedStack->count );
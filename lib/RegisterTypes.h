@@ -272,5 +272,7 @@ extern template DLL_LINKAGE void registerTypes<CSaveFile>(CSaveFile & s);
 extern template DLL_LINKAGE void registerTypes<CLoadFile>(CLoadFile & s);
 extern template DLL_LINKAGE void registerTypes<CTypeList>(CTypeList & s);
 extern template DLL_LINKAGE void registerTypes<CLoadIntegrityValidator>(CLoadIntegrityValidator & s);
+extern template DLL_LINKAGE void registerTypes<CMemorySaver>(CMemorySaver & s);
+extern template DLL_LINKAGE void registerTypes<CMemoryLoader>(CMemoryLoader & s);
 #endif
 
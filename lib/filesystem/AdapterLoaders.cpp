@@ -57,11 +57,9 @@ CFilesystemList::~CFilesystemList()
 std::unique_ptr<CInputStream> CFilesystemList::load(const ResourceID & resourceName) const
 {
 	// load resource from last loader that have it (last overriden version)
-	for (auto & loader : boost::adaptors::reverse(loaders))
-	{
-		if (loader->existsResource(resourceName))
-			return loader->load(resourceName);
-	}
+	auto it = fileIndex.find(resourceName);
+	if (it != fileIndex.end())
+		return it->second.back()->load(resourceName);
 
 	throw std::runtime_error("Resource with name " + resourceName.getName() + " and type "
 		+ EResTypeHelper::getEResTypeAsString(resourceName.getType()) + " wasn't found.");
@@ -69,10 +67,7 @@ std::unique_ptr<CInputStream> CFilesystemList::load(const ResourceID & resourceN
 
 bool CFilesystemList::existsResource(const ResourceID & resourceName) const
 {
-	for (auto & loader : loaders)
-		if (loader->existsResource(resourceName))
-			return true;
-	return false;
+	return fileIndex.count(resourceName) != 0;
 }
 
 std::string CFilesystemList::getMountPoint() const
@@ -82,8 +77,9 @@ std::string CFilesystemList::getMountPoint() const
 
 boost::optional<std::string> CFilesystemList::getResourceName(const ResourceID & resourceName) const
 {
-	if (existsResource(resourceName))
-		return getResourcesWithName(resourceName).back()->getResourceName(resourceName);
+	auto it = fileIndex.find(resourceName);
+	if (it != fileIndex.end())
+		return it->second.back()->getResourceName(resourceName);
 	return boost::optional<std::string>();
 }
 
@@ -91,10 +87,28 @@ std::unordered_set<ResourceID> CFilesystemList::getFilteredFiles(std::function<b
 {
 	std::unordered_set<ResourceID> ret;
 
-	for (auto & loader : loaders)
-		for (auto & entry : loader->getFilteredFiles(filter))
-			ret.insert(entry);
+	for (auto & entry : fileIndex)
+		if (filter(entry.first))
+			ret.insert(entry.first);
+
+	return ret;
+}
+
+std::unordered_set<ResourceID> CFilesystemList::getFilesWithPrefix(const std::string & prefix, EResType::Type type) const
+{
+	std::unordered_set<ResourceID> ret;
+
+	auto names = sortedNames.find(type);
+	if (names == sortedNames.end())
+		return ret;
 
+	// names are sorted so all matching entries form one continuous range
+	for (auto it = names->second.lower_bound(prefix); it != names->second.end(); it++)
+	{
+		if (!boost::algorithm::starts_with(*it, prefix))
+			break;
+		ret.insert(ResourceID(*it, type));
+	}
 	return ret;
 }
 
@@ -106,6 +120,8 @@ bool CFilesystemList::createResource(std::string filename, bool update)
 		if (writeableLoaders.count(loader.get()) != 0                       // writeable,
 			&& loader->createResource(filename, update))          // successfully created
 		{
+			updateIndex(ResourceID(filename));
+
 			// Check if resource was created successfully. Possible reasons for this to fail
 			// a) loader failed to create resource (e.g. read-only FS)
 			// b) in update mode, call with filename that does not exists
@@ -123,10 +139,30 @@ std::vector<const ISimpleResourceLoader *> CFilesystemList::getResourcesWithName
 {
 	std::vector<const ISimpleResourceLoader *> ret;
 
+	auto it = fileIndex.find(resourceName);
+	if (it != fileIndex.end())
+	{
+		for (auto & loader : it->second)
+			boost::range::copy(loader->getResourcesWithName(resourceName), std::back_inserter(ret));
+	}
+	return ret;
+}
+
+void CFilesystemList::updateIndex(const ResourceID & resourceName)
+{
+	auto & entry = fileIndex[resourceName];
+	entry.clear();
 	for (auto & loader : loaders)
-		boost::range::copy(loader->getResourcesWithName(resourceName), std::back_inserter(ret));
+		if (loader->existsResource(resourceName))
+			entry.push_back(loader.get());
 
-	return ret;
+	if (entry.empty())
+	{
+		fileIndex.erase(resourceName);
+		sortedNames[resourceName.getType()].erase(resourceName.getName());
+	}
+	else
+		sortedNames[resourceName.getType()].insert(resourceName.getName());
 }
 
 void CFilesystemList::addLoader(ISimpleResourceLoader * loader, bool writeable)
@@ -134,4 +170,11 @@ void CFilesystemList::addLoader(ISimpleResourceLoader * loader, bool writeable)
 	loaders.push_back(std::unique_ptr<ISimpleResourceLoader>(loader));
 	if (writeable)
 		writeableLoaders.insert(loader);
+
+	// new loader overrides all existing ones so its files can be simply appended to index
+	for (auto & resID : loader->getFilteredFiles([](const ResourceID &) { return true; }))
+	{
+		fileIndex[resID].push_back(loader);
+		sortedNames[resID.getType()].insert(resID.getName());
+	}
 }
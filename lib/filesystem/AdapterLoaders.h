@@ -58,6 +58,18 @@ class DLL_LINKAGE CFilesystemList : public ISimpleResourceLoader
 
 	std::set<ISimpleResourceLoader *> writeableLoaders;
 
+	/** Index of all files from all loaders, updated each time new loader is added
+	 * key = ResourceID of file
+	 * value = all loaders that have this file, in order of adding. Last one overrides others
+	*/
+	std::unordered_map<ResourceID, std::vector<const ISimpleResourceLoader *> > fileIndex;
+
+	/** Names of all indexed files sorted by name and grouped by type, used for prefix search */
+	std::map<EResType::Type, std::set<std::string> > sortedNames;
+
+	/// (re)creates index entry for this resource by checking all loaders
+	void updateIndex(const ResourceID & resourceName);
+
 	//FIXME: this is only compile fix, should be removed in the end
 	CFilesystemList(CFilesystemList &) 
     { 
@@ -81,10 +93,12 @@ public:
 	std::unordered_set<ResourceID> getFilteredFiles(std::function<bool(const ResourceID &)> filter) const override;
 	bool createResource(std::string filename, bool update = false) override;
 	std::vector<const ISimpleResourceLoader *> getResourcesWithName(const ResourceID & resourceName) const override;
+	std::unordered_set<ResourceID> getFilesWithPrefix(const std::string & prefix, EResType::Type type) const override;
 
 	/**
 	 * Adds a resource loader to the loaders list
 	 * Passes loader ownership to this object
+	 * Loader must not receive new files after this call except via createResource()
 	 *
 	 * @param loader The simple resource loader object to add
 	 * @param writeable - resource shall be treated as writeable
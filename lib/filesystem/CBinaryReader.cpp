@@ -1,47 +1,86 @@
 #include "StdInc.h"
 #include "CBinaryReader.h"
 
-#include <SDL_endian.h>
 #include "CInputStream.h"
 #include "../CGeneralTextHandler.h"
 
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-template <typename CData>
-CData readLE(CData data)
+CBinaryReader::CBinaryReader() : stream(nullptr), buffer(nullptr), bufferSize(0), bufferPosition(0)
 {
-	auto dataPtr = (char*)&data;
-	std::reverse(dataPtr, dataPtr + sizeof(data));
-	return data;
 }
-#else
-template <typename CData>
-CData readLE(CData data)
+
+CBinaryReader::CBinaryReader(CInputStream * stream) : stream(stream), buffer(nullptr), bufferSize(0), bufferPosition(0)
 {
-	return data;
 }
-#endif
 
-CBinaryReader::CBinaryReader() : stream(nullptr)
+CInputStream * CBinaryReader::getStream()
 {
+	return stream;
 }
 
-CBinaryReader::CBinaryReader(CInputStream * stream) : stream(stream)
+void CBinaryReader::setStream(CInputStream * stream)
 {
+	this->stream = stream;
+	buffer = nullptr;
+	bufferSize = 0;
+	bufferPosition = 0;
+	streamBuffer.clear();
 }
 
-CInputStream * CBinaryReader::getStream()
+void CBinaryReader::setBuffer(const ui8 * data, si64 size)
 {
-	return stream;
+	stream = nullptr;
+	buffer = data;
+	bufferSize = size;
+	bufferPosition = 0;
+	streamBuffer.clear();
 }
 
-void CBinaryReader::setStream(CInputStream * stream)
+void CBinaryReader::setBufferedStream(CInputStream * stream)
 {
+	static const size_t CHUNK_SIZE = 64 * 1024;
+
 	this->stream = stream;
+	streamBuffer.resize(CHUNK_SIZE);
+	buffer = streamBuffer.data();
+	bufferSize = 0;
+	bufferPosition = 0;
+}
+
+si64 CBinaryReader::readBuffered(ui8 * data, si64 size)
+{
+	si64 bytesRead = 0;
+	while (bytesRead < size)
+	{
+		if (bufferPosition == bufferSize)
+		{
+			bufferSize = stream->read(streamBuffer.data(), streamBuffer.size());
+			bufferPosition = 0;
+			if (bufferSize == 0)
+				break;
+		}
+
+		si64 count = std::min(size - bytesRead, bufferSize - bufferPosition);
+		std::copy(buffer + bufferPosition, buffer + bufferPosition + count, data + bytesRead);
+		bufferPosition += count;
+		bytesRead += count;
+	}
+	return bytesRead;
 }
 
 si64 CBinaryReader::read(ui8 * data, si64 size)
 {
-	si64 bytesRead = stream->read(data, size);
+	si64 bytesRead;
+	if (!streamBuffer.empty())
+		bytesRead = readBuffered(data, size);
+	else if (buffer)
+	{
+		bytesRead = std::min(size, bufferSize - bufferPosition);
+		std::copy(buffer + bufferPosition, buffer + bufferPosition + bytesRead, data);
+		bufferPosition += bytesRead;
+	}
+	else
+		bytesRead = stream->read(data, size);
+
 	if(bytesRead != size)
 	{
 		throw std::runtime_error(getEndOfStreamExceptionMsg(size));
@@ -49,33 +88,19 @@ si64 CBinaryReader::read(ui8 * data, si64 size)
 	return bytesRead;
 }
 
-template <typename CData>
-CData CBinaryReader::readInteger()
+void CBinaryReader::readRaw(ui8 * data, si64 size)
 {
-	CData val;
-	stream->read(reinterpret_cast<unsigned char *>(&val), sizeof(val));
-	return readLE(val);
+	if (!streamBuffer.empty())
+	{
+		if (readBuffered(data, size) != size)
+			throw std::runtime_error(getEndOfStreamExceptionMsg(size));
+	}
+	else if (buffer)
+		throw std::runtime_error(getEndOfStreamExceptionMsg(size));
+	else
+		stream->read(data, size);
 }
 
-//FIXME: any way to do this without macro?
-#define INSTANTIATE(datatype, methodname) \
-datatype CBinaryReader::methodname() \
-{ return readInteger<datatype>(); }
-
-// While it is certanly possible to leave only template method
-// but typing template parameter every time can be annoying
-// and templates parameters can't be resolved by return type
-INSTANTIATE(ui8, readUInt8)
-INSTANTIATE(si8, readInt8)
-INSTANTIATE(ui16, readUInt16)
-INSTANTIATE(si16, readInt16)
-INSTANTIATE(ui32, readUInt32)
-INSTANTIATE(si32, readInt32)
-INSTANTIATE(ui64, readUInt64)
-INSTANTIATE(si64, readInt64)
-
-#undef INSTANTIATE
-
 std::string CBinaryReader::readString()
 {
 	unsigned int len = readUInt32();
@@ -96,14 +121,26 @@ std::string CBinaryReader::readString()
 
 void CBinaryReader::skip(int count)
 {
-	stream->skip(count);
+	if (!streamBuffer.empty())
+	{
+		si64 skipped = std::min<si64>(count, bufferSize - bufferPosition);
+		bufferPosition += skipped;
+		if (skipped < count)
+			stream->skip(count - skipped);
+	}
+	else if (buffer)
+		bufferPosition = std::min(bufferPosition + count, bufferSize);
+	else
+		stream->skip(count);
 }
 
 std::string CBinaryReader::getEndOfStreamExceptionMsg(long bytesToRead) const
 {
 	std::stringstream ss;
-	ss << "The end of the stream was reached unexpectedly. The stream has a length of " << stream->getSize() << " and the current reading position is "
-				<< stream->tell() << ". The client wanted to read " << bytesToRead << " bytes.";
+	const bool memoryOnly = buffer && streamBuffer.empty();
+	ss << "The end of the stream was reached unexpectedly. The stream has a length of " << (memoryOnly ? bufferSize : stream->getSize())
+				<< " and the current reading position is " << (memoryOnly ? bufferPosition : stream->tell() - (bufferSize - bufferPosition))
+				<< ". The client wanted to read " << bytesToRead << " bytes.";
 
 	return ss.str();
 }
@@ -17,6 +17,9 @@ class CInputStream;
  *
  * The integers which are read are supposed to be little-endian values permanently. They will be
  * converted to big-endian values on big-endian machines.
+ *
+ * Reader can also work directly on memory buffer. In this mode integers are read without
+ * any virtual calls which is much faster for large inputs like maps.
  */
 class DLL_LINKAGE CBinaryReader : public boost::noncopyable
 {
@@ -36,7 +39,7 @@ public:
 	/**
 	 * Gets the underlying stream.
 	 *
-	 * @return the base stream.
+	 * @return the base stream, nullptr if reader works on memory buffer
 	 */
 	CInputStream * getStream();
 
@@ -47,6 +50,23 @@ public:
 	 */
     void setStream(CInputStream * stream);
 
+	/**
+	 * Sets memory buffer to read from instead of stream. The data buffer won't be free'd. (no ownership)
+	 *
+	 * @param data A pointer to the data array.
+	 * @param size The size in bytes of the array.
+	 */
+	void setBuffer(const ui8 * data, si64 size);
+
+	/**
+	 * Sets the underlying stream which is read in large chunks into internal buffer. Integers are then
+	 * read from this buffer, without virtual call for each of them.
+	 * Position of the stream is ahead of reader, so the stream should not be used directly meanwhile.
+	 *
+	 * @param stream The base stream to set
+	 */
+	void setBufferedStream(CInputStream * stream);
+
 	/**
 	 * Reads n bytes from the stream into the data buffer.
 	 *
@@ -61,16 +81,16 @@ public:
 	 *
 	 * @return a read integer.
 	 *
-	 * @throws std::runtime_error if the end of the stream was reached unexpectedly
+	 * @throws std::runtime_error if the end of the memory buffer was reached unexpectedly
 	 */
-	ui8 readUInt8();
-	si8 readInt8();
-	ui16 readUInt16();
-	si16 readInt16();
-	ui32 readUInt32();
-	si32 readInt32();
-	ui64 readUInt64();
-	si64 readInt64();
+	inline ui8 readUInt8()   { return readInteger<ui8>(); }
+	inline si8 readInt8()    { return readInteger<si8>(); }
+	inline ui16 readUInt16() { return readInteger<ui16>(); }
+	inline si16 readInt16()  { return readInteger<si16>(); }
+	inline ui32 readUInt32() { return readInteger<ui32>(); }
+	inline si32 readInt32()  { return readInteger<si32>(); }
+	inline ui64 readUInt64() { return readInteger<ui64>(); }
+	inline si64 readInt64()  { return readInteger<si64>(); }
 
 	std::string readString();
 
@@ -85,11 +105,43 @@ private:
      * Reads any integer. Advances the read pointer by its size.
      *
      * @return read integer.
-     *
-     * @throws std::runtime_error if the end of the stream was reached unexpectedly
      */
     template <typename CData>
-    CData readInteger();
+    CData readInteger()
+	{
+		typedef typename std::make_unsigned<CData>::type TUnsigned;
+
+		ui8 streamData[sizeof(CData)];
+		const ui8 * data = buffer + bufferPosition;
+
+		if (buffer && bufferPosition + si64(sizeof(CData)) <= bufferSize)
+			bufferPosition += sizeof(CData);
+		else
+		{
+			readRaw(streamData, sizeof(CData));
+			data = streamData;
+		}
+
+		// little-endian on any platform, compilers reduce this to single load where possible
+		TUnsigned value = 0;
+		for (size_t i = 0; i < sizeof(CData); i++)
+			value |= TUnsigned(data[i]) << (8 * i);
+		return CData(value);
+	}
+
+	/**
+	 * Reads raw bytes for integer, slow path used with streams
+	 *
+	 * @throws std::runtime_error if the end of the memory buffer was reached
+	 */
+	void readRaw(ui8 * data, si64 size);
+
+	/**
+	 * Copies bytes from internal buffer of buffered stream, refilling it as needed
+	 *
+	 * @return the number of bytes read actually.
+	 */
+	si64 readBuffered(ui8 * data, si64 size);
 
 	/**
 	 * Gets a end of stream exception message.
@@ -101,4 +153,16 @@ private:
 
 	/** The underlying base stream */
 	CInputStream * stream;
+
+	/** Memory buffer used instead of stream, if set */
+	const ui8 * buffer;
+
+	/** The size in bytes of memory buffer. */
+	si64 bufferSize;
+
+	/** Current reading position in memory buffer. */
+	si64 bufferPosition;
+
+	/** Internal buffer used with buffered stream, empty otherwise */
+	std::vector<ui8> streamBuffer;
 };
@@ -10,8 +10,9 @@
  *
  */
 
+#include "ResourceID.h"
+
 class CInputStream;
-class ResourceID;
 
 /**
  * A class which knows the files containing in the archive or system and how to load them.
@@ -61,6 +62,21 @@ public:
 	 */
 	virtual std::unordered_set<ResourceID> getFilteredFiles(std::function<bool(const ResourceID &)> filter) const = 0;
 
+	/**
+	 * Get list of files of specified type with names starting with prefix, e.g. all maps in directory
+	 *
+	 * @param prefix Name prefix in upper case, e.g. "MAPS/"
+	 * @param type Type of files to look for
+	 * @return Returns list of files
+	 */
+	virtual std::unordered_set<ResourceID> getFilesWithPrefix(const std::string & prefix, EResType::Type type) const
+	{
+		return getFilteredFiles([&](const ResourceID & resID)
+		{
+			return resID.getType() == type && boost::algorithm::starts_with(resID.getName(), prefix);
+		});
+	}
+
 	/**
 	 * Creates new resource with specified filename.
 	 *
@@ -94,6 +94,7 @@ EResType::Type EResTypeHelper::getTypeFromExtension(std::string extension)
 			(".MSG",   EResType::MASK)
 			(".H3C",   EResType::CAMPAIGN)
 			(".H3M",   EResType::MAP)
+			(".VMAP",  EResType::MAP)
 			(".FNT",   EResType::BMP_FONT)
 			(".TTF",   EResType::TTF_FONT)
 			(".BMP",   EResType::IMAGE)
@@ -96,9 +96,11 @@ CCastleEvent::CCastleEvent() : town(nullptr)
 
 }
 
+const std::vector<CGObjectInstance *> TerrainTile::noObjects;
+
 TerrainTile::TerrainTile() : terType(ETerrainType::BORDER), terView(0), riverType(ERiverType::NO_RIVER),
 	riverDir(0), roadType(ERoadType::NO_ROAD), roadDir(0), extTileFlags(0), visitable(false),
-	blocked(false)
+	blocked(false), objects(nullptr)
 {
 
 }
@@ -121,7 +123,7 @@ bool TerrainTile::isClear(const TerrainTile *from /*= nullptr*/) const
 
 int TerrainTile::topVisitableId() const
 {
-	return visitableObjects.size() ? visitableObjects.back()->ID : -1;
+	return visitableObjects().size() ? visitableObjects().back()->ID : -1;
 }
 
 bool TerrainTile::isCoastal() const
@@ -201,16 +203,7 @@ CMap::CMap() : checksum(0), grailPos(-1, -1, -1), grailRadious(0), terrain(nullp
 
 CMap::~CMap()
 {
-	if(terrain)
-	{
-		for(int ii=0;ii<width;ii++)
-		{
-			for(int jj=0;jj<height;jj++)
-				delete [] terrain[ii][jj];
-			delete [] terrain[ii];
-		}
-		delete [] terrain;
-	}
+	delete [] terrain;
 }
 
 void CMap::removeBlockVisTiles(CGObjectInstance * obj, bool total)
@@ -224,16 +217,18 @@ void CMap::removeBlockVisTiles(CGObjectInstance * obj, bool total)
 			int zVal = obj->pos.z;
 			if(xVal>=0 && xVal<width && yVal>=0 && yVal<height)
 			{
-				TerrainTile & curt = terrain[xVal][yVal][zVal];
+				TerrainTile & curt = getTile(int3(xVal, yVal, zVal));
+				if(!curt.objects)
+					continue;
 				if(total || obj->visitableAt(xVal, yVal))
 				{
-					curt.visitableObjects -= obj;
-					curt.visitable = curt.visitableObjects.size();
+					curt.objects->visitable -= obj;
+					curt.visitable = curt.objects->visitable.size();
 				}
 				if(total || obj->blockingAt(xVal, yVal))
 				{
-					curt.blockingObjects -= obj;
-					curt.blocked = curt.blockingObjects.size();
+					curt.objects->blocking -= obj;
+					curt.blocked = curt.objects->blocking.size();
 				}
 			}
 		}
@@ -251,15 +246,15 @@ void CMap::addBlockVisTiles(CGObjectInstance * obj)
 			int zVal = obj->pos.z;
 			if(xVal>=0 && xVal<width && yVal>=0 && yVal<height)
 			{
-				TerrainTile & curt = terrain[xVal][yVal][zVal];
+				TerrainTile & curt = getTile(int3(xVal, yVal, zVal));
 				if( obj->visitableAt(xVal, yVal))
 				{
-					curt.visitableObjects.push_back(obj);
+					getTileObjects(curt).visitable.push_back(obj);
 					curt.visitable = true;
 				}
 				if( obj->blockingAt(xVal, yVal))
 				{
-					curt.blockingObjects.push_back(obj);
+					getTileObjects(curt).blocking.push_back(obj);
 					curt.blocked = true;
 				}
 			}
@@ -288,18 +283,6 @@ bool CMap::isInTheMap(const int3 & pos) const
 	}
 }
 
-TerrainTile & CMap::getTile(const int3 & tile)
-{
-	assert(isInTheMap(tile));
-	return terrain[tile.x][tile.y][tile.z];
-}
-
-const TerrainTile & CMap::getTile(const int3 & tile) const
-{
-	assert(isInTheMap(tile));
-	return terrain[tile.x][tile.y][tile.z];
-}
-
 bool CMap::isWaterTile(const int3 &pos) const
 {
 	return isInTheMap(pos) && getTile(pos).terType == ETerrainType::WATER;
@@ -307,7 +290,7 @@ bool CMap::isWaterTile(const int3 &pos) const
 
 const CGObjectInstance * CMap::getObjectiveObjectFrom(int3 pos, Obj::EObj type)
 {
-	for (CGObjectInstance * object : getTile(pos).visitableObjects)
+	for (CGObjectInstance * object : getTile(pos).visitableObjects())
 	{
 		if (object->ID == type)
 			return object;
@@ -419,15 +402,19 @@ void CMap::addQuest(CGObjectInstance * quest)
 
 void CMap::initTerrain()
 {
-	terrain = new TerrainTile**[width];
-	for(int i = 0; i < width; ++i)
+	delete [] terrain;
+	terrain = new TerrainTile[size_t(width) * height * (twoLevel ? 2 : 1)];
+	tileObjects.clear();
+}
+
+TerrainTileObjects & CMap::getTileObjects(TerrainTile & tile)
+{
+	if(!tile.objects)
 	{
-		terrain[i] = new TerrainTile*[height];
-		for(int j = 0; j < height; ++j)
-		{
-			terrain[i][j] = new TerrainTile[twoLevel ? 2 : 1];
-		}
+		tileObjects.push_back(TerrainTileObjects());
+		tile.objects = &tileObjects.back();
 	}
+	return *tile.objects;
 }
 
 CMapEditManager * CMap::getEditManager()
@@ -259,7 +259,7 @@ public:
 
 namespace ERiverType
 {
-enum ERiverType
+enum ERiverType : ui8
 {
 	NO_RIVER, CLEAR_RIVER, ICY_RIVER, MUDDY_RIVER, LAVA_RIVER
 };
@@ -267,14 +267,22 @@ enum ERiverType
 
 namespace ERoadType
 {
-enum ERoadType
+enum ERoadType : ui8
 {
 	NO_ROAD, DIRT_ROAD, GRAVEL_ROAD, COBBLESTONE_ROAD
 };
 }
 
+/// Objects residing in a terrain tile. Kept by the map in a side table, outside of the terrain array.
+struct DLL_LINKAGE TerrainTileObjects
+{
+	std::vector<CGObjectInstance *> visitable;
+	std::vector<CGObjectInstance *> blocking;
+};
+
 /// The terrain tile describes the terrain type and the visual representation of the terrain.
 /// Furthermore the struct defines whether the tile is visitable or/and blocked and which objects reside in it.
+/// Only small fields are stored in the tile itself, object lists are referenced from the side table of the map.
 struct DLL_LINKAGE TerrainTile
 {
 	TerrainTile();
@@ -289,6 +297,10 @@ struct DLL_LINKAGE TerrainTile
 	bool isWater() const;
 	bool isCoastal() const;
 	bool hasFavourableWinds() const;
+	/// Objects that can be visited on this tile, the top one is last.
+	inline const std::vector<CGObjectInstance *> & visitableObjects() const;
+	/// Objects that block this tile.
+	inline const std::vector<CGObjectInstance *> & blockingObjects() const;
 
 	ETerrainType terType;
 	ui8 terView;
@@ -302,18 +314,31 @@ struct DLL_LINKAGE TerrainTile
 	bool visitable;
 	bool blocked;
 
-	std::vector<CGObjectInstance *> visitableObjects;
-	std::vector<CGObjectInstance *> blockingObjects;
+	/// entry of the map side table, nullptr if no object has been placed on the tile yet; shared by copies of the tile
+	TerrainTileObjects * objects;
 
+	/// object lists are serialized by the map
 	template <typename Handler>
 	void serialize(Handler & h, const int version)
 	{
 		h & terType & terView & riverType & riverDir & roadType &roadDir & extTileFlags;
 		h & visitable & blocked;
-		h & visitableObjects & blockingObjects;
 	}
+
+private:
+	static const std::vector<CGObjectInstance *> noObjects;
 };
 
+inline const std::vector<CGObjectInstance *> & TerrainTile::visitableObjects() const
+{
+	return objects ? objects->visitable : noObjects;
+}
+
+inline const std::vector<CGObjectInstance *> & TerrainTile::blockingObjects() const
+{
+	return objects ? objects->blocking : noObjects;
+}
+
 namespace EMapFormat
 {
 enum EMapFormat
@@ -384,8 +409,8 @@ public:
 	void initTerrain();
 
 	CMapEditManager * getEditManager();
-	TerrainTile & getTile(const int3 & tile);
-	const TerrainTile & getTile(const int3 & tile) const;
+	inline TerrainTile & getTile(const int3 & tile);
+	inline const TerrainTile & getTile(const int3 & tile) const;
 	bool isInTheMap(const int3 & pos) const;
 	bool isWaterTile(const int3 & pos) const;
 
@@ -431,8 +456,16 @@ public:
 	unique_ptr<CMapEditManager> editManager;
 
 private:
-	/// a 3-dimensional array of terrain tiles, access is as follows: x, y, level. where level=1 is underground
-	TerrainTile*** terrain;
+	/// index of tile in terrain array, tiles are stored level by level, row by row
+	inline size_t getTileIndex(const int3 & tile) const;
+
+	/// gets side table entry of a tile, creates it if the tile has none yet
+	TerrainTileObjects & getTileObjects(TerrainTile & tile);
+
+	/// contiguous array of width * height * levels terrain tiles, where level=1 is underground
+	TerrainTile * terrain;
+	/// object lists of tiles, deque keeps addresses stable for the tiles referencing them
+	std::deque<TerrainTileObjects> tileObjects;
 
 public:
 	template <typename Handler>
@@ -444,39 +477,31 @@ public:
 		h & questIdentifierToId;
 
 		//TODO: viccondetails
-		if(h.saving)
+		if(!h.saving)
+			initTerrain();
+
+		// keep x, y, level order of tiles used by older saves
+		for(int i = 0; i < width ; ++i)
 		{
-			// Save terrain
-			for(int i = 0; i < width ; ++i)
+			for(int j = 0; j < height ; ++j)
 			{
-				for(int j = 0; j < height ; ++j)
+				for(int k = 0; k < (twoLevel ? 2 : 1); ++k)
 				{
-					for(int k = 0; k < (twoLevel ? 2 : 1); ++k)
+					TerrainTile & tile = terrain[getTileIndex(int3(i, j, k))];
+					h & tile;
+
+					std::vector<CGObjectInstance *> visitableObjects, blockingObjects;
+					if(h.saving)
 					{
-						h & terrain[i][j][k];
+						visitableObjects = tile.visitableObjects();
+						blockingObjects = tile.blockingObjects();
 					}
-				}
-			}
-		}
-		else
-		{
-			// Load terrain
-			terrain = new TerrainTile**[width];
-			for(int ii = 0; ii < width; ++ii)
-			{
-				terrain[ii] = new TerrainTile*[height];
-				for(int jj = 0; jj < height; ++jj)
-				{
-					terrain[ii][jj] = new TerrainTile[twoLevel ? 2 : 1];
-				}
-			}
-			for(int i = 0; i < width ; ++i)
-			{
-				for(int j = 0; j < height ; ++j)
-				{
-					for(int k = 0; k < (twoLevel ? 2 : 1); ++k)
+					h & visitableObjects & blockingObjects;
+					if(!h.saving && (!visitableObjects.empty() || !blockingObjects.empty()))
 					{
-						h & terrain[i][j][k];
+						TerrainTileObjects & objects = getTileObjects(tile);
+						objects.visitable.swap(visitableObjects);
+						objects.blocking.swap(blockingObjects);
 					}
 				}
 			}
@@ -495,3 +520,20 @@ public:
 		h & CGTownInstance::universitySkills;
 	}
 };
+
+inline size_t CMap::getTileIndex(const int3 & tile) const
+{
+	return (size_t(tile.z) * height + tile.y) * width + tile.x;
+}
+
+inline TerrainTile & CMap::getTile(const int3 & tile)
+{
+	assert(isInTheMap(tile));
+	return terrain[getTileIndex(tile)];
+}
+
+inline const TerrainTile & CMap::getTile(const int3 & tile) const
+{
+	assert(isInTheMap(tile));
+	return terrain[getTileIndex(tile)];
+}
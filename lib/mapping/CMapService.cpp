@@ -9,6 +9,7 @@
 
 #include "MapFormatH3M.h"
 #include "MapFormatJson.h"
+#include "MapFormatBinary.h"
 
 
 std::unique_ptr<CMap> CMapService::loadMap(const std::string & name)
@@ -24,11 +25,21 @@ std::unique_ptr<CMap> CMapService::loadMap(const std::string & name)
 }
 
 std::unique_ptr<CMapHeader> CMapService::loadMapHeader(const std::string & name)
+{
+	std::unique_ptr<CMapHeader> header = loadRawMapHeader(name);
+	patchMapHeader(header, name);
+	return std::move(header);
+}
+
+std::unique_ptr<CMapHeader> CMapService::loadRawMapHeader(const std::string & name)
 {
 	auto stream = getStreamFromFS(name);
-	std::unique_ptr<CMapHeader> header = getMapLoader(stream)->loadMapHeader();
+	return getMapLoader(stream)->loadMapHeader();
+}
+
+void CMapService::patchMapHeader(std::unique_ptr<CMapHeader> & header, const std::string & name)
+{
 	getMapPatcher(name)->patchMapHeader(header);
-	return std::move(header);
 }
 
 std::unique_ptr<CMap> CMapService::loadMap(const ui8 * buffer, int size, const std::string & name)
@@ -51,6 +62,22 @@ std::unique_ptr<CMapHeader> CMapService::loadMapHeader(const ui8 * buffer, int s
 	return std::move(header);
 }
 
+void CMapService::saveMap(CMap & map, const std::string & fullPath)
+{
+	std::ofstream file(fullPath, std::ios::binary);
+	if(!file)
+		throw std::runtime_error("Failed to open " + fullPath + " for writing!");
+
+	CMapSaverBinary(file).saveMap(map);
+}
+
+void CMapService::convertMap(const std::string & name, const std::string & fullPath)
+{
+	auto stream = getStreamFromFS(name);
+	std::unique_ptr<CMap> map(getMapLoader(stream)->loadMap());
+	saveMap(*map, fullPath);
+}
+
 std::unique_ptr<CInputStream> CMapService::getStreamFromFS(const std::string & name)
 {
 	return CResourceHandler::get()->load(ResourceID(name, EResType::MAP));
@@ -76,6 +103,9 @@ std::unique_ptr<IMapLoader> CMapService::getMapLoader(std::unique_ptr<CInputStre
 		case 0x00088B1F:
 			stream = std::unique_ptr<CInputStream>(new CCompressedStream(std::move(stream), true));
 			return std::unique_ptr<IMapLoader>(new CMapLoaderH3M(stream.get()));
+		// "VMA" part of VCMI binary map magic, reversed for LE
+		case CMapLoaderBinary::MAGIC & 0xffffff:
+			return std::unique_ptr<IMapLoader>(new CMapLoaderBinary(stream.get()));
 		case EMapFormat::WOG :
 		case EMapFormat::AB  :
 		case EMapFormat::ROE :
@@ -96,12 +126,17 @@ static JsonNode loadPatches(std::string path)
 
 std::unique_ptr<IMapPatcher> CMapService::getMapPatcher(std::string scenarioName)
 {
+	// may be called from several threads at once, e.g. during map list scanning
 	static JsonNode node;
+	static boost::once_flag patchesLoaded = BOOST_ONCE_INIT;
 
-	if (node.isNull())
+	boost::call_once(patchesLoaded, []()
+	{
 		node = loadPatches("config/mapOverrides.json");
+	});
 
 	boost::to_lower(scenarioName);
 	logGlobal->debugStream() << "Request to patch map " << scenarioName;
-	return std::unique_ptr<IMapPatcher>(new CMapLoaderJson(node[scenarioName]));
+	const JsonNode & patches = node;
+	return std::unique_ptr<IMapPatcher>(new CMapLoaderJson(patches[scenarioName]));
 }
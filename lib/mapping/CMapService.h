@@ -41,6 +41,23 @@ public:
 	 */
 	static std::unique_ptr<CMapHeader> loadMapHeader(const std::string & name);
 
+	/**
+	 * Loads the VCMI/H3 map header specified by the name, without applying map overrides.
+	 * Unlike patched headers, such header may be cached on disk - see patchMapHeader.
+	 *
+	 * @param name the name of the map
+	 * @return a unique ptr to the loaded map header class
+	 */
+	static std::unique_ptr<CMapHeader> loadRawMapHeader(const std::string & name);
+
+	/**
+	 * Applies overrides from config/mapOverrides.json to map header.
+	 *
+	 * @param header the header loaded by loadRawMapHeader
+	 * @param name the name of the map
+	 */
+	static void patchMapHeader(std::unique_ptr<CMapHeader> & header, const std::string & name);
+
 	/**
 	 * Loads the VCMI/H3 map file from a buffer. This method is temporarily
 	 * in use to ease the transition to use the new map service.
@@ -69,6 +86,23 @@ public:
 	 */
 	static std::unique_ptr<CMapHeader> loadMapHeader(const ui8 * buffer, int size, const std::string & name);
 
+	/**
+	 * Saves the map in VCMI binary map format.
+	 *
+	 * @param map the map to save
+	 * @param fullPath path to file in filesystem
+	 */
+	static void saveMap(CMap & map, const std::string & fullPath);
+
+	/**
+	 * Converts map of any supported format into VCMI binary map format.
+	 * Map header patches are not applied to saved map.
+	 *
+	 * @param name the name of the map to convert
+	 * @param fullPath path to resulting file in filesystem
+	 */
+	static void convertMap(const std::string & name, const std::string & fullPath);
+
 private:
 	/**
 	 * Gets a map input stream object specified by a map name.
@@ -0,0 +1,264 @@
+/*
+ * MapFormatBinary.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "MapFormatBinary.h"
+
+#include <boost/crc.hpp>
+
+#include "../filesystem/CInputStream.h"
+#include "../filesystem/CMemoryStream.h"
+#include "../Connection.h"
+#include "../ScopeGuard.h"
+#include "../CArtHandler.h"
+#include "../CCreatureHandler.h"
+#include "../CHeroHandler.h"
+#include "../CObjectHandler.h"
+#include "../CTownHandler.h"
+#include "../VCMI_Lib.h"
+#include "CMap.h"
+
+const size_t CMapLoaderBinary::TILE_SIZE = 7;
+
+CMapLoaderBinary::CMapLoaderBinary(CInputStream * stream):
+	inputStream(stream),
+	reader(stream),
+	dataVersion(0)
+{
+}
+
+std::unique_ptr<CMap> CMapLoaderBinary::loadMap()
+{
+	// all sections are needed - read whole file at once and load them from memory
+	auto data = inputStream->readAll();
+	CMemoryStream memoryStream(data.first.get(), data.second);
+
+	CInputStream * originalStream = inputStream;
+	auto restoreStream = vstd::makeScopeGuard([&]()
+	{
+		inputStream = originalStream;
+		reader.setStream(originalStream);
+	});
+	inputStream = &memoryStream;
+	reader.setStream(&memoryStream);
+
+	auto map = make_unique<CMap>();
+
+	boost::crc_32_type checksum;
+	checksum.process_bytes(data.first.get(), data.second);
+	map->checksum = checksum.checksum();
+
+	readSectionTable();
+	readHeader(*map);
+	loadTerrain(map.get());
+	readObjects(*map);
+	readEvents(*map);
+
+	// Calculate blocked / visitable positions
+	for(auto & elem : map->objects)
+	{
+		if(elem)
+			map->addBlockVisTiles(elem);
+	}
+
+	return std::move(map);
+}
+
+std::unique_ptr<CMapHeader> CMapLoaderBinary::loadMapHeader()
+{
+	auto header = make_unique<CMapHeader>();
+	readSectionTable();
+	readHeader(*header);
+	return std::move(header);
+}
+
+void CMapLoaderBinary::loadTerrain(CMap * map)
+{
+	readSectionTable();
+	auto data = readSection(EMapSection::TERRAIN);
+
+	const int levels = map->twoLevel ? 2 : 1;
+	if(data.size() != size_t(map->width) * map->height * levels * TILE_SIZE)
+		throw std::runtime_error("Terrain section size does not match map size!");
+
+	map->initTerrain();
+
+	const ui8 * tileData = data.data();
+	for(int z = 0; z < levels; z++)
+	{
+		for(int y = 0; y < map->height; y++)
+		{
+			for(int x = 0; x < map->width; x++)
+			{
+				TerrainTile & tile = map->getTile(int3(x, y, z));
+				tile.terType = ETerrainType(tileData[0]);
+				tile.terView = tileData[1];
+				tile.riverType = static_cast<ERiverType::ERiverType>(tileData[2]);
+				tile.riverDir = tileData[3];
+				tile.roadType = static_cast<ERoadType::ERoadType>(tileData[4]);
+				tile.roadDir = tileData[5];
+				tile.extTileFlags = tileData[6];
+				tileData += TILE_SIZE;
+			}
+		}
+	}
+}
+
+void CMapLoaderBinary::readSectionTable()
+{
+	if(!sections.empty())
+		return;
+
+	inputStream->seek(0);
+	if(reader.readUInt32() != MAGIC)
+		throw std::runtime_error("Not a VCMI binary map!");
+
+	dataVersion = reader.readUInt32();
+	ui32 sectionsCount = reader.readUInt32();
+	for(ui32 i = 0; i < sectionsCount; i++)
+	{
+		auto id = static_cast<EMapSection::EMapSection>(reader.readUInt32());
+		SectionInfo & info = sections[id];
+		info.offset = reader.readUInt32();
+		info.size = reader.readUInt32();
+	}
+}
+
+std::vector<ui8> CMapLoaderBinary::readSection(EMapSection::EMapSection section)
+{
+	auto it = sections.find(section);
+	if(it == sections.end())
+		throw std::runtime_error("Map section " + boost::lexical_cast<std::string>(int(section)) + " is missing!");
+
+	std::vector<ui8> data(it->second.size);
+	inputStream->seek(it->second.offset);
+	reader.read(data.data(), data.size());
+	return data;
+}
+
+void CMapLoaderBinary::readHeader(CMapHeader & header)
+{
+	auto data = readSection(EMapSection::HEADER);
+	CMemoryLoader loader(data.data(), data.size(), dataVersion);
+	loader >> header;
+}
+
+void CMapLoaderBinary::readObjects(CMap & map)
+{
+	auto data = readSection(EMapSection::OBJECTS);
+	CMemoryLoader loader(data.data(), data.size(), dataVersion);
+	loader.addLibVecItems();
+	loader.addTownTypes();
+
+	loader >> map.allowedSpell >> map.allowedAbilities >> map.allowedArtifact;
+	loader >> map.grailPos >> map.grailRadious;
+	loader >> map.objects >> map.heroesOnMap >> map.towns >> map.artInstances >> map.quests;
+	loader >> map.allHeroes >> map.predefinedHeroes >> map.questIdentifierToId;
+}
+
+void CMapLoaderBinary::readEvents(CMap & map)
+{
+	auto data = readSection(EMapSection::EVENTS);
+	CMemoryLoader loader(data.data(), data.size(), dataVersion);
+
+	loader >> map.events >> map.rumors >> map.disposedHeroes;
+}
+
+CMapSaverBinary::CMapSaverBinary(std::ostream & stream):
+	stream(stream)
+{
+}
+
+void CMapSaverBinary::saveMap(CMap & map)
+{
+	std::vector<std::pair<EMapSection::EMapSection, std::vector<ui8> > > sections;
+	sections.push_back(std::make_pair(EMapSection::HEADER, writeHeader(map)));
+	sections.push_back(std::make_pair(EMapSection::TERRAIN, writeTerrain(map)));
+	sections.push_back(std::make_pair(EMapSection::OBJECTS, writeObjects(map)));
+	sections.push_back(std::make_pair(EMapSection::EVENTS, writeEvents(map)));
+
+	writeUInt32(CMapLoaderBinary::MAGIC);
+	writeUInt32(version);
+	writeUInt32(sections.size());
+
+	// magic, version, sections count and 3 values per section
+	ui32 offset = sizeof(ui32) * (3 + 3 * sections.size());
+	for(auto & section : sections)
+	{
+		writeUInt32(section.first);
+		writeUInt32(offset);
+		writeUInt32(section.second.size());
+		offset += section.second.size();
+	}
+
+	for(auto & section : sections)
+		stream.write(reinterpret_cast<const char *>(section.second.data()), section.second.size());
+}
+
+std::vector<ui8> CMapSaverBinary::writeHeader(CMap & map)
+{
+	CMemorySaver saver;
+	saver << static_cast<CMapHeader &>(map);
+	return std::move(saver.buffer);
+}
+
+std::vector<ui8> CMapSaverBinary::writeTerrain(const CMap & map)
+{
+	const int levels = map.twoLevel ? 2 : 1;
+	std::vector<ui8> data;
+	data.reserve(size_t(map.width) * map.height * levels * CMapLoaderBinary::TILE_SIZE);
+
+	for(int z = 0; z < levels; z++)
+	{
+		for(int y = 0; y < map.height; y++)
+		{
+			for(int x = 0; x < map.width; x++)
+			{
+				const TerrainTile & tile = map.getTile(int3(x, y, z));
+				data.push_back(tile.terType.num);
+				data.push_back(tile.terView);
+				data.push_back(tile.riverType);
+				data.push_back(tile.riverDir);
+				data.push_back(tile.roadType);
+				data.push_back(tile.roadDir);
+				data.push_back(tile.extTileFlags);
+			}
+		}
+	}
+	return data;
+}
+
+std::vector<ui8> CMapSaverBinary::writeObjects(CMap & map)
+{
+	CMemorySaver saver;
+	saver.addLibVecItems();
+	saver.addTownTypes();
+
+	saver << map.allowedSpell << map.allowedAbilities << map.allowedArtifact;
+	saver << map.grailPos << map.grailRadious;
+	saver << map.objects << map.heroesOnMap << map.towns << map.artInstances << map.quests;
+	saver << map.allHeroes << map.predefinedHeroes << map.questIdentifierToId;
+	return std::move(saver.buffer);
+}
+
+std::vector<ui8> CMapSaverBinary::writeEvents(CMap & map)
+{
+	CMemorySaver saver;
+	saver << map.events << map.rumors << map.disposedHeroes;
+	return std::move(saver.buffer);
+}
+
+void CMapSaverBinary::writeUInt32(ui32 value)
+{
+	ui8 data[4];
+	for(int i = 0; i < 4; i++)
+		data[i] = (value >> (8 * i)) & 0xff;
+	stream.write(reinterpret_cast<const char *>(data), sizeof(data));
+}
@@ -0,0 +1,136 @@
+/*
+ * MapFormatBinary.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#pragma once
+
+#include "CMapService.h"
+
+#include "../filesystem/CBinaryReader.h"
+
+class CInputStream;
+
+/**
+ * Sections of VCMI binary map. Each of them can be loaded separately.
+ *
+ * File layout:
+ * "VMAP" magic, ui32 data format version, ui32 number of sections,
+ * then for each section ui32 ID, ui32 offset from start of file and ui32 size,
+ * followed by sections data. All values are little-endian.
+ */
+namespace EMapSection
+{
+enum EMapSection
+{
+	HEADER = 1,  /// CMapHeader, written by serializer
+	TERRAIN = 2, /// contiguous array of tiles, level by level, row by row
+	OBJECTS = 3, /// objects, heroes, towns, artifacts, quests and allowed spells/artifacts/skills
+	EVENTS = 4   /// map events, rumors and disposed heroes
+};
+}
+
+class DLL_LINKAGE CMapLoaderBinary : public IMapLoader
+{
+public:
+	/** Magic number of format, "VMAP" reversed for LE */
+	static const ui32 MAGIC = 0x50414D56;
+
+	/** Number of bytes used for one tile in terrain section */
+	static const size_t TILE_SIZE;
+
+	/**
+	 * Default constructor.
+	 *
+	 * @param stream a stream containing the map data
+	 */
+	CMapLoaderBinary(CInputStream * stream);
+
+	/**
+	 * Loads the VCMI binary map file.
+	 *
+	 * @return a unique ptr of the loaded map class
+	 */
+	std::unique_ptr<CMap> loadMap() override;
+
+	/**
+	 * Loads the VCMI binary map header. Only header section is read from stream.
+	 *
+	 * @return a unique ptr of the loaded map header class
+	 */
+	std::unique_ptr<CMapHeader> loadMapHeader() override;
+
+	/**
+	 * Loads terrain section into map. Map header (size and levels) must be already loaded.
+	 * Can be used to get terrain without objects, e.g. for map previews.
+	 *
+	 * @param map map to load terrain into
+	 */
+	void loadTerrain(CMap * map);
+
+private:
+	struct SectionInfo
+	{
+		ui32 offset;
+		ui32 size;
+	};
+
+	/**
+	 * Reads table of sections, if not done yet.
+	 */
+	void readSectionTable();
+
+	/**
+	 * Reads raw data of section.
+	 *
+	 * @throws std::runtime_error if section is missing
+	 */
+	std::vector<ui8> readSection(EMapSection::EMapSection section);
+
+	void readHeader(CMapHeader & header);
+	void readObjects(CMap & map);
+	void readEvents(CMap & map);
+
+	/** ptr to the map stream object, can't be null */
+	CInputStream * inputStream;
+
+	CBinaryReader reader;
+
+	/** version of serializer used to write this map */
+	ui32 dataVersion;
+
+	std::map<EMapSection::EMapSection, SectionInfo> sections;
+};
+
+class DLL_LINKAGE CMapSaverBinary
+{
+public:
+	/**
+	 * Default constructor.
+	 *
+	 * @param stream binary stream to write map into
+	 */
+	CMapSaverBinary(std::ostream & stream);
+
+	/**
+	 * Writes the map in VCMI binary format.
+	 *
+	 * @param map map to save, not modified
+	 */
+	void saveMap(CMap & map);
+
+private:
+	std::vector<ui8> writeHeader(CMap & map);
+	std::vector<ui8> writeTerrain(const CMap & map);
+	std::vector<ui8> writeObjects(CMap & map);
+	std::vector<ui8> writeEvents(CMap & map);
+
+	void writeUInt32(ui32 value);
+
+	std::ostream & stream;
+};
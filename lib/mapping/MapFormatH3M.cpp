@@ -14,6 +14,7 @@
 #include <boost/crc.hpp>
 
 #include "../CStopWatch.h"
+#include "../ScopeGuard.h"
 
 #include "../filesystem/Filesystem.h"
 #include "CMap.h"
@@ -50,7 +51,13 @@ std::unique_ptr<CMap> CMapLoaderH3M::loadMap()
 
 std::unique_ptr<CMapHeader> CMapLoaderH3M::loadMapHeader()
 {
-	// Read header
+	// Read header. Only small part of the map is needed, so it is read in chunks instead of decompressing whole map
+	reader.setBufferedStream(inputStream);
+	auto releaseBuffer = vstd::makeScopeGuard([&]()
+	{
+		reader.setStream(inputStream);
+	});
+
 	mapHeader = make_unique<CMapHeader>();
 	readHeader();
 
@@ -59,20 +66,19 @@ std::unique_ptr<CMapHeader> CMapLoaderH3M::loadMapHeader()
 
 void CMapLoaderH3M::init()
 {
-	//FIXME: get rid of double input process
-	si64 temp_size = inputStream->getSize();
-	inputStream->seek(0);
-
-	auto  temp_buffer = new ui8[temp_size];
-	inputStream->read(temp_buffer,temp_size);
+	// Map is decompressed only once, both checksum and parsing use this buffer
+	auto data = inputStream->readAll();
 
 	// Compute checksum
 	boost::crc_32_type  result;
-	result.process_bytes(temp_buffer, temp_size);
+	result.process_bytes(data.first.get(), data.second);
 	map->checksum = result.checksum();
 
-	delete [] temp_buffer;
-	inputStream->seek(0);
+	reader.setBuffer(data.first.get(), data.second);
+	auto releaseBuffer = vstd::makeScopeGuard([&]()
+	{
+		reader.setStream(inputStream);
+	});
 
 	CStopWatch sw;
 
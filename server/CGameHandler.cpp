@@ -23,9 +23,11 @@
 #include "../lib/mapping/CMap.h"
 #include "../lib/VCMIDirs.h"
 #include "../lib/ScopeGuard.h"
+#include "../lib/UnlockGuard.h"
 #include "../client/CSoundBase.h"
 #include "CGameHandler.h"
 #include "CVCMIServer.h"
+#include "../lib/BattleReplay.h"
 #include "../lib/CCreatureSet.h"
 #include "../lib/CThreadHelper.h"
 #include "../lib/GameConstants.h"
@@ -917,11 +919,15 @@ void CGameHandler::handleConnection(std::set<PlayerColor> players, CConnection &
 	{
 		assert(!c.connected); //make sure that connection has been marked as broken
         logGlobal->errorStream() << e.what();
-		end2 = true;
+		endGame();
 	}
-	HANDLE_EXCEPTION(end2 = true);
+	HANDLE_EXCEPTION(endGame());
 
     logGlobal->errorStream() << "Ended handling connection";
+
+	//wake up run() waiting for client to close socket
+	boost::unique_lock<boost::mutex> lock(states.mx);
+	states.cv.notify_all();
 }
 
 int CGameHandler::moveStack(int stack, BattleHex dest)
@@ -1056,10 +1062,17 @@ CGameHandler::CGameHandler(void)
 	registerTypes3(*applier);
 	visitObjectAfterVictory = false;
 	queries.gh = this;
+	battleReplay = nullptr;
 }
 
 CGameHandler::~CGameHandler(void)
 {
+	//connection threads use game handler until their connection is closed
+	for(auto thread : connectionThreads)
+	{
+		thread->join();
+		delete thread;
+	}
 	delete applier;
 	applier = nullptr;
 	delete gs;
@@ -1477,18 +1490,14 @@ void CGameHandler::run(bool resume)
 			if(j->second == elem)
 				pom.insert(j->first);
 
-		boost::thread(boost::bind(&CGameHandler::handleConnection,this,pom,boost::ref(*elem)));
+		connectionThreads.push_back(new boost::thread(boost::bind(&CGameHandler::handleConnection,this,pom,boost::ref(*elem))));
 	}
 
 	if(gs->scenarioOps->mode == StartInfo::DUEL)
 	{
 		runBattle();
-		end2 = true;
-
-
-		while(conns.size() && (*conns.begin())->isOpen())
-			boost::this_thread::sleep(boost::posix_time::milliseconds(5)); //give time client to close socket
-
+		endGame();
+		waitForConnectionClose();
 		return;
 	}
 
@@ -1522,18 +1531,29 @@ void CGameHandler::run(bool resume)
 
 				checkVictoryLossConditionsForAll();
 
-				//wait till turn is done
+				//wait till turn is done, cv is notified on end of turn and on end of game
 				boost::unique_lock<boost::mutex> lock(states.mx);
 				while(states.players.at(playerColor).makingTurn && !end2)
-				{
-					static time_duration p = milliseconds(200);
-					states.cv.timed_wait(lock,p);
-				}
+					states.cv.wait(lock);
 			}
 		}
 	}
+	waitForConnectionClose();
+}
+
+void CGameHandler::endGame()
+{
+	boost::unique_lock<boost::mutex> lock(states.mx);
+	end2 = true;
+	states.cv.notify_all();
+}
+
+void CGameHandler::waitForConnectionClose()
+{
+	//give time client to close socket, handleConnection notifies when connection is broken
+	boost::unique_lock<boost::mutex> lock(states.mx);
 	while(conns.size() && (*conns.begin())->isOpen())
-		boost::this_thread::sleep(boost::posix_time::milliseconds(5)); //give time client to close socket
+		states.cv.wait(lock);
 }
 
 std::list<PlayerColor> CGameHandler::generatePlayerTurnOrder() const
@@ -1650,10 +1670,12 @@ bool CGameHandler::moveHero( ObjectInstanceID hid, int3 dst, ui8 teleporting, Pl
 	}
 
 	const TerrainTile t = *gs->getTile(hmpos);
+	// object lists of the tile are live, remember top object before hero enters the tile
+	CGObjectInstance * const topObject = vstd::backOrNull(t.visitableObjects());
 	const int cost = gs->getMovementCost(h, h->getPosition(false), hmpos, h->movement);
 	const int3 guardPos = gs->guardingCreaturePosition(hmpos);
 
-	const bool embarking = !h->boat && !t.visitableObjects.empty() && t.visitableObjects.back()->ID == Obj::BOAT;
+	const bool embarking = !h->boat && !t.visitableObjects().empty() && t.visitableObjects().back()->ID == Obj::BOAT;
 	const bool disembarking = h->boat && t.terType != ETerrainType::WATER && !t.blocked;
 
 	//result structure for start - movement failed, no move points used
@@ -1670,7 +1692,7 @@ bool CGameHandler::moveHero( ObjectInstanceID hid, int3 dst, ui8 teleporting, Pl
 	//OR hero is on land and dest is water and (there is not present only one object - boat)
 	if(((t.terType == ETerrainType::ROCK  ||  (t.blocked && !t.visitable && !h->hasBonusOfType(Bonus::FLYING_MOVEMENT) ))
 			&& complain("Cannot move hero, destination tile is blocked!"))
-		|| ((!h->boat && !h->canWalkOnSea() && t.terType == ETerrainType::WATER && (t.visitableObjects.size() < 1 ||  (t.visitableObjects.back()->ID != Obj::BOAT && t.visitableObjects.back()->ID != Obj::HERO)))  //hero is not on boat/water walking and dst water tile doesn't contain boat/hero (objs visitable from land) -> we test back cause boat may be on top of another object (#276)
+		|| ((!h->boat && !h->canWalkOnSea() && t.terType == ETerrainType::WATER && (t.visitableObjects().size() < 1 ||  (t.visitableObjects().back()->ID != Obj::BOAT && t.visitableObjects().back()->ID != Obj::HERO)))  //hero is not on boat/water walking and dst water tile doesn't contain boat/hero (objs visitable from land) -> we test back cause boat may be on top of another object (#276)
 			&& complain("Cannot move hero, destination tile is on water!"))
 		|| ((h->boat && t.terType != ETerrainType::WATER && t.blocked)
 			&& complain("Cannot disembark hero, tile is blocked!"))
@@ -1693,7 +1715,7 @@ bool CGameHandler::moveHero( ObjectInstanceID hid, int3 dst, ui8 teleporting, Pl
 	// should be called if hero changes tile but before applying TryMoveHero package
 	auto leaveTile = [&]()
 	{
-		for(CGObjectInstance *obj : gs->map->getTile(int3(h->pos.x-1, h->pos.y, h->pos.z)).visitableObjects)
+		for(CGObjectInstance *obj : gs->map->getTile(int3(h->pos.x-1, h->pos.y, h->pos.z)).visitableObjects())
 		{
 			obj->onHeroLeave(h);
 		}
@@ -1719,7 +1741,7 @@ bool CGameHandler::moveHero( ObjectInstanceID hid, int3 dst, ui8 teleporting, Pl
 			tmh.attackedFrom = guardPos;
 
 			const TerrainTile &guardTile = *gs->getTile(guardPos);
-			objectVisited(guardTile.visitableObjects.back(), h);
+			objectVisited(guardTile.visitableObjects().back(), h);
 			
 			moveQuery->visitDestAfterVictory = visitDest==VISIT_DEST;
 		}
@@ -1736,7 +1758,7 @@ bool CGameHandler::moveHero( ObjectInstanceID hid, int3 dst, ui8 teleporting, Pl
 	//interaction with blocking object (like resources)
 	auto blockingVisit = [&]() -> bool
 	{
-		for(CGObjectInstance *obj : t.visitableObjects)
+		for(CGObjectInstance *obj : t.visitableObjects())
 		{
 			if(obj != h  &&  obj->blockVisit  &&  !obj->passableFor(h->tempOwner))
 			{
@@ -1771,11 +1793,8 @@ bool CGameHandler::moveHero( ObjectInstanceID hid, int3 dst, ui8 teleporting, Pl
 		// visit town for town portal \ castle gates
 		// do not use generic visitObjectOnTile to avoid double-teleporting
 		// if this moveHero call was triggered by teleporter
-		if (!t.visitableObjects.empty())
-		{
-			if (CGTownInstance * town = dynamic_cast<CGTownInstance *>(t.visitableObjects.back()))
-				town->onHeroVisit(h);
-		}
+		if (CGTownInstance * town = dynamic_cast<CGTownInstance *>(topObject))
+			town->onHeroVisit(h);
 
 		return true;
 	}
@@ -2251,7 +2270,7 @@ void CGameHandler::close()
 {
     logGlobal->infoStream() << "We have been requested to close.";
 
-	if(gs->initialOpts->mode == StartInfo::DUEL)
+	if(gs->initialOpts->mode == StartInfo::DUEL && !cmdLineOptions.count("keepRunning"))
 	{
 		exit(0);
 	}
@@ -2583,7 +2602,7 @@ bool CGameHandler::recruitCreatures( ObjectInstanceID objid, CreatureID crid, ui
 		||  dw->ID == Obj::REFUGEE_CAMP) //advmap dwelling
 		dst = getHero(gs->getPlayer(dw->tempOwner)->currentSelection); //TODO: check if current hero is really visiting dwelling
 	else if(dw->ID == Obj::WAR_MACHINE_FACTORY)
-		dst = dynamic_cast<const CGHeroInstance *>(getTile(dw->visitablePos())->visitableObjects.back());
+		dst = dynamic_cast<const CGHeroInstance *>(getTile(dw->visitablePos())->visitableObjects().back());
 
 	assert(dw && dst);
 
@@ -3173,7 +3192,7 @@ bool CGameHandler::hireHero(const CGObjectInstance *obj, ui8 hid, PlayerColor pl
 	}
 	else if(obj->ID == Obj::TAVERN)
 	{
-		if(getTile(obj->visitablePos())->visitableObjects.back() != obj  &&  complain("Tavern entry must be unoccupied!"))
+		if(getTile(obj->visitablePos())->visitableObjects().back() != obj  &&  complain("Tavern entry must be unoccupied!"))
 			return false;
 	}
 
@@ -3249,7 +3268,7 @@ bool CGameHandler::queryReply(QueryID qid, ui32 answer, PlayerColor player)
 
 static EndAction end_action;
 
-bool CGameHandler::makeBattleAction( BattleAction &ba )
+bool CGameHandler::makeBattleAction( BattleAction &ba, bool madeByPlayer /*= false*/ )
 {
 	bool ok = true;
 	
@@ -3302,10 +3321,22 @@ bool CGameHandler::makeBattleAction( BattleAction &ba )
 		}
 	}
 
+	if(madeByPlayer)
+		recordBattleAction(ba, false);
 
 	switch(ba.actionType)
 	{
 	case Battle::END_TACTIC_PHASE: //wait
+		{
+			StartAction start_action(ba);
+			{
+				//runBattle checks tacticDistance under this mutex - clear it there as well, so the wake-up below can't be lost
+				boost::unique_lock<boost::mutex> lock(battleMadeAction.mx);
+				sendAndApply(&start_action);
+			}
+			sendAndApply(&end_action);
+			break;
+		}
 	case Battle::BAD_MORALE:
 	case Battle::NO_ACTION:
 		{
@@ -3783,6 +3814,8 @@ bool CGameHandler::makeBattleAction( BattleAction &ba )
 	}
 	if(ba.stackNumber == gs->curB->activeStack  ||  battleResult.get()) //active stack has moved or battle has finished
 		battleMadeAction.setn(true);
+	else if(ba.actionType == Battle::END_TACTIC_PHASE) //wake up runBattle waiting for end of tactic phase
+		battleMadeAction.cond.notify_all();
 	return ok;
 }
 
@@ -4502,6 +4535,8 @@ bool CGameHandler::makeCustomAction( BattleAction &ba )
 					return false;
 				}
 
+				recordBattleAction(ba, true);
+
 				StartAction start_action(ba);
 				sendAndApply(&start_action); //start spell casting
 
@@ -5122,7 +5157,7 @@ void CGameHandler::checkVictoryLossConditionsForPlayer(PlayerColor player)
 
 			if(p->human)
 			{
-				end2 = true;
+				endGame();
 
 				if(gs->scenarioOps->campState)
 				{
@@ -5469,11 +5504,11 @@ bool CGameHandler::castSpell(const CGHeroInstance *h, SpellID spellID, const int
 
 			//TODO: test range, visibility
 			const TerrainTile *t = &gs->map->getTile(pos);
-			if(!t->visitableObjects.size() || t->visitableObjects.back()->ID != Obj::BOAT)
+			if(!t->visitableObjects().size() || t->visitableObjects().back()->ID != Obj::BOAT)
 				COMPLAIN_RET("There is no boat to scuttle!");
 
 			RemoveObject ro;
-			ro.id = t->visitableObjects.back()->id;
+			ro.id = t->visitableObjects().back()->id;
 			sendAndApply(&ro);
 			break;
 		}
@@ -5544,11 +5579,11 @@ bool CGameHandler::castSpell(const CGHeroInstance *h, SpellID spellID, const int
 		{
 			if (!gs->map->isInTheMap(pos))
 				COMPLAIN_RET("Destination tile not present!")
-			TerrainTile tile = gs->map->getTile(pos);
-			if (tile.visitableObjects.empty() || tile.visitableObjects.back()->ID != Obj::TOWN )
+			const TerrainTile & tile = gs->map->getTile(pos);
+			if (tile.visitableObjects().empty() || tile.visitableObjects().back()->ID != Obj::TOWN )
 				COMPLAIN_RET("Town not found for Town Portal!");
 
-			CGTownInstance * town = static_cast<CGTownInstance*>(tile.visitableObjects.back());
+			CGTownInstance * town = static_cast<CGTownInstance*>(tile.visitableObjects().back());
 			if (town->tempOwner != h->tempOwner)
 				COMPLAIN_RET("Can't teleport to another player!");
 			if (town->visitingHero)
@@ -5592,13 +5627,13 @@ bool CGameHandler::castSpell(const CGHeroInstance *h, SpellID spellID, const int
 
 void CGameHandler::visitObjectOnTile(const TerrainTile &t, const CGHeroInstance * h)
 {
-	if (!t.visitableObjects.empty())
+	if (!t.visitableObjects().empty())
 	{
 		//to prevent self-visiting heroes on space press
-		if(t.visitableObjects.back() != h)
-			objectVisited(t.visitableObjects.back(), h);
-		else if(t.visitableObjects.size() > 1)
-			objectVisited(*(t.visitableObjects.end()-2),h);
+		if(t.visitableObjects().back() != h)
+			objectVisited(t.visitableObjects().back(), h);
+		else if(t.visitableObjects().size() > 1)
+			objectVisited(*(t.visitableObjects().end()-2),h);
 	}
 }
 
@@ -5810,12 +5845,23 @@ void CGameHandler::runBattle()
 {
 	setBattle(gs->curB);
 	assert(gs->curB);
+
+	if(battleReplay)
+		srand(battleReplay->seed);
+	else if(cmdLineOptions.count("recordBattles"))
+		startBattleRecording(cmdLineOptions["recordBattles"].as<std::string>());
+
 	//TODO: pre-tactic stuff, call scripts etc.
 
 	//tactic round
 	{
+		if(battleReplay)
+			replayActions([&]{ return gs->curB->tacticDistance && !battleResult.get(); });
+
+		//makeBattleAction notifies when tactic phase is ended or battle result is set
+		boost::unique_lock<boost::mutex> lock(battleMadeAction.mx);
 		while(gs->curB->tacticDistance && !battleResult.get())
-			boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+			battleMadeAction.cond.wait(lock);
 	}
 
 	//spells opening battle
@@ -6004,6 +6050,11 @@ void CGameHandler::runBattle()
 						sendAndApply(&sas);
 						boost::unique_lock<boost::mutex> lock(battleMadeAction.mx);
 						battleMadeAction.data = false;
+						if(battleReplay)
+						{
+							auto unlock = vstd::makeUnlockGuard(battleMadeAction.mx);
+							replayActions([&]{ return next->alive() && !battleMadeAction.get() && !battleResult.get(); });
+						}
 						while (next->alive() && //next is invalid after sacrificing current stack :?
 							(!battleMadeAction.data  &&  !battleResult.get())) //active stack hasn't made its action and battle is still going
 							battleMadeAction.cond.wait(lock);
@@ -6056,9 +6107,94 @@ void CGameHandler::runBattle()
 		}
 	}
 
+	finishBattleRecording();
+	if(battleReplay)
+		return; //there are no clients and queries to end battle for
+
 	endBattle(gs->curB->tile, gs->curB->battleGetFightingHero(0), gs->curB->battleGetFightingHero(1));
 }
 
+const BattleResult * CGameHandler::replayBattle(CBattleReplay & replay)
+{
+	battleReplay = &replay;
+	auto resetReplay = vstd::makeScopeGuard([&]()
+	{
+		battleReplay = nullptr;
+	});
+
+	//only objects taking part in battle are recorded, packs applied during battle look them up by ID
+	gs = new CGameState();
+	gs->map = new CMap();
+	for(CGObjectInstance *obj : replay.getObjects())
+	{
+		const size_t id = obj->id.getNum();
+		if(id >= gs->map->objects.size())
+			gs->map->objects.resize(id + 1);
+		gs->map->objects[id] = obj;
+	}
+
+	battleResult.set(nullptr);
+	gs->curB = replay.battle;
+	gs->curB->localInit();
+	runBattle();
+	return battleResult.get();
+}
+
+void CGameHandler::recordBattleAction(const BattleAction &ba, bool custom)
+{
+	boost::unique_lock<boost::mutex> lock(battleRecorderMx);
+	if(battleRecorder)
+		battleRecorder->recordAction(ba, custom);
+}
+
+void CGameHandler::finishBattleRecording()
+{
+	boost::unique_lock<boost::mutex> lock(battleRecorderMx);
+	if(battleRecorder)
+		battleRecorder->finish(*battleResult.data);
+	battleRecorder.reset();
+}
+
+void CGameHandler::startBattleRecording(const std::string & directory)
+{
+	const int3 tile = gs->curB->tile;
+	const std::string filename = boost::str(boost::format("%s/battle_%d_%d_%d_%d.vbat") % directory % std::time(nullptr) % tile.x % tile.y % tile.z);
+
+	//battle is re-simulated from recorded seed, current rand() state is used only to generate it
+	const ui32 seed = rand();
+	srand(seed);
+
+	try
+	{
+		boost::filesystem::create_directories(directory);
+		boost::shared_lock<boost::shared_mutex> lock(*gs->mx); //don't let packs change state while it's being saved
+		auto recorder = make_unique<CBattleRecorder>(filename, gs->curB.get(), seed);
+
+		boost::unique_lock<boost::mutex> recorderLock(battleRecorderMx);
+		battleRecorder = std::move(recorder);
+		logGlobal->infoStream() << "Recording battle to " << filename;
+	}
+	catch(std::exception &e)
+	{
+		logGlobal->errorStream() << "Failed to start battle recording: " << e.what();
+	}
+}
+
+void CGameHandler::replayActions(std::function<bool()> waitingForAction)
+{
+	while(waitingForAction())
+	{
+		if(!battleReplay->hasNextAction())
+			throw std::runtime_error("Battle replay ended but battle is still going!");
+
+		RecordedBattleAction recorded = battleReplay->nextAction();
+		if(recorded.custom)
+			makeCustomAction(recorded.action);
+		else
+			makeBattleAction(recorded.action);
+	}
+}
+
 bool CGameHandler::makeAutomaticAction(const CStack *stack, BattleAction &ba)
 {
 	BattleSetActiveStack bsa;
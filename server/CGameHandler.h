@@ -35,6 +35,8 @@ struct SetResources;
 struct NewStructures;
 class CGHeroInstance;
 class IMarket;
+class CBattleRecorder;
+class CBattleReplay;
 
 extern std::map<ui32, CFunctionList<void(ui32)> > callbacks; //question id => callback functions - for selection dialogs
 extern boost::mutex gsm;
@@ -105,6 +107,7 @@ public:
 	void giveSpells(const CGTownInstance *t, const CGHeroInstance *h);
 	int moveStack(int stack, BattleHex dest); //returned value - travelled distance
 	void runBattle();
+	const BattleResult * replayBattle(CBattleReplay & replay); //re-simulates recorded battle without clients, returns its result
 
 	////used only in endBattle - don't touch elsewhere
 	bool visitObjectAfterVictory;
@@ -198,7 +201,7 @@ public:
 	PlayerColor getPlayerAt(CConnection *c) const;
 
 	void playerMessage( PlayerColor player, const std::string &message);
-	bool makeBattleAction(BattleAction &ba);
+	bool makeBattleAction(BattleAction &ba, bool madeByPlayer = false); //actions made by players are recorded once they are validated
 	bool makeAutomaticAction(const CStack *stack, BattleAction &ba); //used when action is taken by stack without volition of player (eg. unguided catapult attack)
 	void handleSpellCasting(SpellID spellID, int spellLvl, BattleHex destination, ui8 casterSide, PlayerColor casterColor, const CGHeroInstance * caster, const CGHeroInstance * secHero,
 		int usedSpellPower, ECastingMode::ECastingMode mode, const CStack * stack, si32 selectedStack = -1);
@@ -288,6 +291,17 @@ public:
 
 private:
 	std::list<PlayerColor> generatePlayerTurnOrder() const;
+	void endGame(); //sets end2 and wakes up run() waiting for end of turn
+	void waitForConnectionClose();
+	std::vector<boost::thread *> connectionThreads; //run handleConnection, joined before game handler is destroyed
+
+	boost::mutex battleRecorderMx; //player actions are recorded by connection threads
+	unique_ptr<CBattleRecorder> battleRecorder; //records current battle if enabled by command line
+	CBattleReplay * battleReplay; //battle is replayed instead of waiting for actions from clients
+	void startBattleRecording(const std::string & directory);
+	void recordBattleAction(const BattleAction &ba, bool custom);
+	void finishBattleRecording();
+	void replayActions(std::function<bool()> waitingForAction); //makes recorded actions as long as server waits for action
 	void makeStackDoNothing(const CStack * next);
 	void getVictoryLossMessage(PlayerColor player, EVictoryLossCheckResult victoryLossCheckResult, InfoWindow & out) const;
 
@@ -23,6 +23,7 @@
 #include "../lib/VCMI_Lib.h"
 #include "../lib/VCMIDirs.h"
 #include "CGameHandler.h"
+#include "../lib/BattleReplay.h"
 #include "../lib/mapping/CMapInfo.h"
 #include "../lib/CObjectHandler.h"
 #include "../lib/GameConstants.h"
@@ -393,16 +394,17 @@ void CVCMIServer::start()
 {
 	ServerReady *sr = nullptr;
 	intpr::mapped_region *mr;
+	const std::string sharedMemoryName = SharedMem::getName(boost::lexical_cast<std::string>(port));
 	try
 	{
-		intpr::shared_memory_object smo(intpr::open_only,"vcmi_memory",intpr::read_write);
+		intpr::shared_memory_object smo(intpr::open_only,sharedMemoryName.c_str(),intpr::read_write);
 		smo.truncate(sizeof(ServerReady));
 		mr = new intpr::mapped_region(smo,intpr::read_write);
 		sr = reinterpret_cast<ServerReady*>(mr->get_address());
 	}
 	catch(...)
 	{
-		intpr::shared_memory_object smo(intpr::create_only,"vcmi_memory",intpr::read_write);
+		intpr::shared_memory_object smo(intpr::create_only,sharedMemoryName.c_str(),intpr::read_write);
 		smo.truncate(sizeof(ServerReady));
 		mr = new intpr::mapped_region(smo,intpr::read_write);
 		sr = new(mr->get_address())ServerReady();
@@ -438,6 +440,14 @@ void CVCMIServer::start()
 			return;
 		case 2:
 			newGame();
+			if(cmdLineOptions.count("keepRunning"))
+			{
+				//wait for next game on new connection
+				firstConnection->close();
+				vstd::clear_pointer(firstConnection);
+				end2 = false;
+				return;
+			}
 			break;
 		case 3:
 			loadGame();
@@ -518,7 +528,10 @@ static void handleCommandOptions(int argc, char *argv[])
 		("help,h", "display help and exit")
 		("version,v", "display version information and exit")
 		("port", po::value<int>()->default_value(3030), "port at which server will listen to connections from client")
-		("resultsFile", po::value<std::string>()->default_value("./results.txt"), "file to which the battle result will be appended. Used only in the DUEL mode.");
+		("resultsFile", po::value<std::string>()->default_value("./results.txt"), "file to which the battle result will be appended. Used only in the DUEL mode.")
+		("keepRunning", "don't exit when game ends, wait for next game instead. Used by client to run several duels with one server")
+		("recordBattles", po::value<std::string>(), "directory to which all battles will be recorded")
+		("replayBattle", po::value<std::string>(), "replay recorded battle without clients, compare its result with recorded one and exit");
 
 	if(argc > 1)
 	{
@@ -535,6 +548,39 @@ static void handleCommandOptions(int argc, char *argv[])
 	po::notify(cmdLineOptions);
 }
 
+static int replayBattle(const std::string & filename)
+{
+	try
+	{
+		CGameHandler gh;
+		CBattleReplay replay(filename);
+		logGlobal->infoStream() << "Replaying battle from " << filename;
+
+		auto start = boost::posix_time::microsec_clock::universal_time();
+		const BattleResult * result = gh.replayBattle(replay);
+		auto duration = boost::posix_time::microsec_clock::universal_time() - start;
+
+		if(!result)
+		{
+			logGlobal->errorStream() << "Replayed battle has not ended!";
+			return 1;
+		}
+		logGlobal->infoStream() << "Battle replayed in " << duration.total_milliseconds() << " ms, winner: " << (int)result->winner;
+
+		if(!replay.resultMatches(*result))
+		{
+			logGlobal->errorStream() << "Result of replayed battle differs from recorded one! Recorded winner: " << (int)replay.recordedResult.winner;
+			return 1;
+		}
+		return 0;
+	}
+	catch(std::exception &e)
+	{
+		logGlobal->errorStream() << "Failed to replay battle: " << e.what();
+		return 1;
+	}
+}
+
 #if defined(__GNUC__) && !defined (__MINGW32__)
 void handleLinuxSignal(int sig)
 {
@@ -583,6 +629,14 @@ int main(int argc, char** argv)
 	logNetwork->infoStream() << "Port " << port << " will be used.";
 
 	loadDLLClasses();
+
+	if(cmdLineOptions.count("replayBattle"))
+	{
+		int ret = replayBattle(cmdLineOptions["replayBattle"].as<std::string>());
+		CResourceHandler::clear();
+		return ret;
+	}
+
 	srand ( (ui32)time(nullptr) );
 	try
 	{
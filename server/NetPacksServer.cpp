@@ -161,7 +161,7 @@ bool TradeOnMarketplace::applyGh( CGameHandler *gh )
 	PlayerColor player = market->tempOwner;
 
 	if(player >= PlayerColor::PLAYER_LIMIT)
-		player = gh->getTile(market->visitablePos())->visitableObjects.back()->tempOwner;
+		player = gh->getTile(market->visitablePos())->visitableObjects().back()->tempOwner;
 
 	if(player >= PlayerColor::PLAYER_LIMIT)
 		COMPLAIN_AND_RETURN("No player can use this market!");
@@ -255,7 +255,7 @@ bool MakeAction::applyGh( CGameHandler *gh )
 	else if(gh->connections[b->battleGetStackByID(b->activeStack)->owner] != c) 
 		ERROR_AND_RETURN;
 
-	return gh->makeBattleAction(ba);
+	return gh->makeBattleAction(ba, true);
 }
 
 bool MakeCustomAction::applyGh( CGameHandler *gh )
@@ -0,0 +1,162 @@
+/*
+ * CBattleCacheTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include <boost/test/unit_test.hpp>
+
+#include "CTestBattle.h"
+#include "../lib/BattleState.h"
+
+namespace
+{
+	/// Test battle whose caches are compared with uncached calculations
+	struct CachedBattle : public CTestBattle
+	{
+		/// called after every change, like for netpacks applied during battle
+		void changed()
+		{
+			battle->stateChanged();
+			check();
+			//second call reads values stored by first one
+			check();
+		}
+
+		void check() const
+		{
+			checkStackQueue();
+			checkAccessibility();
+			checkReachability();
+			checkDamage();
+		}
+
+		void checkStackQueue() const
+		{
+			for(int turn = -1; turn <= 0; turn++)
+			{
+				for(int howMany = 3; howMany <= 10; howMany += 7)
+				{
+					std::vector<const CStack *> cached, expected;
+					battle->battleGetStackQueue(cached, howMany, turn);
+					battle->calculateStackQueue(expected, howMany, turn, -1);
+					BOOST_CHECK_EQUAL_COLLECTIONS(cached.begin(), cached.end(), expected.begin(), expected.end());
+				}
+			}
+		}
+
+		void checkAccessibility() const
+		{
+			const AccessibilityInfo cached = battle->getAccesibility();
+			const AccessibilityInfo expected = battle->calculateAccesibility();
+			BOOST_CHECK_EQUAL_COLLECTIONS(cached.begin(), cached.end(), expected.begin(), expected.end());
+		}
+
+		void checkReachability() const
+		{
+			for(const CStack *s : battle->battleGetAllStacks())
+			{
+				const ReachabilityInfo::Parameters params(s);
+				auto accessibility = battle->calculateAccesibility();
+				for(auto hex : params.knownAccessible)
+					if(hex.isValid())
+						accessibility[hex] = EAccessibility::ACCESSIBLE;
+
+				const ReachabilityInfo cached = battle->getReachability(s);
+				const ReachabilityInfo expected = battle->getReachability(accessibility, params);
+				BOOST_CHECK_EQUAL_COLLECTIONS(cached.distances.begin(), cached.distances.end(), expected.distances.begin(), expected.distances.end());
+				BOOST_CHECK_EQUAL_COLLECTIONS(cached.predecessors.begin(), cached.predecessors.end(), expected.predecessors.begin(), expected.predecessors.end());
+			}
+		}
+
+		void checkDamage() const
+		{
+			for(const CStack *attacker : battle->battleGetAllStacks())
+			{
+				for(const CStack *defender : battle->battleGetAllStacks())
+				{
+					if(attacker->attackerOwned == defender->attackerOwned)
+						continue;
+
+					for(int shooting = 0; shooting < 2; shooting++)
+					{
+						const BattleAttackInfo info(attacker, defender, shooting == 1);
+						const TDmgRange cached = battle->calculateDmgRange(info);
+						const TDmgRange expected = battle->calculateDmgRange(info, battle->calculateDmgFactors(info));
+						BOOST_CHECK_EQUAL(cached.first, expected.first);
+						BOOST_CHECK_EQUAL(cached.second, expected.second);
+					}
+				}
+			}
+		}
+	};
+}
+
+BOOST_AUTO_TEST_CASE(BattleStateCache_Version)
+{
+	BattleStateCache<int, int> cache;
+	int calculations = 0;
+	auto calculate = [&]{ return ++calculations; };
+
+	BOOST_CHECK_EQUAL(cache.get(1, 5, calculate), 1);
+	BOOST_CHECK_EQUAL(cache.get(1, 5, calculate), 1);
+	BOOST_CHECK_EQUAL(cache.get(1, 6, calculate), 2);
+	BOOST_CHECK_EQUAL(calculations, 2);
+
+	//all values are dropped when version changes
+	BOOST_CHECK_EQUAL(cache.get(2, 6, calculate), 3);
+	BOOST_CHECK_EQUAL(cache.get(2, 5, calculate), 4);
+	BOOST_CHECK_EQUAL(cache.get(2, 6, calculate), 3);
+	BOOST_CHECK_EQUAL(calculations, 4);
+}
+
+BOOST_AUTO_TEST_CASE(BattleCaches_MatchUncachedResults)
+{
+	try
+	{
+		CachedBattle b;
+		b.changed();
+
+		//stack moves next to enemy
+		CStack *cavaliers = b.stack(0, 2);
+		cavaliers->position = b.stack(1, 0)->position + BattleHex::LEFT;
+		b.changed();
+
+		//active stack has moved, other one waits
+		cavaliers->state.insert(EBattleStackState::MOVED);
+		b.battle->activeStack = b.stack(1, 1)->ID;
+		b.stack(1, 1)->state.insert(EBattleStackState::WAITING);
+		b.changed();
+
+		//bonuses of attacker and defender change
+		b.stack(0, 1)->addNewBonus(new Bonus(Bonus::ONE_BATTLE, Bonus::PRIMARY_SKILL, Bonus::OTHER, 10, -1, PrimarySkill::ATTACK));
+		b.stack(1, 2)->addNewBonus(new Bonus(Bonus::ONE_BATTLE, Bonus::PRIMARY_SKILL, Bonus::OTHER, 5, -1, PrimarySkill::DEFENSE));
+		b.changed();
+
+		//stack dies and frees its hexes
+		CStack *goblins = b.stack(1, 0);
+		goblins->count = 0;
+		goblins->state.erase(EBattleStackState::ALIVE);
+		b.changed();
+
+		//new round
+		b.battle->round++;
+		for(CStack *s : b.battle->stacks)
+		{
+			s->state.erase(EBattleStackState::MOVED);
+			s->state.erase(EBattleStackState::WAITING);
+		}
+		b.battle->activeStack = b.stack(0, 0)->ID;
+		b.changed();
+	}
+	catch(const std::exception & e)
+	{
+		logGlobal->errorStream() << e.what();
+		BOOST_ERROR(e.what());
+	}
+}
@@ -0,0 +1,120 @@
+/*
+ * CBattleHexTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include <boost/test/unit_test.hpp>
+
+#include "../lib/BattleHex.h"
+
+namespace
+{
+	/// neighbours computed the way BattleHex did before the tables were introduced
+	std::vector<BattleHex> referenceNeighbouringTiles(si16 hex)
+	{
+		std::vector<BattleHex> ret;
+		const int WN = GameConstants::BFIELD_WIDTH;
+		BattleHex::checkAndPush(hex - ( (hex/WN)%2 ? WN+1 : WN ), ret);
+		BattleHex::checkAndPush(hex + 1, ret);
+		BattleHex::checkAndPush(hex + ( (hex/WN)%2 ? WN : WN+1 ), ret);
+		BattleHex::checkAndPush(hex + ( (hex/WN)%2 ? WN-1 : WN ), ret);
+		BattleHex::checkAndPush(hex - 1, ret);
+		BattleHex::checkAndPush(hex - ( (hex/WN)%2 ? WN : WN-1 ), ret);
+		return ret;
+	}
+
+	int referenceDistance(BattleHex hex1, BattleHex hex2)
+	{
+		int y1 = hex1.getY(),
+			y2 = hex2.getY();
+
+		int x1 = hex1.getX() + y1 / 2.0,
+			x2 = hex2.getX() + y2 / 2.0;
+
+		int xDst = x2 - x1,
+			yDst = y2 - y1;
+
+		if ((xDst >= 0 && yDst >= 0) || (xDst < 0 && yDst < 0))
+			return std::max(std::abs(xDst), std::abs(yDst));
+		else
+			return std::abs(xDst) + std::abs(yDst);
+	}
+
+	template<size_t N>
+	void checkAllNeighbouringTiles(si16 hex, const si16 (&expected)[N])
+	{
+		std::vector<si16> tiles(BattleHex(hex).getAllNeighbouringTiles().begin(), BattleHex(hex).getAllNeighbouringTiles().end());
+		boost::sort(tiles);
+		BOOST_CHECK_EQUAL_COLLECTIONS(tiles.begin(), tiles.end(), expected, expected + N);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(BattleHex_NeighbouringTiles)
+{
+	for(si16 i = 0; i < GameConstants::BFIELD_SIZE; i++)
+	{
+		const BattleHex hex(i);
+		const auto expected = referenceNeighbouringTiles(i);
+
+		const BattleHex::NeighbouringTiles & tiles = hex.getNeighbouringTiles();
+		BOOST_CHECK_EQUAL_COLLECTIONS(tiles.begin(), tiles.end(), expected.begin(), expected.end());
+
+		const auto allocated = hex.neighbouringTiles();
+		BOOST_CHECK_EQUAL_COLLECTIONS(allocated.begin(), allocated.end(), expected.begin(), expected.end());
+	}
+
+	BOOST_CHECK(BattleHex().getNeighbouringTiles().begin() == BattleHex().getNeighbouringTiles().end());
+}
+
+BOOST_AUTO_TEST_CASE(BattleHex_AllNeighbouringTiles)
+{
+	//middle of battlefield
+	const si16 middle[] = {75, 76, 92, 94, 109, 110};
+	checkAllNeighbouringTiles(93, middle);
+
+	//even rows are shifted right
+	const si16 evenRow[] = {19, 20, 35, 37, 53, 54};
+	checkAllNeighbouringTiles(36, evenRow);
+
+	//odd rows are shifted left
+	const si16 oddRow[] = {36, 37, 53, 55, 70, 71};
+	checkAllNeighbouringTiles(54, oddRow);
+
+	//side columns are included, they can be occupied by second hex of two-hex stack
+	const si16 nextToLeftColumn[] = {0, 1, 17, 19, 34, 35};
+	checkAllNeighbouringTiles(18, nextToLeftColumn);
+	const si16 nextToRightColumn[] = {32, 33, 48, 50, 66, 67};
+	checkAllNeighbouringTiles(49, nextToRightColumn);
+
+	//hexes at left and right border have no neighbours in other rows at opposite border
+	const si16 leftEdgeOddRow[] = {0, 18, 34};
+	checkAllNeighbouringTiles(17, leftEdgeOddRow);
+	const si16 leftEdgeEvenRow[] = {17, 18, 35, 51, 52};
+	checkAllNeighbouringTiles(34, leftEdgeEvenRow);
+	const si16 rightEdgeOddRow[] = {15, 16, 32, 49, 50};
+	checkAllNeighbouringTiles(33, rightEdgeOddRow);
+	const si16 rightEdgeEvenRow[] = {33, 49, 67};
+	checkAllNeighbouringTiles(50, rightEdgeEvenRow);
+
+	const si16 corner[] = {1, 17, 18};
+	checkAllNeighbouringTiles(0, corner);
+
+	BOOST_CHECK(BattleHex().getAllNeighbouringTiles().begin() == BattleHex().getAllNeighbouringTiles().end());
+}
+
+BOOST_AUTO_TEST_CASE(BattleHex_Distance)
+{
+	for(si16 i = 0; i < GameConstants::BFIELD_SIZE; i++)
+	{
+		for(si16 j = 0; j < GameConstants::BFIELD_SIZE; j++)
+		{
+			BOOST_CHECK_EQUAL(static_cast<int>(BattleHex::getDistance(i, j)), referenceDistance(i, j));
+		}
+	}
+}
@@ -0,0 +1,164 @@
+/*
+ * CBattleReplayTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include <boost/test/unit_test.hpp>
+
+#include "CTestBattle.h"
+#include "../lib/BattleReplay.h"
+#include "../lib/BattleState.h"
+#include "../lib/CObjectHandler.h"
+#include "../lib/VCMIDirs.h"
+#include "../lib/ScopeGuard.h"
+#include "../server/CGameHandler.h"
+
+//defined by server executable, read by game handler
+bool end2 = false;
+boost::program_options::variables_map cmdLineOptions;
+
+namespace
+{
+	/// deletes stacks of battle loaded by replay and detaches armies from it, so that battle can be deleted
+	void releaseLoadedBattle(CBattleReplay & replay)
+	{
+		BattleInfo *battle = replay.battle;
+		for(CStack *s : battle->stacks)
+			delete s;
+		battle->stacks.clear();
+		for(int side = 0; side < 2; side++)
+			battle->battleGetArmyObject(side)->detachFrom(battle);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(BattleReplay_RecordAndLoad)
+{
+	const std::string filename = VCMIDirs::get().userCachePath() + "/VCMI_Test_battle.vbat";
+	std::vector<CGObjectInstance *> loadedObjects;
+	try
+	{
+		//bonus from node that is not part of battle, like player state - it has to be recorded with army
+		CBonusSystemNode player;
+		player.addNewBonus(new Bonus(Bonus::PERMANENT, Bonus::PRIMARY_SKILL, Bonus::OTHER, 3, -1, PrimarySkill::ATTACK));
+
+		CTestBattle b;
+		b.armies[0]->attachTo(&player);
+
+		const BattleAction action = BattleAction::makeDefend(b.stack(0, 0));
+		BattleResult result;
+		result.result = BattleResult::NORMAL;
+		result.winner = 1;
+		result.casualties[0][0] = 20;
+		{
+			CBattleRecorder recorder(filename, b.battle, 1234);
+			recorder.recordAction(action, false);
+			recorder.finish(result);
+		}
+
+		{
+			CBattleReplay replay(filename);
+			loadedObjects = replay.getObjects();
+			BOOST_CHECK_EQUAL(replay.seed, 1234);
+			BOOST_CHECK(replay.resultMatches(result));
+
+			BOOST_REQUIRE(replay.hasNextAction());
+			const RecordedBattleAction & recorded = replay.nextAction();
+			BOOST_CHECK(!recorded.custom);
+			BOOST_CHECK_EQUAL(recorded.action.actionType, action.actionType);
+			BOOST_CHECK_EQUAL(recorded.action.stackNumber, action.stackNumber);
+			BOOST_CHECK(!replay.hasNextAction());
+
+			BattleInfo *battle = replay.battle;
+			battle->localInit();
+			BOOST_REQUIRE_EQUAL(battle->stacks.size(), b.battle->stacks.size());
+			for(size_t i = 0; i < battle->stacks.size(); i++)
+			{
+				const CStack *loaded = battle->stacks[i], *original = b.battle->stacks[i];
+				BOOST_CHECK_EQUAL(loaded->ID, original->ID);
+				BOOST_CHECK(loaded->type == original->type);
+				BOOST_CHECK_EQUAL(loaded->count, original->count);
+				BOOST_CHECK_EQUAL(loaded->position, original->position);
+				BOOST_CHECK_EQUAL(loaded->attackerOwned, original->attackerOwned);
+				BOOST_CHECK_EQUAL(loaded->Attack(), original->Attack());
+				BOOST_CHECK_EQUAL(loaded->Defense(), original->Defense());
+				BOOST_CHECK_EQUAL(loaded->MaxHealth(), original->MaxHealth());
+				BOOST_CHECK_EQUAL(loaded->Speed(), original->Speed());
+			}
+
+			releaseLoadedBattle(replay);
+			delete battle;
+		}
+
+		b.armies[0]->detachFrom(&player);
+	}
+	catch(const std::exception & e)
+	{
+		logGlobal->errorStream() << e.what();
+		BOOST_ERROR(e.what());
+	}
+	//armies are detached from recorded bonuses when replay is destroyed
+	for(auto obj : loadedObjects)
+		delete obj;
+	boost::filesystem::remove(filename);
+}
+
+BOOST_AUTO_TEST_CASE(BattleReplay_ReplayMatchesRecordedResult)
+{
+	const std::string filename = VCMIDirs::get().userCachePath() + "/VCMI_Test_replay.vbat";
+	std::vector<CGObjectInstance *> loadedObjects;
+	try
+	{
+		//archers kill single goblin with first shot, whichever stack moves first
+		CTestBattle b(CreatureID(2), 200, CreatureID(84), 1);
+		const CStack *archers = b.stack(0, 0), *goblin = b.stack(1, 0);
+
+		BattleResult expected;
+		expected.result = BattleResult::NORMAL;
+		expected.winner = 0;
+		expected.casualties[1][goblin->getCreature()->idNumber] = 1;
+		{
+			//actions of stack that is not active are rejected and next one is used
+			CBattleRecorder recorder(filename, b.battle, 1234);
+			recorder.recordAction(BattleAction::makeShotAttack(archers, goblin), false);
+			recorder.recordAction(BattleAction::makeDefend(goblin), false);
+			recorder.recordAction(BattleAction::makeShotAttack(archers, goblin), false);
+			recorder.finish(expected);
+		}
+
+		CBattleReplay replay(filename);
+		loadedObjects = replay.getObjects();
+		{
+			CGameHandler gh; //owns replayed battle
+			auto releaseBattle = vstd::makeScopeGuard([&]
+			{
+				releaseLoadedBattle(replay);
+			});
+
+			const BattleResult *result = gh.replayBattle(replay);
+			BOOST_REQUIRE(result);
+			BOOST_CHECK(replay.resultMatches(*result));
+			BOOST_CHECK_EQUAL(result->winner, expected.winner);
+			BOOST_CHECK(result->casualties[0].empty());
+			BOOST_CHECK(result->casualties[1] == expected.casualties[1]);
+
+			//result that differs from recorded one is detected
+			BattleResult other = *result;
+			other.winner = 1;
+			BOOST_CHECK(!replay.resultMatches(other));
+		}
+	}
+	catch(const std::exception & e)
+	{
+		logGlobal->errorStream() << e.what();
+		BOOST_ERROR(e.what());
+	}
+	for(auto obj : loadedObjects)
+		delete obj;
+	boost::filesystem::remove(filename);
+}
@@ -0,0 +1,111 @@
+/*
+ * CMapFormatTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include <boost/test/unit_test.hpp>
+
+#include "../lib/mapping/CMapService.h"
+#include "../lib/mapping/CMap.h"
+#include "../lib/mapping/MapFormatBinary.h"
+#include "../lib/filesystem/Filesystem.h"
+#include "../lib/filesystem/CFilesystemLoader.h"
+#include "../lib/filesystem/AdapterLoaders.h"
+#include "../lib/filesystem/CMemoryStream.h"
+#include "../lib/CObjectHandler.h"
+#include "../lib/CTownHandler.h"
+#include "../lib/VCMI_Lib.h"
+
+static void addTestMapLoader()
+{
+	if(!CResourceHandler::get()->existsResource(ResourceID("test/TerrainViewTest", EResType::MAP)))
+		dynamic_cast<CFilesystemList*>(CResourceHandler::get())->addLoader(new CFilesystemLoader("test/", "."), false);
+}
+
+BOOST_AUTO_TEST_CASE(MapFormatBinary_SaveLoad)
+{
+	try
+	{
+		addTestMapLoader();
+		auto originalMap = CMapService::loadMap("test/TerrainViewTest");
+
+		// test map has no towns - add one, its town type must be restored as handler object, not as copy
+		const CTown * townType = VLC->townh->factions[0]->town;
+		auto town = new CGTownInstance();
+		town->ID = Obj::TOWN;
+		town->subID = 0;
+		town->town = townType;
+		town->pos = int3(5, 5, 0);
+		town->id = ObjectInstanceID(originalMap->objects.size());
+		originalMap->objects.push_back(town);
+		originalMap->towns.push_back(town);
+		originalMap->addBlockVisTiles(town);
+
+		std::ostringstream out;
+		CMapSaverBinary(out).saveMap(*originalMap);
+		const std::string data = out.str();
+
+		CMemoryStream stream(reinterpret_cast<const ui8 *>(data.data()), data.size());
+		auto map = CMapLoaderBinary(&stream).loadMap();
+
+		BOOST_CHECK_EQUAL(map->name, originalMap->name);
+		BOOST_CHECK_EQUAL(map->description, originalMap->description);
+		BOOST_CHECK_EQUAL(map->version, originalMap->version);
+		BOOST_REQUIRE_EQUAL(map->width, originalMap->width);
+		BOOST_REQUIRE_EQUAL(map->height, originalMap->height);
+		BOOST_REQUIRE_EQUAL(map->twoLevel, originalMap->twoLevel);
+
+		for(int z = 0; z < (map->twoLevel ? 2 : 1); z++)
+		{
+			for(int y = 0; y < map->height; y++)
+			{
+				for(int x = 0; x < map->width; x++)
+				{
+					const int3 pos(x, y, z);
+					const TerrainTile & tile = map->getTile(pos);
+					const TerrainTile & originalTile = originalMap->getTile(pos);
+					BOOST_CHECK(tile.terType == originalTile.terType);
+					BOOST_CHECK_EQUAL(tile.terView, originalTile.terView);
+					BOOST_CHECK(tile.riverType == originalTile.riverType);
+					BOOST_CHECK_EQUAL(tile.riverDir, originalTile.riverDir);
+					BOOST_CHECK(tile.roadType == originalTile.roadType);
+					BOOST_CHECK_EQUAL(tile.roadDir, originalTile.roadDir);
+					BOOST_CHECK_EQUAL(tile.extTileFlags, originalTile.extTileFlags);
+					BOOST_CHECK_EQUAL(tile.visitable, originalTile.visitable);
+					BOOST_CHECK_EQUAL(tile.blocked, originalTile.blocked);
+					BOOST_CHECK_EQUAL(tile.visitableObjects().size(), originalTile.visitableObjects().size());
+					BOOST_CHECK_EQUAL(tile.blockingObjects().size(), originalTile.blockingObjects().size());
+				}
+			}
+		}
+
+		BOOST_REQUIRE_EQUAL(map->objects.size(), originalMap->objects.size());
+		for(size_t i = 0; i < map->objects.size(); i++)
+		{
+			BOOST_CHECK(map->objects[i]->ID == originalMap->objects[i]->ID);
+			BOOST_CHECK_EQUAL(map->objects[i]->subID, originalMap->objects[i]->subID);
+			BOOST_CHECK(map->objects[i]->pos == originalMap->objects[i]->pos);
+		}
+
+		BOOST_REQUIRE_EQUAL(map->towns.size(), 1);
+		BOOST_CHECK(map->towns[0]->town == townType);
+		BOOST_CHECK(map->towns[0].get() == map->objects.back().get());
+
+		// header alone can be loaded without the rest of the map
+		CMemoryStream headerStream(reinterpret_cast<const ui8 *>(data.data()), data.size());
+		auto header = CMapLoaderBinary(&headerStream).loadMapHeader();
+		BOOST_CHECK_EQUAL(header->name, originalMap->name);
+		BOOST_CHECK_EQUAL(header->width, originalMap->width);
+	}
+	catch(const std::exception & e)
+	{
+		logGlobal->errorStream() << e.what();
+		BOOST_ERROR(e.what());
+	}
+}
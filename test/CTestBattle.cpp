@@ -0,0 +1,77 @@
+/*
+ * CTestBattle.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "CTestBattle.h"
+#include <boost/test/unit_test.hpp>
+
+#include "../lib/BattleState.h"
+#include "../lib/CObjectHandler.h"
+
+CTestBattle::CTestBattle()
+{
+	createArmies();
+	armies[0]->setCreature(SlotID(0), CreatureID(0), 20); //pikemen
+	armies[0]->setCreature(SlotID(1), CreatureID(2), 10); //archers - shooter
+	armies[0]->setCreature(SlotID(2), CreatureID(10), 2); //cavaliers - two-hex stack
+	armies[1]->setCreature(SlotID(0), CreatureID(84), 30); //goblins
+	armies[1]->setCreature(SlotID(1), CreatureID(86), 10); //wolf riders - two-hex stack
+	armies[1]->setCreature(SlotID(2), CreatureID(88), 8); //orcs - shooter
+	setupBattle();
+}
+
+CTestBattle::CTestBattle(CreatureID attacker, int attackerCount, CreatureID defender, int defenderCount)
+{
+	createArmies();
+	armies[0]->setCreature(SlotID(0), attacker, attackerCount);
+	armies[1]->setCreature(SlotID(0), defender, defenderCount);
+	setupBattle();
+}
+
+void CTestBattle::createArmies()
+{
+	for(int side = 0; side < 2; side++)
+	{
+		armies[side] = new CArmedInstance();
+		armies[side]->tempOwner = PlayerColor(side);
+		armies[side]->id = ObjectInstanceID(side); //replayed battles look up armies by ID
+	}
+}
+
+void CTestBattle::setupBattle()
+{
+	const CArmedInstance *sides[2] = {armies[0], armies[1]};
+	const CGHeroInstance *heroes[2] = {nullptr, nullptr};
+	battle = BattleInfo::setupBattle(int3(), ETerrainType::GRASS, BFieldType::GRASS_HILLS, sides, heroes, false, nullptr);
+	battle->localInit();
+	battle->round = 1;
+	battle->activeStack = battle->stacks.front()->ID;
+}
+
+CTestBattle::~CTestBattle()
+{
+	for(CStack *s : battle->stacks)
+		delete s;
+	for(auto army : armies)
+		army->detachFrom(battle);
+	delete battle;
+	for(auto army : armies)
+		delete army;
+}
+
+CStack * CTestBattle::stack(int side, int slot) const
+{
+	for(CStack *s : battle->stacks)
+		if(s->attackerOwned == !side && s->slot == SlotID(slot))
+			return s;
+
+	BOOST_FAIL("No stack in slot " << slot << " of side " << side);
+	return nullptr;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+ * CTestBattle.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "../lib/GameConstants.h"
+
+class CArmedInstance;
+class CStack;
+struct BattleInfo;
+
+/// Battle between two armies without heroes, by default each of them has normal, shooting and two-hex stack
+class CTestBattle
+{
+public:
+	CArmedInstance *armies[2];
+	BattleInfo *battle;
+
+	CTestBattle();
+	CTestBattle(CreatureID attacker, int attackerCount, CreatureID defender, int defenderCount); //single stack on each side
+	~CTestBattle();
+
+	CStack * stack(int side, int slot) const; //fails test if there is no such stack
+
+private:
+	void createArmies();
+	void setupBattle();
+};